@@ -0,0 +1,536 @@
+/**
+ * @file load_generator.cpp
+ * @brief This file contains a multi-threaded, epoll based HTTP/1.1 load generator.
+ * @details Each worker thread owns an epoll instance and a share of the connections.
+ * Requests are drawn from a URL mix (by default every file under the web root) and
+ * latencies are reported as JSON so runs can be compared by scripts.
+ * 
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Linux Documentation================================
+// https://man7.org/linux/man-pages/man7/epoll.7.html |
+// https://man7.org/linux/man-pages/man3/nftw.3.html  |
+// ====================================================
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief The BenchConfig struct contains the load generator settings.
+     */
+    struct BenchConfig {
+        std::string host = "127.0.0.1";
+        int port = 60001;
+        int connections = 64;
+        int threads = 4;
+        int durationSec = 10;
+        int pipeline = 1;
+        bool keepAlive = true;
+        std::string root = "./www";
+        std::vector<std::string> urls;
+        int timeoutMs = 2000;
+    };
+
+    /**
+     * @brief Per-thread results, merged at the end of the run.
+     */
+    struct ThreadStats {
+        uint64_t requests = 0;
+        uint64_t errors = 0;
+        uint64_t timeouts = 0;
+        uint64_t dropped = 0;
+        uint64_t connects = 0;
+        uint64_t bytes = 0;
+        uint64_t non2xx = 0;
+        std::vector<uint32_t> latenciesUs;
+    };
+
+    /**
+     * @brief The state of one client connection.
+     */
+    struct Connection {
+        int fd = -1;
+        bool connecting = false;
+        std::string out;                     // Bytes not yet written
+        size_t outOffset = 0;
+        std::string in;                      // Bytes read but not yet parsed
+        std::deque<Clock::time_point> sent;  // Send time of each outstanding request
+        Clock::time_point lastActivity;
+    };
+
+    std::atomic<bool> running{true};
+    std::vector<std::string> collectedUrls;
+    std::string collectRoot;
+
+    /**
+     * @brief nftw() callback that records each regular file as a URL.
+     */
+    int collectFile(const char* path, const struct stat* sb, int typeflag, struct FTW*) {
+        (void)sb;
+        if(typeflag != FTW_F) return 0;
+        std::string_view p(path);
+        p.remove_prefix(std::min(p.size(), collectRoot.size()));
+        std::string url(p);
+        if(url.empty() || url.front() != '/') url.insert(url.begin(), '/');
+        collectedUrls.push_back(url);
+        return 0;
+    }
+
+    /**
+     * @brief Prints the usage message.
+     */
+    void printUsage(const char* program) {
+        std::cerr
+            << "Usage: " << program << " [options]\n"
+            << "  -H, --host <addr>         Server IPv4 address (default 127.0.0.1)\n"
+            << "  -p, --port <port>         Server port (default 60001)\n"
+            << "  -c, --connections <n>     Concurrent connections (default 64)\n"
+            << "  -t, --threads <n>         Worker threads (default 4)\n"
+            << "  -d, --duration <sec>      Test duration in seconds (default 10)\n"
+            << "  -P, --pipeline <n>        Requests in flight per connection (default 1)\n"
+            << "  -n, --no-keep-alive       Open a new connection for every request\n"
+            << "  -r, --root <dir>          Build the URL mix from the files in <dir> (default ./www)\n"
+            << "  -u, --url <path>          Request <path> (repeatable, overrides --root)\n"
+            << "  -T, --timeout <ms>        Per-request timeout (default 2000)\n";
+    }
+
+    /**
+     * @brief Parses the command line into a BenchConfig.
+     * @throws std::invalid_argument on bad input.
+     */
+    BenchConfig parseArgs(int argc, char* argv[]) {
+        BenchConfig config;
+        static struct option long_options[] = {
+            {"host",          required_argument, 0, 'H'},
+            {"port",          required_argument, 0, 'p'},
+            {"connections",   required_argument, 0, 'c'},
+            {"threads",       required_argument, 0, 't'},
+            {"duration",      required_argument, 0, 'd'},
+            {"pipeline",      required_argument, 0, 'P'},
+            {"no-keep-alive", no_argument,       0, 'n'},
+            {"root",          required_argument, 0, 'r'},
+            {"url",           required_argument, 0, 'u'},
+            {"timeout",       required_argument, 0, 'T'},
+            {"help",          no_argument,       0, 'h'},
+            {0,               0,                 0,  0 }
+        };
+
+        int opt, option_index;
+        while((opt = getopt_long(argc, argv, "H:p:c:t:d:P:nr:u:T:h", long_options, &option_index)) != -1) {
+            switch(opt) {
+                case 'H': config.host = optarg;                     break;
+                case 'p': config.port = std::stoi(optarg);          break;
+                case 'c': config.connections = std::stoi(optarg);   break;
+                case 't': config.threads = std::stoi(optarg);       break;
+                case 'd': config.durationSec = std::stoi(optarg);   break;
+                case 'P': config.pipeline = std::stoi(optarg);      break;
+                case 'n': config.keepAlive = false;                 break;
+                case 'r': config.root = optarg;                     break;
+                case 'u': config.urls.push_back(optarg);            break;
+                case 'T': config.timeoutMs = std::stoi(optarg);     break;
+                case 'h': printUsage(argv[0]); std::exit(EXIT_SUCCESS);
+                default:  printUsage(argv[0]); std::exit(EXIT_FAILURE);
+            }
+        }
+
+        if(config.connections < 1 || config.threads < 1 || config.durationSec < 1 || config.pipeline < 1) {
+            throw std::invalid_argument("connections, threads, duration and pipeline must be at least 1.");
+        }
+        config.threads = std::min(config.threads, config.connections);
+        if(!config.keepAlive) config.pipeline = 1;
+
+        if(config.urls.empty()) {
+            collectRoot = config.root;
+            while(collectRoot.size() > 1 && collectRoot.back() == '/') collectRoot.pop_back();
+            if(nftw(collectRoot.c_str(), collectFile, 16, FTW_PHYS) != 0) {
+                throw std::invalid_argument("Failed to walk root directory: " + config.root);
+            }
+            config.urls = std::move(collectedUrls);
+            config.urls.push_back("/");
+        }
+        if(config.urls.empty()) {
+            throw std::invalid_argument("No URLs to request.");
+        }
+        return config;
+    }
+
+    /**
+     * @brief The Worker class drives a share of the connections on its own epoll instance.
+     */
+    class Worker {
+    public:
+        Worker(const BenchConfig& config, int connectionCount, unsigned seed)
+            : config(config), connections(connectionCount), rng(seed), pick(0, config.urls.size() - 1) {
+            epoll_fd = epoll_create1(0);
+            if(epoll_fd < 0) throw std::runtime_error("epoll_create1 failed: " + std::string(std::strerror(errno)));
+
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(config.port);
+            if(inet_pton(AF_INET, config.host.c_str(), &addr.sin_addr) != 1) {
+                throw std::invalid_argument("Invalid host address: " + config.host);
+            }
+
+            // Pre-build one request per URL so the hot loop only appends bytes
+            for(const auto& url : config.urls) {
+                requests.push_back("GET " + url + " HTTP/1.1\r\nHost: " + config.host +
+                    "\r\nConnection: " + (config.keepAlive ? "keep-alive" : "close") + "\r\n\r\n");
+            }
+        }
+
+        ~Worker() {
+            for(auto& conn : connections) closeConnection(conn);
+            close(epoll_fd);
+        }
+
+        void run(Clock::time_point deadline) {
+            for(size_t i = 0; i < connections.size(); ++i) openConnection(i);
+
+            std::vector<epoll_event> events(256);
+            while(running && Clock::now() < deadline) {
+                int count = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), 50);
+                if(count < 0) {
+                    if(errno == EINTR) continue;
+                    throw std::runtime_error("epoll_wait failed: " + std::string(std::strerror(errno)));
+                }
+                for(int i = 0; i < count; ++i) {
+                    size_t index = events[i].data.u64;
+                    Connection& conn = connections[index];
+                    if(events[i].events & (EPOLLERR | EPOLLHUP)) {
+                        if(!(events[i].events & EPOLLIN)) {
+                            fail(index, false);
+                            continue;
+                        }
+                    }
+                    if(events[i].events & EPOLLOUT) onWritable(index);
+                    if(conn.fd >= 0 && (events[i].events & EPOLLIN)) onReadable(index);
+                }
+                checkTimeouts();
+            }
+        }
+
+        ThreadStats stats;
+
+    private:
+        const BenchConfig& config;
+        std::vector<Connection> connections;
+        std::vector<std::string> requests;
+        std::mt19937 rng;
+        std::uniform_int_distribution<size_t> pick;
+        struct sockaddr_in addr{};
+        int epoll_fd = -1;
+
+        void openConnection(size_t index) {
+            Connection& conn = connections[index];
+            conn = Connection{};
+            conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            if(conn.fd < 0) throw std::runtime_error("socket failed: " + std::string(std::strerror(errno)));
+
+            int one = 1;
+            setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            int ret = connect(conn.fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+            if(ret < 0 && errno != EINPROGRESS) {
+                stats.errors++;
+                close(conn.fd);
+                conn.fd = -1;
+                return;
+            }
+            conn.connecting = (ret < 0);
+            conn.lastActivity = Clock::now();
+            stats.connects++;
+
+            struct epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT;
+            ev.data.u64 = index;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, conn.fd, &ev);
+
+            fillPipeline(conn);
+        }
+
+        void closeConnection(Connection& conn) {
+            if(conn.fd < 0) return;
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn.fd, nullptr);
+            close(conn.fd);
+            conn.fd = -1;
+        }
+
+        void fail(size_t index, bool timedOut) {
+            Connection& conn = connections[index];
+            if(timedOut) stats.timeouts += conn.sent.size();
+            else if(!conn.sent.empty()) stats.errors++;
+            closeConnection(conn);
+            if(running) openConnection(index);
+        }
+
+        void fillPipeline(Connection& conn) {
+            while(static_cast<int>(conn.sent.size()) < config.pipeline) {
+                conn.out.append(requests[pick(rng)]);
+                conn.sent.push_back(Clock::now());
+            }
+        }
+
+        void onWritable(size_t index) {
+            Connection& conn = connections[index];
+            if(conn.connecting) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if(err != 0) {
+                    fail(index, false);
+                    return;
+                }
+                conn.connecting = false;
+            }
+
+            while(conn.outOffset < conn.out.size()) {
+                ssize_t n = send(conn.fd, conn.out.data() + conn.outOffset, conn.out.size() - conn.outOffset, MSG_NOSIGNAL);
+                if(n < 0) {
+                    if(errno == EAGAIN || errno == EWOULDBLOCK) return;
+                    fail(index, false);
+                    return;
+                }
+                conn.outOffset += n;
+            }
+            conn.out.clear();
+            conn.outOffset = 0;
+
+            // Nothing left to write: only wait for responses
+            struct epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = index;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn.fd, &ev);
+        }
+
+        void onReadable(size_t index) {
+            Connection& conn = connections[index];
+            char buffer[64 * 1024];
+            bool closed = false;
+            while(true) {
+                ssize_t n = recv(conn.fd, buffer, sizeof(buffer), 0);
+                if(n > 0) {
+                    conn.in.append(buffer, n);
+                    stats.bytes += n;
+                    continue;
+                }
+                if(n == 0) closed = true;
+                else if(errno != EAGAIN && errno != EWOULDBLOCK) closed = true;
+                break;
+            }
+            conn.lastActivity = Clock::now();
+
+            bool wantClose = false;
+            while(!conn.sent.empty()) {
+                int consumed = parseResponse(conn.in, closed, wantClose);
+                if(consumed < 0) {
+                    stats.errors++;
+                    closeConnection(conn);
+                    if(running) openConnection(index);
+                    return;
+                }
+                if(consumed == 0) break;
+                conn.in.erase(0, consumed);
+
+                auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - conn.sent.front());
+                conn.sent.pop_front();
+                stats.requests++;
+                stats.latenciesUs.push_back(static_cast<uint32_t>(std::min<int64_t>(latency.count(), UINT32_MAX)));
+                if(wantClose) break;
+            }
+
+            if(closed || wantClose || !config.keepAlive) {
+                if(conn.sent.empty() || closed) {
+                    stats.dropped += conn.sent.size();
+                    closeConnection(conn);
+                    if(running) openConnection(index);
+                }
+                return;
+            }
+
+            // Keep the pipeline full
+            if(static_cast<int>(conn.sent.size()) < config.pipeline) {
+                fillPipeline(conn);
+                struct epoll_event ev{};
+                ev.events = EPOLLIN | EPOLLOUT;
+                ev.data.u64 = index;
+                epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn.fd, &ev);
+            }
+        }
+
+        /**
+         * @brief Parses one response from the front of `in`.
+         * @return The number of bytes consumed, 0 if incomplete, -1 if malformed.
+         */
+        int parseResponse(const std::string& in, bool closed, bool& wantClose) {
+            size_t headerEnd = in.find("\r\n\r\n");
+            if(headerEnd == std::string::npos) return 0;
+
+            std::string_view head(in.data(), headerEnd);
+            if(head.size() < 12 || head.substr(0, 5) != "HTTP/") return -1;
+            int status = std::atoi(std::string(head.substr(9, 3)).c_str());
+
+            long contentLength = -1;
+            size_t pos = head.find("\r\n");
+            while(pos != std::string_view::npos && pos < head.size()) {
+                size_t next = head.find("\r\n", pos + 2);
+                std::string_view line = head.substr(pos + 2, (next == std::string_view::npos ? head.size() : next) - pos - 2);
+                size_t colon = line.find(':');
+                if(colon != std::string_view::npos) {
+                    std::string key(line.substr(0, colon));
+                    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return std::tolower(c); });
+                    std::string_view value = line.substr(colon + 1);
+                    while(!value.empty() && value.front() == ' ') value.remove_prefix(1);
+                    if(key == "content-length") contentLength = std::atol(std::string(value).c_str());
+                    else if(key == "connection" && value == "close") wantClose = true;
+                }
+                pos = next;
+            }
+
+            size_t bodyStart = headerEnd + 4;
+            size_t total;
+            if(contentLength >= 0) {
+                total = bodyStart + static_cast<size_t>(contentLength);
+                if(in.size() < total) return 0;
+            }
+            else {
+                if(!closed) return 0; // Body delimited by connection close
+                total = in.size();
+            }
+
+            if(status < 200 || status >= 300) stats.non2xx++;
+            return static_cast<int>(total);
+        }
+
+        void checkTimeouts() {
+            auto now = Clock::now();
+            for(size_t i = 0; i < connections.size(); ++i) {
+                Connection& conn = connections[i];
+                if(conn.fd < 0) {
+                    if(running) openConnection(i);
+                    continue;
+                }
+                if(!conn.sent.empty() && now - conn.lastActivity > std::chrono::milliseconds(config.timeoutMs)) {
+                    fail(i, true);
+                }
+            }
+        }
+    };
+
+    /**
+     * @brief Returns the value at the given percentile of a sorted vector.
+     */
+    uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+        if(sorted.empty()) return 0;
+        size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+}
+
+/**
+ * @brief Entry point for the load generator.
+ * @return `EXIT_SUCCESS` if the run completed, `EXIT_FAILURE` otherwise.
+ */
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    try {
+        config = parseArgs(argc, argv);
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    try {
+        int base = config.connections / config.threads;
+        int extra = config.connections % config.threads;
+        for(int i = 0; i < config.threads; ++i) {
+            workers.push_back(std::make_unique<Worker>(config, base + (i < extra ? 1 : 0), 0x5eed + i));
+        }
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::seconds(config.durationSec);
+    std::vector<std::thread> threads;
+    std::atomic<bool> failed{false};
+    for(auto& worker : workers) {
+        threads.emplace_back([&worker, deadline, &failed] {
+            try {
+                worker->run(deadline);
+            }
+            catch(const std::exception& e) {
+                std::cerr << "Worker error: " << e.what() << std::endl;
+                failed = true;
+                running = false;
+            }
+        });
+    }
+    for(auto& thread : threads) thread.join();
+    running = false;
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    // Merge results
+    ThreadStats total;
+    for(auto& worker : workers) {
+        const ThreadStats& s = worker->stats;
+        total.requests += s.requests;
+        total.errors += s.errors;
+        total.timeouts += s.timeouts;
+        total.dropped += s.dropped;
+        total.connects += s.connects;
+        total.bytes += s.bytes;
+        total.non2xx += s.non2xx;
+        total.latenciesUs.insert(total.latenciesUs.end(), s.latenciesUs.begin(), s.latenciesUs.end());
+    }
+    std::sort(total.latenciesUs.begin(), total.latenciesUs.end());
+
+    double seconds = elapsed.count();
+    std::printf(
+        "{\"connections\":%d,\"threads\":%d,\"pipeline\":%d,\"keep_alive\":%s,\"urls\":%zu,"
+        "\"duration_s\":%.3f,\"requests\":%llu,\"requests_per_sec\":%.1f,\"bytes_per_sec\":%.1f,"
+        "\"non_2xx\":%llu,\"errors\":%llu,\"timeouts\":%llu,\"dropped\":%llu,\"connects\":%llu,"
+        "\"latency_us\":{\"p50\":%u,\"p90\":%u,\"p99\":%u,\"p999\":%u,\"max\":%u}}\n",
+        config.connections, config.threads, config.pipeline, config.keepAlive ? "true" : "false", config.urls.size(),
+        seconds, static_cast<unsigned long long>(total.requests), total.requests / seconds, total.bytes / seconds,
+        static_cast<unsigned long long>(total.non2xx), static_cast<unsigned long long>(total.errors),
+        static_cast<unsigned long long>(total.timeouts), static_cast<unsigned long long>(total.dropped),
+        static_cast<unsigned long long>(total.connects),
+        percentile(total.latenciesUs, 0.50), percentile(total.latenciesUs, 0.90),
+        percentile(total.latenciesUs, 0.99), percentile(total.latenciesUs, 0.999),
+        total.latenciesUs.empty() ? 0u : total.latenciesUs.back());
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
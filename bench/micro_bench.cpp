@@ -0,0 +1,388 @@
+/**
+ * @file micro_bench.cpp
+ * @brief This file contains microbenchmarks for the server's hot pure functions.
+ * @details Each benchmark reports nanoseconds, heap allocations and CPU cycles per
+ * operation. Results can be saved as a baseline and compared against later runs.
+ * 
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "file_resolver.hpp"
+#include "form_parser.hpp"
+#include "http_encoding.hpp"
+#include "http_method.hpp"
+#include "http_mime.hpp"
+#include "http_request.hpp"
+#include "http_response.hpp"
+#include "http_status.hpp"
+#include "response_builder.hpp"
+#include "response_composer.hpp"
+#include "router.hpp"
+#include "websocket.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <getopt.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// =Allocation Counting========================================================
+// Replacing the global allocation functions counts every heap allocation made
+// by the code under test, including those inside the standard library.
+// ============================================================================
+
+namespace {
+    uint64_t allocationCount = 0;
+}
+
+void* operator new(std::size_t size) {
+    allocationCount++;
+    if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    allocationCount++;
+    if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+// Polymorphic resources (std::pmr::new_delete_resource) allocate through the aligned overloads
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocationCount++;
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if(void* ptr = std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Prevents the compiler from optimizing away a computed value.
+     */
+    template<typename T>
+    inline void doNotOptimize(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /**
+     * @brief Reads the CPU timestamp counter, or returns 0 where unavailable.
+     */
+    inline uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief The result of a single benchmark.
+     */
+    struct Result {
+        std::string name;
+        double nsPerOp = 0;
+        double allocsPerOp = 0;
+        double cyclesPerOp = 0;
+    };
+
+    /**
+     * @brief Runs `op` repeatedly until `minTime` has elapsed and reports per-op costs.
+     */
+    Result run(const std::string& name, const std::function<void()>& op, std::chrono::milliseconds minTime) {
+        // Warm up and calibrate
+        uint64_t iterations = 1;
+        while(true) {
+            auto start = Clock::now();
+            for(uint64_t i = 0; i < iterations; ++i) op();
+            if(Clock::now() - start >= minTime / 10) break;
+            iterations *= 2;
+        }
+        iterations *= 10;
+
+        uint64_t allocsBefore = allocationCount;
+        uint64_t cyclesBefore = readCycles();
+        auto start = Clock::now();
+        for(uint64_t i = 0; i < iterations; ++i) op();
+        auto end = Clock::now();
+        uint64_t cyclesAfter = readCycles();
+        uint64_t allocsAfter = allocationCount;
+
+        Result result;
+        result.name = name;
+        result.nsPerOp = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+        result.allocsPerOp = static_cast<double>(allocsAfter - allocsBefore) / iterations;
+        result.cyclesPerOp = static_cast<double>(cyclesAfter - cyclesBefore) / iterations;
+        return result;
+    }
+
+    /**
+     * @brief Loads a baseline written by `--save`.
+     */
+    std::map<std::string, Result> loadBaseline(const std::string& path) {
+        std::map<std::string, Result> baseline;
+        std::ifstream file(path);
+        std::string line;
+        while(std::getline(file, line)) {
+            if(line.empty() || line.front() == '#') continue;
+            std::istringstream iss(line);
+            Result result;
+            if(iss >> result.name >> result.nsPerOp >> result.allocsPerOp >> result.cyclesPerOp) {
+                baseline[result.name] = result;
+            }
+        }
+        return baseline;
+    }
+
+    /**
+     * @brief Writes results in the format read by `loadBaseline`.
+     */
+    void saveBaseline(const std::string& path, const std::vector<Result>& results) {
+        std::ofstream file(path);
+        file << "# name ns_per_op allocs_per_op cycles_per_op\n";
+        for(const auto& result : results) {
+            file << result.name << " " << result.nsPerOp << " " << result.allocsPerOp << " " << result.cyclesPerOp << "\n";
+        }
+    }
+
+    // Realistic inputs //
+
+    const std::string BROWSER_REQUEST =
+        "GET /assets/css/tlr-calculator-styles.css HTTP/1.1\r\n"
+        "Host: localhost:60001\r\n"
+        "Connection: keep-alive\r\n"
+        "sec-ch-ua: \"Chromium\";v=\"122\", \"Not(A:Brand\";v=\"24\", \"Google Chrome\";v=\"122\"\r\n"
+        "sec-ch-ua-mobile: ?0\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/122.0.0.0 Safari/537.36\r\n"
+        "sec-ch-ua-platform: \"Linux\"\r\n"
+        "Accept: text/css,*/*;q=0.1\r\n"
+        "Sec-Fetch-Site: same-origin\r\n"
+        "Sec-Fetch-Mode: no-cors\r\n"
+        "Sec-Fetch-Dest: style\r\n"
+        "Referer: http://localhost:60001/pages/tlr-calculator.html\r\n"
+        "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+        "Accept-Language: en-US,en;q=0.9\r\n"
+        "\r\n";
+
+    const std::string FORM_BODY =
+        "name=Noah+Nickles&email=noah%40example.com&message=Hello%2C%20world%21%20This%20is%20a%20test"
+        "&pantry=argo&amount=42";
+
+    const std::string PLAIN_TEXT = "Hello, world! This is a test of the encoder & decoder (100% coverage?)";
+}
+
+/**
+ * @brief Entry point for the microbenchmark suite.
+ * @return `EXIT_SUCCESS` if all benchmarks ran.
+ */
+int main(int argc, char* argv[]) {
+    std::string savePath;
+    std::string baselinePath;
+    std::string filter;
+    int minTimeMs = 200;
+
+    static struct option long_options[] = {
+        {"save",     required_argument, 0, 's'},
+        {"baseline", required_argument, 0, 'b'},
+        {"filter",   required_argument, 0, 'f'},
+        {"time",     required_argument, 0, 't'},
+        {0,          0,                 0,  0 }
+    };
+    int opt, option_index;
+    while((opt = getopt_long(argc, argv, "s:b:f:t:", long_options, &option_index)) != -1) {
+        switch(opt) {
+            case 's': savePath = optarg;              break;
+            case 'b': baselinePath = optarg;          break;
+            case 'f': filter = optarg;                break;
+            case 't': minTimeMs = std::atoi(optarg);  break;
+            default:
+                std::cerr << "Usage: " << argv[0] << " [--save file] [--baseline file] [--filter substr] [--time ms]\n";
+                return EXIT_FAILURE;
+        }
+    }
+
+    // Shared fixtures
+    ResponseComposer composer;
+    FileResolver resolver;
+    HttpResponse response;
+    response.setStatus(http::status::Code::OK)
+            .setContentLength(18342)
+            .setHeader("Content-Type", "text/css")
+            .setHeader("Connection", "keep-alive")
+            .setHeader("Date", "Fri, 16 Oct 2026 12:00:00 GMT");
+    const std::string encodedText = http::encoding::encode(PLAIN_TEXT);
+    std::string framePayload(4096, 'x');
+    const std::array<uint8_t, 4> frameMask = {0x37, 0xfa, 0x21, 0x3d};
+    alignas(std::max_align_t) static std::byte arenaBuffer[16 * 1024];
+    std::pmr::monotonic_buffer_resource arena(arenaBuffer, sizeof(arenaBuffer));
+    MetricsResponseBuilder routeBuilder;
+    Router router;
+    for(const char* pattern : {"/submit", "/metrics", "/api/users", "/api/users/:id", "/api/users/:id/posts",
+                               "/api/users/:id/posts/:post", "/api/orders", "/api/orders/:id", "/api/status",
+                               "/static/*path", "/admin/settings", "/admin/stats"}) {
+        router.add(http::method::Method::GET, pattern, &routeBuilder);
+    }
+
+    std::vector<std::pair<std::string, std::function<void()>>> benchmarks = {
+        {"request_parse", [&] {
+            HttpRequest request;
+            bool ok = request.parse(BROWSER_REQUEST);
+            doNotOptimize(ok);
+        }},
+        {"request_parse_arena", [&] {
+            {
+                HttpRequest request(&arena);
+                bool ok = request.parse(BROWSER_REQUEST);
+                doNotOptimize(ok);
+            }
+            arena.release();
+        }},
+        {"compose_response_headers", [&] {
+            std::string out = composer.composeResponseString(response);
+            doNotOptimize(out);
+        }},
+        {"serialize_response_headers", [&] {
+            char buffer[1024];
+            size_t length = composer.serializeHeaders(response, buffer, sizeof(buffer));
+            doNotOptimize(length);
+            doNotOptimize(buffer);
+        }},
+        {"encoding_decode_form", [&] {
+            std::string out = http::encoding::decode(FORM_BODY, true);
+            doNotOptimize(out);
+        }},
+        {"form_parse_chunked", [&] {
+            {
+                FormParser parser(&arena);
+                size_t bytes = 0;
+                auto onField = [&](std::string_view key, std::string_view value) { bytes += key.size() + value.size(); };
+                std::string_view body = FORM_BODY;
+                parser.feed(body.substr(0, 40), onField);
+                parser.feed(body.substr(40), onField);
+                parser.finish(onField);
+                doNotOptimize(bytes);
+            }
+            arena.release();
+        }},
+        {"router_match", [&] {
+            Router::Match match;
+            bool user = router.match(http::method::Method::GET, "/api/users/42/posts/7", match);
+            bool file = router.match(http::method::Method::GET, "/static/css/site.css", match);
+            bool miss = router.match(http::method::Method::GET, "/index.html", match);
+            doNotOptimize(user);
+            doNotOptimize(file);
+            doNotOptimize(miss);
+        }},
+        {"websocket_unmask_4k", [&] {
+            WebSocketConnection::unmask(framePayload.data(), framePayload.size(), frameMask, 1);
+            doNotOptimize(framePayload);
+        }},
+        {"encoding_decode_into", [&] {
+            char buffer[512];
+            size_t length = http::encoding::decodeInto(encodedText, buffer);
+            doNotOptimize(length);
+            doNotOptimize(buffer);
+        }},
+        {"encoding_encode", [&] {
+            std::string out = http::encoding::encode(PLAIN_TEXT);
+            doNotOptimize(out);
+        }},
+        {"encoding_decode", [&] {
+            std::string out = http::encoding::decode(encodedText);
+            doNotOptimize(out);
+        }},
+        {"mime_from_extension", [&] {
+            auto css = http::mime::fromExtension(".css");
+            auto woff2 = http::mime::fromExtension(".woff2");
+            auto unknown = http::mime::fromExtension(".xyz");
+            doNotOptimize(css);
+            doNotOptimize(woff2);
+            doNotOptimize(unknown);
+        }},
+        {"method_from_string", [&] {
+            auto get = http::method::fromString("GET");
+            auto post = http::method::fromString("POST");
+            auto bad = http::method::fromString("BREW");
+            doNotOptimize(get);
+            doNotOptimize(post);
+            doNotOptimize(bad);
+        }},
+        {"mime_to_string", [&] {
+            auto html = http::mime::toString(http::mime::Media::TEXT_HTML);
+            auto form = http::mime::toString(http::mime::Media::APP_FORM);
+            doNotOptimize(html);
+            doNotOptimize(form);
+        }},
+        {"status_to_string", [&] {
+            auto ok = http::status::toString(http::status::Code::OK);
+            auto notFound = http::status::toString(http::status::Code::NOT_FOUND);
+            doNotOptimize(ok);
+            doNotOptimize(notFound);
+        }},
+        {"file_resolver_sanitize", [&] {
+            auto path = resolver.sanitizePath("/assets/css/modal-styles.css");
+            doNotOptimize(path);
+        }}
+    };
+
+    std::map<std::string, Result> baseline;
+    if(!baselinePath.empty()) baseline = loadBaseline(baselinePath);
+
+    std::vector<Result> results;
+    std::printf("%-28s %12s %12s %12s", "benchmark", "ns/op", "allocs/op", "cycles/op");
+    if(!baseline.empty()) std::printf(" %12s %12s", "ns delta", "allocs delta");
+    std::printf("\n");
+
+    for(const auto& [name, op] : benchmarks) {
+        if(!filter.empty() && name.find(filter) == std::string::npos) continue;
+        Result result = run(name, op, std::chrono::milliseconds(minTimeMs));
+        results.push_back(result);
+
+        std::printf("%-28s %12.1f %12.2f %12.0f", name.c_str(), result.nsPerOp, result.allocsPerOp, result.cyclesPerOp);
+        auto it = baseline.find(name);
+        if(it != baseline.end() && it->second.nsPerOp > 0) {
+            double nsDelta = (result.nsPerOp - it->second.nsPerOp) / it->second.nsPerOp * 100.0;
+            std::printf(" %+11.1f%% %+12.2f", nsDelta, result.allocsPerOp - it->second.allocsPerOp);
+        }
+        std::printf("\n");
+    }
+
+    if(!savePath.empty()) {
+        saveBaseline(savePath, results);
+        std::printf("Saved baseline to %s\n", savePath.c_str());
+    }
+    return EXIT_SUCCESS;
+}
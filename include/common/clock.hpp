@@ -0,0 +1,94 @@
+/**
+ * @file clock.hpp
+ * @brief This file contains the declaration of the Clock class.
+ * @details This class is a singleton that caches preformatted timestamps for the
+ * logger and the HTTP `Date` header, refreshing them at most once per second.
+ * 
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Date Header Documentation=======================================
+// https://datatracker.ietf.org/doc/html/rfc7231#section-7.1.1.2  |
+// https://man7.org/linux/man-pages/man2/clock_gettime.2.html     |
+// =================================================================
+
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+
+#include <time.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+
+/**
+ * @brief The Clock class caches formatted timestamps so hot paths avoid 
+ * `localtime()` and stream formatting on every call.
+ */
+class Clock {
+public:
+    // Singleton //
+
+    static Clock& getInstance() {
+        static Clock instance;
+        return instance;
+    }
+
+    // Deleted //
+
+    Clock(const Clock&) = delete;
+    Clock& operator=(const Clock&) = delete;
+    Clock(Clock&&) = delete;
+    Clock& operator=(Clock&&) = delete;
+
+    // Getters //
+
+    std::string_view getLogTimestamp() noexcept { return current()->logTimestamp(); }
+    std::string_view getHttpDate() noexcept { return current()->httpDate(); }
+
+    // Functions //
+
+    void update() noexcept;
+
+private:
+    // Constants //
+
+    static constexpr size_t SLOT_COUNT = 8;        // Seconds a reader can hold a view before reuse
+    static constexpr size_t LOG_TIMESTAMP_SIZE = 19; // "YYYY-MM-DD HH:MM:SS"
+    static constexpr size_t HTTP_DATE_SIZE = 29;     // "Sun, 06 Nov 1994 08:49:37 GMT"
+
+    /**
+     * @brief A single preformatted second.
+     */
+    struct Snapshot {
+        time_t seconds = -1;
+        char log[32] = {};  // Oversized so the formatter can never truncate
+        char http[64] = {};
+
+        std::string_view logTimestamp() const noexcept { return std::string_view(log, LOG_TIMESTAMP_SIZE); }
+        std::string_view httpDate() const noexcept { return std::string_view(http, HTTP_DATE_SIZE); }
+    };
+
+    // Singleton //
+
+    Clock() noexcept;
+
+    // Data //
+
+    std::array<Snapshot, SLOT_COUNT> slots;
+    size_t nextSlot = 0;
+    std::atomic<const Snapshot*> snapshot;
+    std::mutex updateMutex;
+
+    // Helpers //
+
+    static time_t now() noexcept;
+    const Snapshot* current() noexcept;
+    void refresh(time_t seconds) noexcept;
+};
+
+#endif // CLOCK_HPP
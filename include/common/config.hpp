@@ -19,6 +19,15 @@
 #include "logger.hpp"
 
 #include <string>
+#include <vector>
+
+/**
+ * @brief A path prefix forwarded to a group of upstream servers.
+ */
+struct ProxyRoute {
+    std::string prefix;
+    std::vector<std::string> upstreams; // host:port
+};
 
 /**
  * @brief The ConfigData struct contains the configuration settings for the server.
@@ -29,6 +38,21 @@ struct ConfigData {
     std::string rootFolder = "./www";
     std::string indexFile = "index.html";
     int threadCount = 4;
+    std::string metricsPath = "/metrics";
+    int slowRequestMs = 500;
+    int responseCacheMb = 32;
+    std::string webSocketPath = "/ws";
+    std::string eventsPath = "/events";
+    std::vector<ProxyRoute> proxyRoutes;
+    std::string proxyBalance = "round-robin";
+    int microCacheTtlMs = 0;   // 0 disables the micro-cache
+    int microCacheStaleMs = 0;
+    std::vector<std::string> microCacheVary;
+    int connectionRate = 0;  // New connections per second per client, 0 disables the limit
+    int connectionBurst = 0;
+    int requestRate = 0;     // Requests per second per client, 0 disables the limit
+    int requestBurst = 0;
+    int queueTargetMs = 0;   // Queue delay target for load shedding, 0 disables it
 };
 
 /**
@@ -58,6 +82,21 @@ public:
     std::string getRootFolder() const { return data.rootFolder; }
     std::string getIndexFile() const { return data.indexFile; }
     size_t getThreadCount() const noexcept { return data.threadCount; }
+    const std::string& getMetricsPath() const noexcept { return data.metricsPath; }
+    int getSlowRequestMs() const noexcept { return data.slowRequestMs; }
+    size_t getResponseCacheBytes() const noexcept { return static_cast<size_t>(data.responseCacheMb) * 1024 * 1024; }
+    const std::string& getWebSocketPath() const noexcept { return data.webSocketPath; }
+    const std::string& getEventsPath() const noexcept { return data.eventsPath; }
+    const std::vector<ProxyRoute>& getProxyRoutes() const noexcept { return data.proxyRoutes; }
+    const std::string& getProxyBalance() const noexcept { return data.proxyBalance; }
+    int getMicroCacheTtlMs() const noexcept { return data.microCacheTtlMs; }
+    int getMicroCacheStaleMs() const noexcept { return data.microCacheStaleMs; }
+    const std::vector<std::string>& getMicroCacheVary() const noexcept { return data.microCacheVary; }
+    int getConnectionRate() const noexcept { return data.connectionRate; }
+    int getConnectionBurst() const noexcept { return data.connectionBurst; }
+    int getRequestRate() const noexcept { return data.requestRate; }
+    int getRequestBurst() const noexcept { return data.requestBurst; }
+    int getQueueTargetMs() const noexcept { return data.queueTargetMs; }
     Logger::LogLevel determineLogLevel() const;
     
     // Functions //
@@ -68,6 +107,8 @@ private:
     // Constants //
 
     static constexpr int MAX_PORT = 65535;
+    static constexpr int MAX_RATE = 1000000;
+    static constexpr int MAX_RATE_BURST = 4000; // The rate limiter's bucket capacity
 
     // Singleton //
 
@@ -85,6 +126,17 @@ private:
     void parseRootFolder(const char* optarg, ConfigData& data);
     void parseIndexFile(const char* optarg, ConfigData& data);
     void parseThreadCount(const char* optarg, ConfigData& data);
+    void parseMetricsPath(const char* optarg, ConfigData& data);
+    void parseSlowRequestMs(const char* optarg, ConfigData& data);
+    void parseResponseCacheMb(const char* optarg, ConfigData& data);
+    void parseWebSocketPath(const char* optarg, ConfigData& data);
+    void parseEventsPath(const char* optarg, ConfigData& data);
+    void parseProxyRoute(const char* optarg, ConfigData& data);
+    void parseProxyBalance(const char* optarg, ConfigData& data);
+    void parseMicroCache(const char* optarg, ConfigData& data);
+    void parseMicroCacheVary(const char* optarg, ConfigData& data);
+    void parseRateLimit(const char* optarg, int& rate, int& burst);
+    void parseQueueTarget(const char* optarg, ConfigData& data);
     void handleInvalidOption(int optopt, char* argv[]);
 
     // Helpers //
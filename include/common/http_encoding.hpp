@@ -1,8 +1,8 @@
 /**
  * @file http_encoding.hpp
- * @brief This file contains constants and functions for encoding and decoding 
- * percent-encoded strings. 
- * 
+ * @brief This file contains constants and functions for encoding and decoding
+ * percent-encoded strings.
+ *
  * @author Noah Nickles
  * @date 1/30/2025
  * COP4635 Sys & Net II - Project 1
@@ -10,103 +10,208 @@
 
 // =HTTP POST Documentation========================================
 // https://developer.mozilla.org/en-US/docs/Web/HTTP/Methods/POST |
+// https://www.rfc-editor.org/rfc/rfc3986#section-2               |
 // ================================================================
 
 #ifndef HTTP_ENCODING_HPP
 #define HTTP_ENCODING_HPP
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace http::encoding {
-    inline const std::unordered_map<char, std::string> ENCODING_MAP = {
-        {' ',  "%20"},
-        {'!',  "%21"},
-        {'"',  "%22"},
-        {'#',  "%23"},
-        {'$',  "%24"},
-        {'%',  "%25"},
-        {'&',  "%26"},
-        {'\'', "%27"},
-        {'(',  "%28"},
-        {')',  "%29"},
-        {'*',  "%2A"},
-        {'+',  "%2B"},
-        {',',  "%2C"},
-        {'-',  "%2D"},
-        {'.',  "%2E"},
-        {'/',  "%2F"},
-        {':',  "%3A"},
-        {';',  "%3B"},
-        {'<',  "%3C"},
-        {'=',  "%3D"},
-        {'>',  "%3E"},
-        {'?',  "%3F"},
-        {'@',  "%40"},
-        {'[',  "%5B"},
-        {'\\', "%5C"},
-        {']',  "%5D"},
-        {'^',  "%5E"},
-        {'_',  "%5F"},
-        {'`',  "%60"},
-        {'{',  "%7B"},
-        {'|',  "%7C"},
-        {'}',  "%7D"},
-        {'~',  "%7E"}
-    };
+    /**
+     * @brief Builds the table mapping a byte to its hexadecimal value, or -1 if it is not a hex digit.
+     */
+    constexpr std::array<int8_t, 256> makeHexTable() noexcept {
+        std::array<int8_t, 256> table{};
+        for(int c = 0; c < 256; ++c) {
+            if(c >= '0' && c <= '9')      table[c] = static_cast<int8_t>(c - '0');
+            else if(c >= 'a' && c <= 'f') table[c] = static_cast<int8_t>(c - 'a' + 10);
+            else if(c >= 'A' && c <= 'F') table[c] = static_cast<int8_t>(c - 'A' + 10);
+            else                          table[c] = -1;
+        }
+        return table;
+    }
 
     /**
-     * @brief Encodes a string into a percent-encoded string.
-     * @param str The string to encode.
-     * @return The percent-encoded string.
+     * @brief Builds the table of bytes that are written as-is by `encode` (RFC 3986 unreserved).
      */
-    inline std::string encode(const std::string& str) noexcept {
-        std::string encoded;
-        for(char c : str) {
-            auto it = ENCODING_MAP.find(c);
-            if(it != ENCODING_MAP.end()) {
-                encoded.append(it->second); // Append encoded string
-            } 
-            else {
-                encoded.push_back(c); // Append character directly
-            }
+    constexpr std::array<bool, 256> makeUnreservedTable() noexcept {
+        std::array<bool, 256> table{};
+        for(int c = 0; c < 256; ++c) {
+            table[c] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                       c == '-' || c == '.' || c == '_' || c == '~';
         }
-        return encoded;
+        return table;
     }
 
+    inline constexpr std::array<int8_t, 256> HEX_VALUE = makeHexTable();
+    inline constexpr std::array<bool, 256> UNRESERVED = makeUnreservedTable();
+    inline constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+
     /**
-     * @brief Decodes a percent-encoded string.
+     * @brief Finds the length of the leading run that `decode` copies unchanged.
+     * @details Scans 16 bytes at a time with SSE2 when available.
+     * @param str The input.
+     * @param plusAsSpace `true` if '+' also ends the run.
+     * @return The number of leading bytes that contain no '%' (and no '+' in form mode).
+     */
+    inline size_t plainPrefixLength(std::string_view str, bool plusAsSpace) noexcept {
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128i percent = _mm_set1_epi8('%');
+        const __m128i plus = _mm_set1_epi8(plusAsSpace ? '+' : '%');
+        for(; i + 16 <= str.size(); i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str.data() + i));
+            __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, percent), _mm_cmpeq_epi8(chunk, plus));
+            int mask = _mm_movemask_epi8(hits);
+            if(mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+#endif
+        for(; i < str.size(); ++i) {
+            if(str[i] == '%' || (plusAsSpace && str[i] == '+')) return i;
+        }
+        return i;
+    }
+
+    /**
+     * @brief Finds the length of the leading run that `encode` copies unchanged.
+     * @details Scans 16 bytes at a time with SSE2 when available.
+     * @param str The input.
+     * @return The number of leading bytes that are all unreserved characters.
+     */
+    inline size_t unreservedPrefixLength(std::string_view str) noexcept {
+        size_t i = 0;
+#if defined(__SSE2__)
+        // Signed compares are fine: bytes >= 0x80 are negative and fail every range below
+        auto inRange = [](__m128i chunk, char lo, char hi) {
+            return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                                 _mm_cmplt_epi8(chunk, _mm_set1_epi8(static_cast<char>(hi + 1))));
+        };
+        for(; i + 16 <= str.size(); i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str.data() + i));
+            __m128i safe = _mm_or_si128(inRange(chunk, 'a', 'z'), inRange(chunk, 'A', 'Z'));
+            safe = _mm_or_si128(safe, inRange(chunk, '0', '9'));
+            safe = _mm_or_si128(safe, inRange(chunk, '-', '.'));
+            safe = _mm_or_si128(safe, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+            safe = _mm_or_si128(safe, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('~')));
+            int mask = ~_mm_movemask_epi8(safe) & 0xFFFF;
+            if(mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+#endif
+        for(; i < str.size(); ++i) {
+            if(!UNRESERVED[static_cast<unsigned char>(str[i])]) return i;
+        }
+        return i;
+    }
+
+    /**
+     * @brief Decodes a percent-encoded string into a caller-provided buffer.
      * @param str The percent-encoded string to decode.
-     * @return The decoded string.
+     * @param out The output buffer, at least `str.size()` bytes.
+     * @param plusAsSpace `true` to decode '+' as a space (`application/x-www-form-urlencoded`).
+     * @return The number of bytes written.
      * @note If the percent-encoded sequence is invalid (not followed by two hexadecimal digits),
      * the '%' character is preserved in the output.
      */
-    inline std::string decode(const std::string& str) noexcept {
-        std::string decoded;
-        size_t i = 0;
+    inline size_t decodeInto(std::string_view str, char* out, bool plusAsSpace = false) noexcept {
+        char* const begin = out;
+        while(!str.empty()) {
+            size_t run = plainPrefixLength(str, plusAsSpace);
+            std::memcpy(out, str.data(), run);
+            out += run;
+            str.remove_prefix(run);
+            if(str.empty()) break;
 
-        while(i < str.size()) {
-            if((str[i] == '%') && (i + 2 < str.size())) {
-                // Extract the next two characters after '%' as a hex string
-                std::string hex = str.substr(i + 1, 2);
-                try {
-                    // Convert hex string to a character and append to decoded string
-                    decoded += static_cast<char>(std::stoi(hex, nullptr, 16));
-                    i += 2;  // Skip next two characters
-                } 
-                catch(...) { // Catch all exceptions
-                    // If conversion fails, append '%' and continue
-                    decoded += "%"; 
-                }
+            if(str[0] == '+') {
+                *out++ = ' ';
+                str.remove_prefix(1);
+                continue;
             }
-            else {
-                // Append character directly if it's not part of a percent-encoded sequence
-                decoded += str[i];
+
+            int8_t high = (str.size() >= 3) ? HEX_VALUE[static_cast<unsigned char>(str[1])] : -1;
+            int8_t low = (str.size() >= 3) ? HEX_VALUE[static_cast<unsigned char>(str[2])] : -1;
+            if(high < 0 || low < 0) {
+                *out++ = '%';
+                str.remove_prefix(1);
+                continue;
             }
-            i++;
+            *out++ = static_cast<char>((high << 4) | low);
+            str.remove_prefix(3);
         }
+        return static_cast<size_t>(out - begin);
+    }
+
+    /**
+     * @brief Decodes a percent-encoded string and appends it to `out`.
+     * @param str The percent-encoded string to decode.
+     * @param out The string to append to (any `std::basic_string<char>`, including `std::pmr::string`).
+     * @param plusAsSpace `true` to decode '+' as a space.
+     */
+    template<typename String>
+    inline void decodeAppend(std::string_view str, String& out, bool plusAsSpace = false) {
+        size_t start = out.size();
+        out.resize(start + str.size());
+        out.resize(start + decodeInto(str, out.data() + start, plusAsSpace));
+    }
+
+    /**
+     * @brief Decodes a percent-encoded string.
+     * @param str The percent-encoded string to decode.
+     * @param plusAsSpace `true` to decode '+' as a space.
+     * @return The decoded string.
+     */
+    inline std::string decode(std::string_view str, bool plusAsSpace = false) {
+        std::string decoded;
+        decodeAppend(str, decoded, plusAsSpace);
         return decoded;
     }
+
+    /**
+     * @brief Percent-encodes a string into a caller-provided buffer.
+     * @details Every byte except the RFC 3986 unreserved characters is written as `%XX`.
+     * @param str The string to encode.
+     * @param out The output buffer, at least `3 * str.size()` bytes.
+     * @return The number of bytes written.
+     */
+    inline size_t encodeInto(std::string_view str, char* out) noexcept {
+        char* const begin = out;
+        while(!str.empty()) {
+            size_t run = unreservedPrefixLength(str);
+            std::memcpy(out, str.data(), run);
+            out += run;
+            str.remove_prefix(run);
+            if(str.empty()) break;
+
+            unsigned char c = static_cast<unsigned char>(str[0]);
+            out[0] = '%';
+            out[1] = HEX_DIGITS[c >> 4];
+            out[2] = HEX_DIGITS[c & 0x0F];
+            out += 3;
+            str.remove_prefix(1);
+        }
+        return static_cast<size_t>(out - begin);
+    }
+
+    /**
+     * @brief Encodes a string into a percent-encoded string.
+     * @param str The string to encode.
+     * @return The percent-encoded string.
+     */
+    inline std::string encode(std::string_view str) {
+        std::string encoded(str.size() * 3, '\0');
+        encoded.resize(encodeInto(str, encoded.data()));
+        return encoded;
+    }
 }
 
-#endif // HTTP_ENCODING_HPP
\ No newline at end of file
+#endif // HTTP_ENCODING_HPP
@@ -15,9 +15,7 @@
 #ifndef HTTP_METHOD_HPP
 #define HTTP_METHOD_HPP
 
-#include <string>
 #include <string_view>
-#include <unordered_map>
 
 namespace http::method {
     enum class Method {
@@ -34,25 +32,32 @@ namespace http::method {
         INVALID
     };
 
-    inline const std::unordered_map<Method, std::string_view> METHOD_MAP {
-        {Method::GET,     "GET"},
-        {Method::POST,    "POST"},
-        {Method::PUT,     "PUT"},
-        {Method::DELETE,  "DELETE"},
-        {Method::HEAD,    "HEAD"},
-        {Method::OPTIONS, "OPTIONS"},
-        {Method::TRACE,   "TRACE"},
-        {Method::CONNECT, "CONNECT"}
-    };
-
     /**
      * @brief Converts a string to an HTTP method.
+     * @details Dispatches on the length and first byte, then confirms with a single compare.
      * @param str The string to convert.
      * @return The HTTP method enum.
      */
-    inline Method fromString(const std::string_view& str) noexcept {
-        for(const auto& [method, methodStr] : METHOD_MAP) {
-            if(methodStr == str) return method;
+    constexpr Method fromString(std::string_view str) noexcept {
+        switch(str.size()) {
+            case 3:
+                if(str == "GET") return Method::GET;
+                if(str == "PUT") return Method::PUT;
+                break;
+            case 4:
+                if(str[0] == 'P' && str == "POST") return Method::POST;
+                if(str[0] == 'H' && str == "HEAD") return Method::HEAD;
+                break;
+            case 5:
+                if(str == "TRACE") return Method::TRACE;
+                break;
+            case 6:
+                if(str == "DELETE") return Method::DELETE;
+                break;
+            case 7:
+                if(str[0] == 'O' && str == "OPTIONS") return Method::OPTIONS;
+                if(str[0] == 'C' && str == "CONNECT") return Method::CONNECT;
+                break;
         }
         return Method::INVALID;
     }
@@ -62,9 +67,18 @@ namespace http::method {
      * @param method The HTTP method to convert.
      * @return The string representation of the method.
      */
-    inline const std::string toString(const Method& method) noexcept {
-        auto it = METHOD_MAP.find(method);
-        return (it != METHOD_MAP.end()) ? std::string(it->second) : "INVALID";
+    constexpr std::string_view toString(Method method) noexcept {
+        switch(method) {
+            case Method::GET:     return "GET";
+            case Method::POST:    return "POST";
+            case Method::PUT:     return "PUT";
+            case Method::DELETE:  return "DELETE";
+            case Method::HEAD:    return "HEAD";
+            case Method::OPTIONS: return "OPTIONS";
+            case Method::TRACE:   return "TRACE";
+            case Method::CONNECT: return "CONNECT";
+            default:              return "INVALID";
+        }
     }
 
     /**
@@ -72,9 +86,29 @@ namespace http::method {
      * @param method The HTTP method to check.
      * @return `true` if valid, `false` otherwise.
      */
-    inline bool isValid(const Method& method) noexcept {
-        return METHOD_MAP.find(method) != METHOD_MAP.end();
+    constexpr bool isValid(Method method) noexcept {
+        return static_cast<unsigned>(method) < static_cast<unsigned>(Method::INVALID);
+    }
+
+    /**
+     * @brief Checks if a request with this method can be sent again after a failed attempt.
+     * @param method The HTTP method to check.
+     * @return `true` for GET, HEAD, OPTIONS, PUT and DELETE, `false` otherwise.
+     */
+    constexpr bool isIdempotent(Method method) noexcept {
+        switch(method) {
+            case Method::GET:
+            case Method::HEAD:
+            case Method::OPTIONS:
+            case Method::PUT:
+            case Method::DELETE:
+                return true;
+            default:
+                return false;
+        }
     }
+
+    static_assert(fromString("OPTIONS") == Method::OPTIONS && fromString("BREW") == Method::INVALID);
 }
 
 #endif // HTTP_METHOD_HPP
\ No newline at end of file
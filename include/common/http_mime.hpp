@@ -11,9 +11,8 @@
 #ifndef HTTP_MIME_HPP
 #define HTTP_MIME_HPP
 
-#include <string>
+#include <cstddef>
 #include <string_view>
-#include <unordered_map>
 
 namespace http::mime {
     enum class Media {
@@ -43,6 +42,9 @@ namespace http::mime {
         IMAGE_SVG_XML,
         IMAGE_WEBP,
 
+        // Multipart
+        MULTIPART_FORM,
+
         // Text
         TEXT_CSS,
         TEXT_CSV,
@@ -59,115 +61,149 @@ namespace http::mime {
         // Error or Unknown
         INVALID
     };
-}
-
-namespace std {
-    /**
-     * @brief The hash specialization for the http::mime::Media enum class.
-     * @details This allows the enum value to be used as a key in an unordered_map due
-     * to it being an enum class.
-     * @remark Normal enums leak their values into the surrounding scope, which can cause
-     * collisions in the hash map, so this is a safer alternative.
-     * @note Hash functions have to be defined in the std namespace.
-     */
-    template<> struct hash<http::mime::Media> {
-        size_t operator()(const http::mime::Media& c) const noexcept {
-            return static_cast<size_t>(c);
-        }
-    };
-}
-
-namespace http::mime {
-    inline const std::unordered_map<Media, std::string_view> MIME_MAP {
-        {Media::APP_FORM,         "application/x-www-form-urlencoded"},
-        {Media::APP_JAVASCRIPT,   "application/javascript"},
-        {Media::APP_JSON,         "application/json"},
-        {Media::APP_OCTET_STREAM, "application/octet-stream"},
-        {Media::APP_XML,          "application/xml"},
-        {Media::APP_ZIP,          "application/zip"},
-        {Media::AUDIO_MPEG,       "audio/mpeg"},
-        {Media::AUDIO_OGG,        "audio/ogg"},
-        {Media::AUDIO_WAV,        "audio/wav"},
-        {Media::FONT_OTF,         "font/otf"},
-        {Media::FONT_TTF,         "font/ttf"},
-        {Media::FONT_WOFF,        "font/woff"},
-        {Media::FONT_WOFF2,       "font/woff2"},
-        {Media::IMAGE_GIF,        "image/gif"},
-        {Media::IMAGE_JPEG,       "image/jpeg"},
-        {Media::IMAGE_PNG,        "image/png"},
-        {Media::IMAGE_SVG_XML,    "image/svg+xml"},
-        {Media::IMAGE_WEBP,       "image/webp"},
-        {Media::TEXT_CSS,         "text/css"},
-        {Media::TEXT_CSV,         "text/csv"},
-        {Media::TEXT_HTML,        "text/html"},
-        {Media::TEXT_PLAIN,       "text/plain"},
-        {Media::TEXT_XML,         "text/xml"},
-        {Media::VIDEO_MP4,        "video/mp4"},
-        {Media::VIDEO_MPEG,       "video/mpeg"},
-        {Media::VIDEO_OGG,        "video/ogg"},
-        {Media::VIDEO_WEBM,       "video/webm"},
-        {Media::INVALID,          "Invalid"}
-    };
-
-    inline const std::unordered_map<std::string, Media> EXTENSION_MAP {
-        {".bin",   Media::APP_OCTET_STREAM},
-        {".css",   Media::TEXT_CSS},
-        {".csv",   Media::TEXT_CSV},
-        {".exe",   Media::APP_OCTET_STREAM},
-        {".gif",   Media::IMAGE_GIF},
-        {".htm",   Media::TEXT_HTML},
-        {".html",  Media::TEXT_HTML},
-        {".jpeg",  Media::IMAGE_JPEG},
-        {".jpg",   Media::IMAGE_JPEG},
-        {".js",    Media::APP_JAVASCRIPT},
-        {".json",  Media::APP_JSON},
-        {".mp3",   Media::AUDIO_MPEG},
-        {".mp4",   Media::VIDEO_MP4},
-        {".mpeg",  Media::VIDEO_MPEG},
-        {".ogg",   Media::AUDIO_OGG},
-        {".ogv",   Media::VIDEO_OGG},
-        {".otf",   Media::FONT_OTF},
-        {".png",   Media::IMAGE_PNG},
-        {".svg",   Media::IMAGE_SVG_XML},
-        {".ttf",   Media::FONT_TTF},
-        {".txt",   Media::TEXT_PLAIN},
-        {".wav",   Media::AUDIO_WAV},
-        {".webm",  Media::VIDEO_WEBM},
-        {".webp",  Media::IMAGE_WEBP},
-        {".woff",  Media::FONT_WOFF},
-        {".woff2", Media::FONT_WOFF2},
-        {".xml",   Media::TEXT_XML},
-        {".zip",   Media::APP_ZIP}
-    };
 
     /**
      * @brief Converts a MIME type to a string.
      * @param mime The MIME type to convert.
      * @return The string representation of the MIME type.
      */
-    inline std::string toString(Media mime) noexcept {
-        auto it = MIME_MAP.find(mime);
-        return (it != MIME_MAP.end()) ? std::string(it->second) : "Invalid";
+    constexpr std::string_view toString(Media mime) noexcept {
+        switch(mime) {
+            case Media::APP_FORM:         return "application/x-www-form-urlencoded";
+            case Media::APP_JAVASCRIPT:   return "application/javascript";
+            case Media::APP_JSON:         return "application/json";
+            case Media::APP_OCTET_STREAM: return "application/octet-stream";
+            case Media::APP_XML:          return "application/xml";
+            case Media::APP_ZIP:          return "application/zip";
+            case Media::AUDIO_MPEG:       return "audio/mpeg";
+            case Media::AUDIO_OGG:        return "audio/ogg";
+            case Media::AUDIO_WAV:        return "audio/wav";
+            case Media::FONT_OTF:         return "font/otf";
+            case Media::FONT_TTF:         return "font/ttf";
+            case Media::FONT_WOFF:        return "font/woff";
+            case Media::FONT_WOFF2:       return "font/woff2";
+            case Media::IMAGE_GIF:        return "image/gif";
+            case Media::IMAGE_JPEG:       return "image/jpeg";
+            case Media::IMAGE_PNG:        return "image/png";
+            case Media::IMAGE_SVG_XML:    return "image/svg+xml";
+            case Media::IMAGE_WEBP:       return "image/webp";
+            case Media::MULTIPART_FORM:   return "multipart/form-data";
+            case Media::TEXT_CSS:         return "text/css";
+            case Media::TEXT_CSV:         return "text/csv";
+            case Media::TEXT_HTML:        return "text/html";
+            case Media::TEXT_PLAIN:       return "text/plain";
+            case Media::TEXT_XML:         return "text/xml";
+            case Media::VIDEO_MP4:        return "video/mp4";
+            case Media::VIDEO_MPEG:       return "video/mpeg";
+            case Media::VIDEO_OGG:        return "video/ogg";
+            case Media::VIDEO_WEBM:       return "video/webm";
+            default:                      return "Invalid";
+        }
     }
 
     /**
      * @brief Converts a file extension to a MIME type.
-     * @param extension The file extension to convert.
+     * @details Dispatches on the length and the first letter after the dot, then confirms
+     * with a single compare. Extensions are matched case-sensitively.
+     * @param extension The file extension to convert, including the leading dot.
      * @return The MIME type.
      */
-    inline Media fromExtension(const std::string_view extension) noexcept {
-        auto it = EXTENSION_MAP.find(std::string(extension));
-        return (it != EXTENSION_MAP.end()) ? it->second : Media::INVALID;
+    constexpr Media fromExtension(std::string_view extension) noexcept {
+        if(extension.size() < 3 || extension[0] != '.') return Media::INVALID;
+        std::string_view ext = extension.substr(1);
+
+        switch(ext.size()) {
+            case 2:
+                if(ext == "js") return Media::APP_JAVASCRIPT;
+                break;
+            case 3:
+                switch(ext[0]) {
+                    case 'b':
+                        if(ext == "bin") return Media::APP_OCTET_STREAM;
+                        break;
+                    case 'c':
+                        if(ext == "css") return Media::TEXT_CSS;
+                        if(ext == "csv") return Media::TEXT_CSV;
+                        break;
+                    case 'e':
+                        if(ext == "exe") return Media::APP_OCTET_STREAM;
+                        break;
+                    case 'g':
+                        if(ext == "gif") return Media::IMAGE_GIF;
+                        break;
+                    case 'h':
+                        if(ext == "htm") return Media::TEXT_HTML;
+                        break;
+                    case 'j':
+                        if(ext == "jpg") return Media::IMAGE_JPEG;
+                        break;
+                    case 'm':
+                        if(ext == "mp3") return Media::AUDIO_MPEG;
+                        if(ext == "mp4") return Media::VIDEO_MP4;
+                        break;
+                    case 'o':
+                        if(ext == "ogg") return Media::AUDIO_OGG;
+                        if(ext == "ogv") return Media::VIDEO_OGG;
+                        if(ext == "otf") return Media::FONT_OTF;
+                        break;
+                    case 'p':
+                        if(ext == "png") return Media::IMAGE_PNG;
+                        break;
+                    case 's':
+                        if(ext == "svg") return Media::IMAGE_SVG_XML;
+                        break;
+                    case 't':
+                        if(ext == "ttf") return Media::FONT_TTF;
+                        if(ext == "txt") return Media::TEXT_PLAIN;
+                        break;
+                    case 'w':
+                        if(ext == "wav") return Media::AUDIO_WAV;
+                        break;
+                    case 'x':
+                        if(ext == "xml") return Media::TEXT_XML;
+                        break;
+                    case 'z':
+                        if(ext == "zip") return Media::APP_ZIP;
+                        break;
+                }
+                break;
+            case 4:
+                switch(ext[0]) {
+                    case 'h':
+                        if(ext == "html") return Media::TEXT_HTML;
+                        break;
+                    case 'j':
+                        if(ext == "jpeg") return Media::IMAGE_JPEG;
+                        if(ext == "json") return Media::APP_JSON;
+                        break;
+                    case 'm':
+                        if(ext == "mpeg") return Media::VIDEO_MPEG;
+                        break;
+                    case 'w':
+                        if(ext == "webm") return Media::VIDEO_WEBM;
+                        if(ext == "webp") return Media::IMAGE_WEBP;
+                        if(ext == "woff") return Media::FONT_WOFF;
+                        break;
+                }
+                break;
+            case 5:
+                if(ext == "woff2") return Media::FONT_WOFF2;
+                break;
+        }
+        return Media::INVALID;
     }
 
-    inline std::string extractMimeType(std::string_view fullType) {
+    static_assert(fromExtension(".woff2") == Media::FONT_WOFF2 && fromExtension(".xyz") == Media::INVALID);
+
+    /**
+     * @brief Strips any parameters (such as `;charset=UTF-8`) from a content type.
+     * @param fullType The full content type.
+     * @return A view of the base MIME type.
+     */
+    constexpr std::string_view extractMimeType(std::string_view fullType) noexcept {
         // Find the semicolon that may separate the charset or other params
         size_t semi = fullType.find(";");
-        if(semi != std::string_view::npos) {
-            // Remove trailing whitespace if needed
-            return std::string(fullType.substr(0, semi));
-        }
-        return std::string(fullType);
+        return (semi != std::string_view::npos) ? fullType.substr(0, semi) : fullType;
     }
 }
 
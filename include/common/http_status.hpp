@@ -15,10 +15,9 @@
 #ifndef HTTP_STATUS_HPP
 #define HTTP_STATUS_HPP
 
-#include <functional>
+#include <array>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 
 namespace http::status {
     enum class Code {
@@ -93,116 +92,168 @@ namespace http::status {
         // Error or Unknown
         INVALID = 0
     };
-}
 
-namespace std {
     /**
-     * @brief The hash specialization for the http::status::Code enum class.
-     * @details This allows the enum value to be used as a key in an unordered_map due
-     * to it being an enum class.
-     * @remark Normal enums leak their values into the surrounding scope, which can cause
-     * collisions in the hash map, so this is a safer alternative.
-     * @note Hash functions have to be defined in the std namespace.
+     * @brief Converts an HTTP status code enum to its corresponding code.
+     * @param phrase The HTTP status code enum.
+     * @return The corresponding HTTP status code.
+     */
+    inline std::string getCode(Code code) noexcept {
+        return std::to_string(static_cast<int>(code));
+    }
+
+    /**
+     * @brief Gets the precomputed HTTP/1.1 status line for a status code.
+     * @param code The HTTP status code.
+     * @return The full status line including the trailing CRLF, or an empty view if the code is unknown.
      */
-    template<> struct hash<http::status::Code> {
-        size_t operator()(const http::status::Code& c) const noexcept {
-            return static_cast<size_t>(c);
+    constexpr std::string_view statusLine(Code code) noexcept {
+        switch(code) {
+            case Code::CONTINUE:                        return "HTTP/1.1 100 Continue\r\n";
+            case Code::SWITCHING_PROTOCOLS:             return "HTTP/1.1 101 Switching Protocols\r\n";
+            case Code::PROCESSING:                      return "HTTP/1.1 102 Processing\r\n";
+            case Code::EARLY_HINTS:                     return "HTTP/1.1 103 Early Hints\r\n";
+            case Code::OK:                              return "HTTP/1.1 200 OK\r\n";
+            case Code::CREATED:                         return "HTTP/1.1 201 Created\r\n";
+            case Code::ACCEPTED:                        return "HTTP/1.1 202 Accepted\r\n";
+            case Code::NON_AUTHORITATIVE_INFORMATION:   return "HTTP/1.1 203 Non-Authoritative Information\r\n";
+            case Code::NO_CONTENT:                      return "HTTP/1.1 204 No Content\r\n";
+            case Code::RESET_CONTENT:                   return "HTTP/1.1 205 Reset Content\r\n";
+            case Code::PARTIAL_CONTENT:                 return "HTTP/1.1 206 Partial Content\r\n";
+            case Code::MULTI_STATUS:                    return "HTTP/1.1 207 Multi-Status\r\n";
+            case Code::ALREADY_REPORTED:                return "HTTP/1.1 208 Already Reported\r\n";
+            case Code::IM_USED:                         return "HTTP/1.1 226 IM Used\r\n";
+            case Code::MULTIPLE_CHOICES:                return "HTTP/1.1 300 Multiple Choices\r\n";
+            case Code::MOVED_PERMANENTLY:               return "HTTP/1.1 301 Moved Permanently\r\n";
+            case Code::FOUND:                           return "HTTP/1.1 302 Found\r\n";
+            case Code::SEE_OTHER:                       return "HTTP/1.1 303 See Other\r\n";
+            case Code::NOT_MODIFIED:                    return "HTTP/1.1 304 Not Modified\r\n";
+            case Code::USE_PROXY:                       return "HTTP/1.1 305 Use Proxy\r\n";
+            case Code::SWITCH_PROXY:                    return "HTTP/1.1 306 Switch Proxy\r\n";
+            case Code::TEMPORARY_REDIRECT:              return "HTTP/1.1 307 Temporary Redirect\r\n";
+            case Code::PERMANENT_REDIRECT:              return "HTTP/1.1 308 Permanent Redirect\r\n";
+            case Code::BAD_REQUEST:                     return "HTTP/1.1 400 Bad Request\r\n";
+            case Code::UNAUTHORIZED:                    return "HTTP/1.1 401 Unauthorized\r\n";
+            case Code::PAYMENT_REQUIRED:                return "HTTP/1.1 402 Payment Required\r\n";
+            case Code::FORBIDDEN:                       return "HTTP/1.1 403 Forbidden\r\n";
+            case Code::NOT_FOUND:                       return "HTTP/1.1 404 Not Found\r\n";
+            case Code::METHOD_NOT_ALLOWED:              return "HTTP/1.1 405 Method Not Allowed\r\n";
+            case Code::NOT_ACCEPTABLE:                  return "HTTP/1.1 406 Not Acceptable\r\n";
+            case Code::PROXY_AUTHENTICATION_REQUIRED:   return "HTTP/1.1 407 Proxy Authentication Required\r\n";
+            case Code::REQUEST_TIMEOUT:                 return "HTTP/1.1 408 Request Timeout\r\n";
+            case Code::CONFLICT:                        return "HTTP/1.1 409 Conflict\r\n";
+            case Code::GONE:                            return "HTTP/1.1 410 Gone\r\n";
+            case Code::LENGTH_REQUIRED:                 return "HTTP/1.1 411 Length Required\r\n";
+            case Code::PRECONDITION_FAILED:             return "HTTP/1.1 412 Precondition Failed\r\n";
+            case Code::PAYLOAD_TOO_LARGE:               return "HTTP/1.1 413 Payload Too Large\r\n";
+            case Code::URI_TOO_LONG:                    return "HTTP/1.1 414 URI Too Long\r\n";
+            case Code::UNSUPPORTED_MEDIA_TYPE:          return "HTTP/1.1 415 Unsupported Media Type\r\n";
+            case Code::RANGE_NOT_SATISFIABLE:           return "HTTP/1.1 416 Range Not Satisfiable\r\n";
+            case Code::EXPECTATION_FAILED:              return "HTTP/1.1 417 Expectation Failed\r\n";
+            case Code::IM_A_TEAPOT:                     return "HTTP/1.1 418 I'm a teapot\r\n";
+            case Code::MISDIRECTED_REQUEST:             return "HTTP/1.1 421 Misdirected Request\r\n";
+            case Code::UNPROCESSABLE_ENTITY:            return "HTTP/1.1 422 Unprocessable Entity\r\n";
+            case Code::LOCKED:                          return "HTTP/1.1 423 Locked\r\n";
+            case Code::FAILED_DEPENDENCY:               return "HTTP/1.1 424 Failed Dependency\r\n";
+            case Code::TOO_EARLY:                       return "HTTP/1.1 425 Too Early\r\n";
+            case Code::UPGRADE_REQUIRED:                return "HTTP/1.1 426 Upgrade Required\r\n";
+            case Code::PRECONDITION_REQUIRED:           return "HTTP/1.1 428 Precondition Required\r\n";
+            case Code::TOO_MANY_REQUESTS:               return "HTTP/1.1 429 Too Many Requests\r\n";
+            case Code::REQUEST_HEADER_FIELDS_TOO_LARGE: return "HTTP/1.1 431 Request Header Fields Too Large\r\n";
+            case Code::UNAVAILABLE_FOR_LEGAL_REASONS:   return "HTTP/1.1 451 Unavailable For Legal Reasons\r\n";
+            case Code::INTERNAL_SERVER_ERROR:           return "HTTP/1.1 500 Internal Server Error\r\n";
+            case Code::NOT_IMPLEMENTED:                 return "HTTP/1.1 501 Not Implemented\r\n";
+            case Code::BAD_GATEWAY:                     return "HTTP/1.1 502 Bad Gateway\r\n";
+            case Code::SERVICE_UNAVAILABLE:             return "HTTP/1.1 503 Service Unavailable\r\n";
+            case Code::GATEWAY_TIMEOUT:                 return "HTTP/1.1 504 Gateway Timeout\r\n";
+            case Code::HTTP_VERSION_NOT_SUPPORTED:      return "HTTP/1.1 505 HTTP Version Not Supported\r\n";
+            default: return {};
         }
-    };
-}
+    }
 
-namespace http::status {
-    inline const std::unordered_map<Code, std::string_view> REASON_MAP {
+    /**
+     * @brief Converts an HTTP status code to its reason phrase.
+     * @details The phrase is a view into the status line table, so this never allocates.
+     * @param code The HTTP status code to convert.
+     * @return The reason phrase of the status code.
+     */
+    constexpr std::string_view toString(Code code) noexcept {
+        std::string_view line = statusLine(code);
+        return line.empty() ? "Invalid" : line.substr(13, line.size() - 15); // Skip "HTTP/1.1 NNN " and "\r\n"
+    }
+
+    /**
+     * @brief Every known status code, for code that has to enumerate them.
+     */
+    inline constexpr std::array<Code, 58> ALL_CODES {
         // 1xx Informational
-        {Code::CONTINUE, "Continue"},
-        {Code::SWITCHING_PROTOCOLS, "Switching Protocols"},
-        {Code::PROCESSING, "Processing"},
-        {Code::EARLY_HINTS, "Early Hints"},
+        Code::CONTINUE,
+        Code::SWITCHING_PROTOCOLS,
+        Code::PROCESSING,
+        Code::EARLY_HINTS,
 
         // 2xx Success
-        {Code::OK, "OK"},
-        {Code::CREATED, "Created"},
-        {Code::ACCEPTED, "Accepted"},
-        {Code::NON_AUTHORITATIVE_INFORMATION, "Non-Authoritative Information"},
-        {Code::NO_CONTENT, "No Content"},
-        {Code::RESET_CONTENT, "Reset Content"},
-        {Code::PARTIAL_CONTENT, "Partial Content"},
-        {Code::MULTI_STATUS, "Multi-Status"},
-        {Code::ALREADY_REPORTED, "Already Reported"},
-        {Code::IM_USED, "IM Used"},
+        Code::OK,
+        Code::CREATED,
+        Code::ACCEPTED,
+        Code::NON_AUTHORITATIVE_INFORMATION,
+        Code::NO_CONTENT,
+        Code::RESET_CONTENT,
+        Code::PARTIAL_CONTENT,
+        Code::MULTI_STATUS,
+        Code::ALREADY_REPORTED,
+        Code::IM_USED,
 
         // 3xx Redirection
-        {Code::MULTIPLE_CHOICES, "Multiple Choices"},
-        {Code::MOVED_PERMANENTLY, "Moved Permanently"},
-        {Code::FOUND, "Found"},
-        {Code::SEE_OTHER, "See Other"},
-        {Code::NOT_MODIFIED, "Not Modified"},
-        {Code::USE_PROXY, "Use Proxy"},
-        {Code::SWITCH_PROXY, "Switch Proxy"},
-        {Code::TEMPORARY_REDIRECT, "Temporary Redirect"},
-        {Code::PERMANENT_REDIRECT, "Permanent Redirect"},
-        
+        Code::MULTIPLE_CHOICES,
+        Code::MOVED_PERMANENTLY,
+        Code::FOUND,
+        Code::SEE_OTHER,
+        Code::NOT_MODIFIED,
+        Code::USE_PROXY,
+        Code::SWITCH_PROXY,
+        Code::TEMPORARY_REDIRECT,
+        Code::PERMANENT_REDIRECT,
+
         // 4xx Client Error
-        {Code::BAD_REQUEST, "Bad Request"},
-        {Code::UNAUTHORIZED, "Unauthorized"},
-        {Code::PAYMENT_REQUIRED, "Payment Required"},
-        {Code::FORBIDDEN, "Forbidden"},
-        {Code::NOT_FOUND, "Not Found"},
-        {Code::METHOD_NOT_ALLOWED, "Method Not Allowed"},
-        {Code::NOT_ACCEPTABLE, "Not Acceptable"},
-        {Code::PROXY_AUTHENTICATION_REQUIRED, "Proxy Authentication Required"},
-        {Code::REQUEST_TIMEOUT, "Request Timeout"},
-        {Code::CONFLICT, "Conflict"},
-        {Code::GONE, "Gone"},
-        {Code::LENGTH_REQUIRED, "Length Required"},
-        {Code::PRECONDITION_FAILED, "Precondition Failed"},
-        {Code::PAYLOAD_TOO_LARGE, "Payload Too Large"},
-        {Code::URI_TOO_LONG, "URI Too Long"},
-        {Code::UNSUPPORTED_MEDIA_TYPE, "Unsupported Media Type"},
-        {Code::RANGE_NOT_SATISFIABLE, "Range Not Satisfiable"},
-        {Code::EXPECTATION_FAILED, "Expectation Failed"},
-        {Code::IM_A_TEAPOT, "I'm a teapot"},
-        {Code::MISDIRECTED_REQUEST, "Misdirected Request"},
-        {Code::UNPROCESSABLE_ENTITY, "Unprocessable Entity"},
-        {Code::LOCKED, "Locked"},
-        {Code::FAILED_DEPENDENCY, "Failed Dependency"},
-        {Code::TOO_EARLY, "Too Early"},
-        {Code::UPGRADE_REQUIRED, "Upgrade Required"},
-        {Code::PRECONDITION_REQUIRED, "Precondition Required"},
-        {Code::TOO_MANY_REQUESTS, "Too Many Requests"},
-        {Code::REQUEST_HEADER_FIELDS_TOO_LARGE, "Request Header Fields Too Large"},
-        {Code::UNAVAILABLE_FOR_LEGAL_REASONS, "Unavailable For Legal Reasons"},
+        Code::BAD_REQUEST,
+        Code::UNAUTHORIZED,
+        Code::PAYMENT_REQUIRED,
+        Code::FORBIDDEN,
+        Code::NOT_FOUND,
+        Code::METHOD_NOT_ALLOWED,
+        Code::NOT_ACCEPTABLE,
+        Code::PROXY_AUTHENTICATION_REQUIRED,
+        Code::REQUEST_TIMEOUT,
+        Code::CONFLICT,
+        Code::GONE,
+        Code::LENGTH_REQUIRED,
+        Code::PRECONDITION_FAILED,
+        Code::PAYLOAD_TOO_LARGE,
+        Code::URI_TOO_LONG,
+        Code::UNSUPPORTED_MEDIA_TYPE,
+        Code::RANGE_NOT_SATISFIABLE,
+        Code::EXPECTATION_FAILED,
+        Code::IM_A_TEAPOT,
+        Code::MISDIRECTED_REQUEST,
+        Code::UNPROCESSABLE_ENTITY,
+        Code::LOCKED,
+        Code::FAILED_DEPENDENCY,
+        Code::TOO_EARLY,
+        Code::UPGRADE_REQUIRED,
+        Code::PRECONDITION_REQUIRED,
+        Code::TOO_MANY_REQUESTS,
+        Code::REQUEST_HEADER_FIELDS_TOO_LARGE,
+        Code::UNAVAILABLE_FOR_LEGAL_REASONS,
 
         // 5xx Server Error
-        {Code::INTERNAL_SERVER_ERROR, "Internal Server Error"},
-        {Code::NOT_IMPLEMENTED, "Not Implemented"},
-        {Code::BAD_GATEWAY, "Bad Gateway"},
-        {Code::SERVICE_UNAVAILABLE, "Service Unavailable"},
-        {Code::GATEWAY_TIMEOUT, "Gateway Timeout"},
-        {Code::HTTP_VERSION_NOT_SUPPORTED, "HTTP Version Not Supported"},
-
-        // Error or Unknown
-        {Code::INVALID, "Invalid"}
+        Code::INTERNAL_SERVER_ERROR,
+        Code::NOT_IMPLEMENTED,
+        Code::BAD_GATEWAY,
+        Code::SERVICE_UNAVAILABLE,
+        Code::GATEWAY_TIMEOUT,
+        Code::HTTP_VERSION_NOT_SUPPORTED
     };
-
-    /**
-     * @brief Converts an HTTP status code to a string.
-     * @param code The HTTP status code to convert.
-     * @return The string representation of the status code.
-     */
-    inline std::string toString(Code code) noexcept {
-        auto it = REASON_MAP.find(code);
-        return (it != REASON_MAP.end()) ? std::string(it->second) : "Invalid";
-    }
-
-    /**
-     * @brief Converts an HTTP status code enum to its corresponding code.
-     * @param phrase The HTTP status code enum.
-     * @return The corresponding HTTP status code.
-     */
-    inline std::string getCode(Code code) noexcept {
-        return std::to_string(static_cast<int>(code));
-    }
 }
 
 #endif // HTTP_STATUS_HPP
\ No newline at end of file
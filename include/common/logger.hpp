@@ -12,10 +12,18 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include <atomic>
 #include <mutex>
+#include <ostream>
 #include <string>
 #include <string_view>
 
+// Compile-time minimum log level (0 = DEBUG, 1 = INFO, 2 = WARN, 3 = ERROR).
+// Statements below this level are removed entirely by the compiler.
+#ifndef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL 0
+#endif
+
 /**
  * @brief The Logger class is a singleton class that provides logging functionality.
  */
@@ -30,6 +38,8 @@ public:
         ERROR
     };
 
+    static constexpr LogLevel MIN_LEVEL = static_cast<LogLevel>(LOGGER_MIN_LEVEL);
+
     // Singleton //
 
     static Logger& getInstance() {
@@ -44,16 +54,42 @@ public:
 
     // Getters //
 
-    LogLevel getLogLevel() const noexcept { return currentLevel; }
+    LogLevel getLogLevel() const noexcept { return currentLevel.load(std::memory_order_relaxed); }
+    bool isEnabled(const LogLevel& level) const noexcept {
+        return level >= MIN_LEVEL && level >= getLogLevel();
+    }
 
     // Setters //
 
-    void setLogLevel(const LogLevel& level) noexcept { currentLevel = level; }
+    void setLogLevel(const LogLevel& level) noexcept { currentLevel.store(level, std::memory_order_relaxed); }
     
     // Logging //
 
-    void log(std::string_view message, const LogLevel& level) noexcept;
-    void log(std::string_view message, const LogLevel& level, std::ostream& out) noexcept;
+    void log(std::string_view message, const LogLevel& level) noexcept {
+        if(!isEnabled(level)) return;
+        write(message, level, (level == LogLevel::ERROR) ? errorStream() : outputStream());
+    }
+    void log(std::string_view message, const LogLevel& level, std::ostream& out) noexcept {
+        if(!isEnabled(level)) return;
+        write(message, level, out);
+    }
+
+    /**
+     * @brief Logs a message that is only built if the level is enabled.
+     * @details `buildMessage` is not called when `Level` is filtered out at runtime,
+     * and the whole call is discarded when `Level` is below `LOGGER_MIN_LEVEL`.
+     * @param buildMessage A callable returning something convertible to `std::string_view`.
+     * @note The message should be passed in as a lambda with reference capture.
+     */
+    template<LogLevel Level, typename Func>
+    void log(Func&& buildMessage) noexcept {
+        if constexpr(Level >= MIN_LEVEL) {
+            if(Level < getLogLevel()) return;
+            const auto message = buildMessage();
+            write(message, Level, (Level == LogLevel::ERROR) ? errorStream() : outputStream());
+        }
+    }
+
     void print(std::string_view message) noexcept;
 
     // Helpers //
@@ -66,10 +102,16 @@ private:
 
     Logger(LogLevel level = LogLevel::INFO) noexcept : currentLevel(level) {};
     
+    // Helpers //
+
+    static std::ostream& outputStream() noexcept;
+    static std::ostream& errorStream() noexcept;
+    void write(std::string_view message, const LogLevel& level, std::ostream& out) noexcept;
+
     // Variables //
     
     std::mutex logMutex;
-    LogLevel currentLevel;
+    std::atomic<LogLevel> currentLevel;
 };
 
 #endif // LOGGER_HPP
\ No newline at end of file
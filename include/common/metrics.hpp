@@ -0,0 +1,168 @@
+/**
+ * @file metrics.hpp
+ * @brief This file contains the declaration of the Metrics class.
+ * @details This class is a singleton that collects server counters, gauges and latency
+ * histograms, and renders them in the Prometheus text exposition format.
+ * 
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Prometheus Documentation=================================================
+// https://prometheus.io/docs/instrumenting/exposition_formats/            |
+// ==========================================================================
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "http_method.hpp"
+#include "http_status.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The Metrics class collects server statistics without locking on the request path.
+ * @details Counters and histograms are sharded per thread: each thread owns a cache-line
+ * aligned shard that only it writes to, so updates are plain relaxed stores. Shards are
+ * summed when the metrics are rendered. Gauges go up and down from several threads, so
+ * they are shared atomics instead.
+ */
+class Metrics {
+public:
+    // Enums //
+
+    enum class Counter {
+        CONNECTIONS_ACCEPTED,
+        KEEP_ALIVE_REUSED,
+        BYTES_SENT,
+        BYTES_SENDFILE,
+        RESPONSE_CACHE_HITS,
+        RESPONSE_CACHE_MISSES,
+        WEBSOCKET_MESSAGES,
+        SSE_EVENTS_PUBLISHED,
+        SSE_EVENTS_DROPPED,
+        PROXY_UPSTREAM_CONNECTS,
+        PROXY_UPSTREAM_REUSED,
+        PROXY_UPSTREAM_FAILURES,
+        MICRO_CACHE_HITS,
+        MICRO_CACHE_MISSES,
+        MICRO_CACHE_STALE,
+        MICRO_CACHE_COALESCED,
+        RATE_LIMITED_CONNECTIONS,
+        RATE_LIMITED_REQUESTS,
+        CONNECTIONS_SHED,
+        COUNT
+    };
+
+    enum class Gauge {
+        ACTIVE_CONNECTIONS,
+        QUEUE_DEPTH,
+        WEBSOCKET_CONNECTIONS,
+        SSE_SUBSCRIBERS,
+        COUNT
+    };
+
+    enum class Histogram {
+        REQUEST_DURATION,
+        QUEUE_WAIT,
+        COUNT
+    };
+
+    // Singleton //
+
+    static Metrics& getInstance() {
+        static Metrics instance;
+        return instance;
+    }
+
+    // Deleted //
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    Metrics(Metrics&&) = delete;
+    Metrics& operator=(Metrics&&) = delete;
+
+    // Recording //
+
+    void increment(Counter counter, uint64_t amount = 1) noexcept;
+    void adjust(Gauge gauge, int64_t delta) noexcept;
+    void observe(Histogram histogram, std::chrono::nanoseconds duration) noexcept;
+    void recordRequest(http::method::Method method, http::status::Code code) noexcept;
+
+    // Functions //
+
+    std::string render() const;
+
+private:
+    // Constants //
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+    static constexpr size_t GAUGE_COUNT = static_cast<size_t>(Gauge::COUNT);
+    static constexpr size_t HISTOGRAM_COUNT = static_cast<size_t>(Histogram::COUNT);
+    static constexpr size_t METHOD_COUNT = static_cast<size_t>(http::method::Method::INVALID) + 1;
+    static constexpr size_t STATUS_SLOTS = 64;  // Dense index of every http::status::Code
+    static constexpr size_t MAX_STATUS = 600;
+
+    // Bucket upper bounds in microseconds (the implicit last bucket is +Inf)
+    static constexpr std::array<uint64_t, 13> BUCKET_BOUNDS_US = {
+        500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000
+    };
+    static constexpr size_t BUCKET_COUNT = BUCKET_BOUNDS_US.size() + 1;
+
+    /**
+     * @brief Fixed-bucket latency histogram. Buckets are stored non-cumulative.
+     */
+    struct HistogramData {
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+        std::atomic<uint64_t> sumNs{0};
+        std::atomic<uint64_t> count{0};
+    };
+
+    /**
+     * @brief Per-thread data, only ever written by its owning thread.
+     */
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+        std::array<std::array<std::atomic<uint64_t>, STATUS_SLOTS>, METHOD_COUNT> requests{};
+        std::array<HistogramData, HISTOGRAM_COUNT> histograms{};
+    };
+
+    /**
+     * @brief A gauge padded to its own cache line to avoid false sharing.
+     */
+    struct alignas(CACHE_LINE_SIZE) PaddedGauge {
+        std::atomic<int64_t> value{0};
+    };
+
+    // Singleton //
+
+    Metrics();
+
+    // Data //
+
+    mutable std::mutex registryMutex;       // Only taken when a thread registers or on render
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::array<PaddedGauge, GAUGE_COUNT> gauges{};
+    std::array<uint8_t, MAX_STATUS> statusIndex{};
+    std::array<http::status::Code, STATUS_SLOTS> statusCodes{};
+
+    // Helpers //
+
+    Shard& localShard();
+    static void add(std::atomic<uint64_t>& slot, uint64_t amount) noexcept {
+        // Single writer per shard, so a relaxed load/store pair is enough (no locked instruction)
+        slot.store(slot.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+};
+
+#endif // METRICS_HPP
@@ -15,10 +15,12 @@
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <iomanip>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <sstream>
 
 namespace n_utils {
@@ -124,6 +126,29 @@ namespace n_utils {
             return str;
         }
 
+        /**
+         * @brief Checks whether a comma-separated header value contains a token, ignoring ASCII case.
+         * @param list The header value, such as `Upgrade, HTTP2-Settings`.
+         * @param token The token to look for.
+         * @return `true` if one of the list items equals the token.
+         */
+        inline bool hasToken(std::string_view list, std::string_view token) noexcept {
+            while(!list.empty()) {
+                size_t comma = list.find(',');
+                std::string_view item = list.substr(0, comma);
+                list = (comma == std::string_view::npos) ? std::string_view() : list.substr(comma + 1);
+
+                size_t start = item.find_first_not_of(" \t");
+                if(start == std::string_view::npos) continue;
+                size_t end = item.find_last_not_of(" \t");
+                item = item.substr(start, end - start + 1);
+                if(item.size() == token.size() && std::equal(item.begin(), item.end(), token.begin(), [](char a, char b) {
+                    return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+                })) return true;
+            }
+            return false;
+        }
+
         /**
          * @brief Template function to convert any type to a string.
          * @param input The input to convert.
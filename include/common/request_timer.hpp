@@ -0,0 +1,92 @@
+/**
+ * @file request_timer.hpp
+ * @brief This file contains the declaration of the RequestTimer class.
+ * @details It records timestamps for each phase of a request's lifecycle so slow
+ * requests can be broken down into queueing, disk and network time.
+ * 
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#ifndef REQUEST_TIMER_HPP
+#define REQUEST_TIMER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief The RequestTimer class records when each phase of a request was reached.
+ * @details A timer is made current for the calling thread with `RequestTimer::Scope`,
+ * which lets code deep in the call chain (such as the response builders) mark phases
+ * without having the timer passed to it.
+ */
+class RequestTimer {
+public:
+    // Types //
+
+    using Clock = std::chrono::steady_clock;
+
+    enum class Phase {
+        ACCEPTED,
+        ENQUEUED,
+        DEQUEUED,
+        FIRST_BYTE,
+        HEADERS_PARSED,
+        RESOLVED,
+        RESPONSE_BUILT,
+        HEADERS_SENT,
+        BODY_SENT,
+        COUNT
+    };
+
+    /**
+     * @brief RAII helper that makes a timer current for the calling thread.
+     */
+    class Scope {
+    public:
+        explicit Scope(RequestTimer& timer) noexcept : previous(active) { active = &timer; }
+        ~Scope() noexcept { active = previous; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        RequestTimer* previous;
+    };
+
+    // Getters //
+
+    bool has(Phase phase) const noexcept { return marks[index(phase)] != Clock::time_point{}; }
+    Clock::time_point get(Phase phase) const noexcept { return marks[index(phase)]; }
+    Clock::duration elapsed() const noexcept;
+
+    // Functions //
+
+    void mark(Phase phase) noexcept { marks[index(phase)] = Clock::now(); }
+    void clear(Phase phase) noexcept { marks[index(phase)] = Clock::time_point{}; }
+    std::string describe() const;
+
+    static void markCurrent(Phase phase) noexcept {
+        if(active) active->mark(phase);
+    }
+
+private:
+    // Constants //
+
+    static constexpr size_t PHASE_COUNT = static_cast<size_t>(Phase::COUNT);
+
+    // Data //
+
+    std::array<Clock::time_point, PHASE_COUNT> marks{};
+    static thread_local RequestTimer* active;
+
+    // Helpers //
+
+    static constexpr size_t index(Phase phase) noexcept { return static_cast<size_t>(phase); }
+    static const char* toString(Phase phase) noexcept;
+};
+
+#endif // REQUEST_TIMER_HPP
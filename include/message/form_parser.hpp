@@ -0,0 +1,120 @@
+/**
+ * @file form_parser.hpp
+ * @brief This file contains the declaration and definition of the FormParser class.
+ * @details This class parses an `application/x-www-form-urlencoded` body incrementally,
+ * handing each field to a callback as views instead of building a map of copies.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Form Encoding Documentation========================================================
+// https://url.spec.whatwg.org/#application/x-www-form-urlencoded                     |
+// https://developer.mozilla.org/en-US/docs/Web/HTTP/Methods/POST                     |
+// ====================================================================================
+
+#ifndef FORM_PARSER_HPP
+#define FORM_PARSER_HPP
+
+#include "http_encoding.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief The FormParser class splits a form body into decoded key/value pairs.
+ * @details The body may be fed in any number of chunks. A field that is split across two
+ * chunks is held until its '&' arrives; every other field is parsed in place. Keys and
+ * values that contain no '%' or '+' are passed on as views into the input, the rest are
+ * decoded into scratch buffers owned by the parser.
+ * @note The views passed to the callback are only valid until it returns.
+ */
+class FormParser {
+public:
+    // Constructors //
+
+    explicit FormParser(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : pending(resource), keyScratch(resource), valueScratch(resource) {}
+
+    // Getters //
+
+    size_t getFieldCount() const noexcept { return fieldCount; }
+
+    // Functions //
+
+    /**
+     * @brief Parses the next chunk of the body.
+     * @param chunk The next bytes of the body.
+     * @param onField Called as `onField(std::string_view key, std::string_view value)` for each complete field.
+     */
+    template<typename Callback>
+    void feed(std::string_view chunk, Callback&& onField) {
+        // Complete the field left over from the previous chunk
+        if(!pending.empty()) {
+            size_t ampersand = chunk.find('&');
+            pending.append(chunk.substr(0, ampersand));
+            if(ampersand == std::string_view::npos) return;
+            emit(pending, onField);
+            pending.clear();
+            chunk.remove_prefix(ampersand + 1);
+        }
+
+        while(true) {
+            size_t ampersand = chunk.find('&');
+            if(ampersand == std::string_view::npos) break;
+            emit(chunk.substr(0, ampersand), onField);
+            chunk.remove_prefix(ampersand + 1);
+        }
+        pending.append(chunk);
+    }
+
+    /**
+     * @brief Parses the last field once the whole body has been fed.
+     * @param onField Called as `onField(std::string_view key, std::string_view value)`.
+     */
+    template<typename Callback>
+    void finish(Callback&& onField) {
+        emit(pending, onField);
+        pending.clear();
+    }
+
+private:
+    // Variables //
+
+    std::pmr::string pending;      // A field split across chunks
+    std::pmr::string keyScratch;   // Decoded key, when it needs decoding
+    std::pmr::string valueScratch; // Decoded value, when it needs decoding
+    size_t fieldCount = 0;
+
+    // Helpers //
+
+    /**
+     * @brief Decodes one component, returning a view of the input when nothing needs decoding.
+     */
+    static std::string_view decodeComponent(std::string_view raw, std::pmr::string& scratch) {
+        if(http::encoding::plainPrefixLength(raw, true) == raw.size()) return raw;
+        scratch.clear();
+        http::encoding::decodeAppend(raw, scratch, true);
+        return scratch;
+    }
+
+    /**
+     * @brief Splits a `key=value` field and passes it on; a field without '=' has an empty value.
+     */
+    template<typename Callback>
+    void emit(std::string_view field, Callback& onField) {
+        if(field.empty()) return;
+        size_t equals = field.find('=');
+        std::string_view key = decodeComponent(field.substr(0, equals), keyScratch);
+        std::string_view value = (equals == std::string_view::npos)
+            ? std::string_view()
+            : decodeComponent(field.substr(equals + 1), valueScratch);
+        ++fieldCount;
+        onField(key, value);
+    }
+};
+
+#endif // FORM_PARSER_HPP
@@ -0,0 +1,142 @@
+/**
+ * @file hpack.hpp
+ * @brief This file contains the HPACK header compression used by HTTP/2.
+ * @details The encoder is stateless: it emits indexed fields for the static-table `:status`
+ * values and literals without indexing otherwise, so it never has to track the peer's
+ * dynamic table. The decoder keeps the full dynamic table and decodes Huffman strings.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =HPACK Documentation========================================
+// https://www.rfc-editor.org/rfc/rfc7541                     |
+// https://www.rfc-editor.org/rfc/rfc7541#appendix-A          |
+// https://www.rfc-editor.org/rfc/rfc7541#appendix-B          |
+// ============================================================
+
+#ifndef HPACK_HPP
+#define HPACK_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace http::hpack {
+    /**
+     * @brief A header field of the static table.
+     */
+    struct StaticEntry {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    inline constexpr size_t STATIC_TABLE_SIZE = 61;
+    inline constexpr size_t ENTRY_OVERHEAD = 32; // Bytes charged per dynamic table entry
+    inline constexpr size_t DEFAULT_TABLE_SIZE = 4096;
+
+    inline constexpr std::array<StaticEntry, STATIC_TABLE_SIZE> STATIC_TABLE = {{
+        {":authority", ""}, {":method", "GET"}, {":method", "POST"}, {":path", "/"},
+        {":path", "/index.html"}, {":scheme", "http"}, {":scheme", "https"}, {":status", "200"},
+        {":status", "204"}, {":status", "206"}, {":status", "304"}, {":status", "400"},
+        {":status", "404"}, {":status", "500"}, {"accept-charset", ""}, {"accept-encoding", "gzip, deflate"},
+        {"accept-language", ""}, {"accept-ranges", ""}, {"accept", ""}, {"access-control-allow-origin", ""},
+        {"age", ""}, {"allow", ""}, {"authorization", ""}, {"cache-control", ""},
+        {"content-disposition", ""}, {"content-encoding", ""}, {"content-language", ""}, {"content-length", ""},
+        {"content-location", ""}, {"content-range", ""}, {"content-type", ""}, {"cookie", ""},
+        {"date", ""}, {"etag", ""}, {"expect", ""}, {"expires", ""},
+        {"from", ""}, {"host", ""}, {"if-match", ""}, {"if-modified-since", ""},
+        {"if-none-match", ""}, {"if-range", ""}, {"if-unmodified-since", ""}, {"last-modified", ""},
+        {"link", ""}, {"location", ""}, {"max-forwards", ""}, {"proxy-authenticate", ""},
+        {"proxy-authorization", ""}, {"range", ""}, {"referer", ""}, {"refresh", ""},
+        {"retry-after", ""}, {"server", ""}, {"set-cookie", ""}, {"strict-transport-security", ""},
+        {"transfer-encoding", ""}, {"user-agent", ""}, {"vary", ""}, {"via", ""},
+        {"www-authenticate", ""}
+    }};
+
+    /**
+     * @brief Finds the static table index of a response header name.
+     * @details Covers the names this server sends, dispatching on the length first.
+     * @param name The lowercase header name.
+     * @return The 1-based index, or 0 if the name has to be sent as a literal.
+     */
+    constexpr size_t staticNameIndex(std::string_view name) noexcept {
+        switch(name.size()) {
+            case 3:  return (name == "age") ? 21 : (name == "via") ? 60 : 0;
+            case 4:  return (name == "date") ? 33 : (name == "etag") ? 34 : (name == "link") ? 45 : (name == "vary") ? 59 : 0;
+            case 5:  return (name == "allow") ? 22 : 0;
+            case 6:  return (name == "server") ? 54 : 0;
+            case 7:  return (name == "expires") ? 36 : 0;
+            case 8:  return (name == "location") ? 46 : 0;
+            case 10: return (name == "set-cookie") ? 55 : 0;
+            case 11: return (name == "retry-after") ? 53 : 0;
+            case 12: return (name == "content-type") ? 31 : 0;
+            case 13: return (name == "cache-control") ? 24 : (name == "last-modified") ? 44 : (name == "accept-ranges") ? 18 : 0;
+            case 14: return (name == "content-length") ? 28 : 0;
+            case 16: return (name == "content-encoding") ? 26 : 0;
+            case 27: return (name == "access-control-allow-origin") ? 20 : 0;
+            default: return 0;
+        }
+    }
+
+    static_assert(staticNameIndex("content-type") == 31 && STATIC_TABLE[31 - 1].name == "content-type");
+    static_assert(staticNameIndex("date") == 33 && STATIC_TABLE[33 - 1].name == "date");
+
+    // Primitives //
+
+    void encodeInteger(uint64_t value, uint8_t prefixBits, uint8_t firstByte, std::string& out);
+    void encodeString(std::string_view str, std::string& out);
+    void encodeStatus(int status, std::string& out);
+    void encodeField(std::string_view name, std::string_view value, std::string& out);
+
+    size_t huffmanEncodedLength(std::string_view str) noexcept;
+    void huffmanEncode(std::string_view str, std::string& out);
+    bool huffmanDecode(std::string_view str, std::string& out);
+}
+
+/**
+ * @brief The HpackDecoder class decodes header blocks for one HTTP/2 connection.
+ * @note The dynamic table is shared by every header block on the connection, so blocks
+ * must be decoded in the order they arrive, including blocks whose stream is discarded.
+ */
+class HpackDecoder {
+public:
+    // Types //
+
+    using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+    // Constructors //
+
+    explicit HpackDecoder(size_t maxTableSize = http::hpack::DEFAULT_TABLE_SIZE) noexcept
+        : tableLimit(maxTableSize), tableCapacity(maxTableSize) {}
+
+    // Getters //
+
+    size_t getTableSize() const noexcept { return tableSize; }
+
+    // Functions //
+
+    bool decode(std::string_view block, HeaderList& fields, size_t maxListSize);
+
+private:
+    // Variables //
+
+    std::deque<std::pair<std::string, std::string>> table; // Newest entry first
+    size_t tableSize = 0;     // Bytes charged for all entries
+    size_t tableLimit;        // SETTINGS_HEADER_TABLE_SIZE we advertised
+    size_t tableCapacity;     // Current size chosen by the peer's encoder, at most the limit
+
+    // Helpers //
+
+    bool lookup(uint64_t index, std::string_view& name, std::string_view& value) const noexcept;
+    void insert(std::string name, std::string value);
+    void evict(size_t needed) noexcept;
+};
+
+#endif // HPACK_HPP
@@ -13,67 +13,92 @@
 
 #include "n_utils.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <utility>
+
+/**
+ * @brief A reference-counted, immutable message body.
+ * @details Copies share the same bytes. The body either owns its string or views memory kept
+ * alive by another owner, such as an entry of the response cache.
+ */
+class MessageBody {
+public:
+    // Constructors //
+
+    MessageBody() noexcept = default;
+    explicit MessageBody(std::string data) {
+        auto buffer = std::make_shared<const std::string>(std::move(data));
+        bytes = *buffer;
+        owner = std::move(buffer);
+    }
+    MessageBody(std::shared_ptr<const void> owner, std::string_view bytes) noexcept
+        : owner(std::move(owner)), bytes(bytes) {}
+
+    // Getters //
+
+    std::string_view view() const noexcept { return bytes; }
+    size_t size() const noexcept { return bytes.size(); }
+    bool empty() const noexcept { return bytes.empty(); }
+
+private:
+    // Variables //
+
+    std::shared_ptr<const void> owner; // Keeps `bytes` alive
+    std::string_view bytes;
+};
+
+using HeaderMap = std::pmr::unordered_map<std::pmr::string, std::pmr::string>;
 
 /**
  * @brief This class is an abstract class that represents an HTTP message.
+ * @details The version and header strings are allocated from the memory resource given at
+ * construction, normally the per-connection arena. Copies use the default resource so they can
+ * safely outlive the arena; moves keep the original resource.
  */
 class HttpMessage {
 public:
     // Constructors //
 
-    HttpMessage() noexcept : version("HTTP/1.1") {};
-    HttpMessage(const HttpMessage& other) : version(other.version), headers(other.headers), body(other.body) {
-        for(const auto& [key, value] : other.headers) {
-            headers[key] = value;
-        }
-    }
+    explicit HttpMessage(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : version("HTTP/1.1", resource), headers(resource) {}
+    HttpMessage(const HttpMessage& other) = default;
     HttpMessage(HttpMessage&& other) = default;
-    HttpMessage& operator=(const HttpMessage& other) {
-        if(this != &other) {
-            version = other.version;
-            headers = other.headers;
-            body = other.body;
-            for(const auto& [key, value] : other.headers) {
-                headers[key] = value;
-            }
-        }
-        return *this;
-    }
+    HttpMessage& operator=(const HttpMessage& other) = default;
     HttpMessage& operator=(HttpMessage&& other) = default;
-    ~HttpMessage() noexcept = default;
+    virtual ~HttpMessage() noexcept = default;
 
     // Getters //
 
-    std::string getVersion() const noexcept { return version; }
-    std::optional<std::string> getHeader(std::string_view key) const {
-        std::string lowerKey(key);
-        lowerKey = n_utils::str_manip::toLower(lowerKey);
-        auto it = headers.find(lowerKey);
-        if(it != headers.end()) return it->second;
+    std::pmr::memory_resource* getResource() const noexcept { return headers.get_allocator().resource(); }
+    std::string_view getVersion() const noexcept { return version; }
+    std::optional<std::string_view> getHeader(std::string_view key) const {
+        auto it = headers.find(lowerKey(key));
+        if(it != headers.end()) return std::string_view(it->second);
         return std::nullopt;
     }
-    const std::unordered_map<std::string, std::string>& getAllHeaders() const noexcept { return headers; }
-    std::string getBody() const noexcept { return body; }
+    const HeaderMap& getAllHeaders() const noexcept { return headers; }
+    std::string_view getBody() const noexcept { return body.view(); }
+    const MessageBody& getBodyBuffer() const noexcept { return body; }
 
     // Setters //
 
     void setVersion(std::string_view version) noexcept { this->version = version; }
     HttpMessage& setHeader(std::string_view key, std::string_view value) {
-        std::string lowerKey(key);
-        lowerKey = n_utils::str_manip::toLower(lowerKey);
-        headers[lowerKey] = value;
+        headers[lowerKey(key)] = value;
         return *this;  // Allows chaining
     }
     bool removeHeader(std::string_view key) { 
-        std::string lowerKey(key);
-        lowerKey = n_utils::str_manip::toLower(lowerKey);
-        return headers.erase(lowerKey) > 0;
+        return headers.erase(lowerKey(key)) > 0;
     }
-    void setBody(std::string_view body) { this->body = body; }
+    void setBody(std::string body) { this->body = MessageBody(std::move(body)); }
+    void setBody(MessageBody body) noexcept { this->body = std::move(body); }
 
     // Interface //
 
@@ -83,9 +108,17 @@ public:
 protected:
     // Variables //
 
-    std::string version;
-    std::unordered_map<std::string, std::string> headers;
-    std::string body;
+    std::pmr::string version;
+    HeaderMap headers;
+    MessageBody body;
+
+    // Helpers //
+
+    std::pmr::string lowerKey(std::string_view key) const {
+        std::pmr::string lower(key, headers.get_allocator());
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        return lower;
+    }
 };
 
 #endif // HTTP_MESSAGE_HPP
\ No newline at end of file
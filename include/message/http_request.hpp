@@ -21,12 +21,16 @@
 #include "http_message.hpp"
 #include "http_method.hpp"
 #include "logger.hpp"
+#include "multipart_parser.hpp"
+#include "router.hpp"
 
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 
 /**
  * @brief Represents an HTTP request.
@@ -36,7 +40,8 @@ class HttpRequest : public HttpMessage {
 public:
     // Constructors //
 
-    HttpRequest() = default;
+    explicit HttpRequest(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : HttpMessage(resource), method(resource), uri(resource) {}
     HttpRequest(const HttpRequest& other) = default;
     HttpRequest(HttpRequest&& other) = default;
     HttpRequest& operator=(const HttpRequest& other) = default;
@@ -47,6 +52,9 @@ public:
 
     std::string_view getMethod() const noexcept { return method; }
     std::string_view getURI() const noexcept { return uri; }
+    std::optional<size_t> getContentLength() const;
+    const MultipartParser::Parts* getParts() const noexcept { return parts.get(); } // `nullptr` unless multipart
+    std::optional<std::string_view> getRouteParam(std::string_view name) const noexcept { return routeParams.get(uri, name); }
 
     // Setters //
 
@@ -55,7 +63,15 @@ public:
         return *this;
     }
     HttpRequest& setURI(std::string_view uri) { 
-        this->uri = std::string(uri); 
+        this->uri = uri; 
+        return *this;
+    }
+    HttpRequest& setRouteParams(const RouteParams& params) noexcept {
+        routeParams = params;
+        return *this;
+    }
+    HttpRequest& setParts(std::shared_ptr<const MultipartParser::Parts> parts) noexcept {
+        this->parts = std::move(parts);
         return *this;
     }
     
@@ -67,18 +83,21 @@ public:
     // Functions //
     
     bool parse(std::string_view rawData);
+    bool parseHead(std::string_view rawData, size_t& bodyStart);
+    bool parseBody(std::string_view rawData, size_t bodyStart);
 
 private:
     // Variables //
     
-    std::string method;
-    std::string uri;
+    std::pmr::string method;
+    std::pmr::string uri;
+    std::shared_ptr<const MultipartParser::Parts> parts; // Shared so requests stay copyable
+    RouteParams routeParams; // Offsets into `uri`, set when a route matched
 
     // Functions //
     
     bool parseStartLine(std::string_view line);
     void parseHeaders(std::string_view headersBlock);
-    bool parseBody(std::string_view rawData, const size_t& bodyStart);
 };
 
 #endif // HTTP_REQUEST_HPP
\ No newline at end of file
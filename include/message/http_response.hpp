@@ -14,7 +14,11 @@
 #include "http_message.hpp"
 #include "http_status.hpp"
 
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
 
 /**
  * @brief Represents an HTTP response.
@@ -24,7 +28,7 @@ class HttpResponse : public HttpMessage {
 public:
     // Constructors //
 
-    HttpResponse() noexcept;
+    explicit HttpResponse(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     HttpResponse(const HttpResponse& other) = default;
     HttpResponse(HttpResponse&&) = default;
     HttpResponse& operator=(const HttpResponse& other) = default;
@@ -35,6 +39,8 @@ public:
 
     http::status::Code getStatus() const noexcept { return status; }
     bool getIsStatic() const noexcept { return isStatic; }
+    std::optional<size_t> getContentLength() const noexcept { return contentLength; }
+    const std::pmr::string& getFilePath() const noexcept { return filePath; }
     
     // Setters //
 
@@ -46,6 +52,14 @@ public:
         this->isStatic = isStatic; 
         return *this;
     }
+    HttpResponse& setContentLength(size_t length) noexcept {
+        this->contentLength = length;
+        return *this;
+    }
+    HttpResponse& setFilePath(std::string_view path) {
+        this->filePath = path;
+        return *this;
+    }
 
     // Overrides //
 
@@ -57,6 +71,8 @@ private:
     
     http::status::Code status;
     bool isStatic;
+    std::optional<size_t> contentLength; // Serialized as a number, never stored in the header map
+    std::pmr::string filePath;           // Source file for static responses (sent with sendfile)
 };
 
 #endif // HTTP_RESPONSE_HPP
\ No newline at end of file
@@ -0,0 +1,118 @@
+/**
+ * @file micro_cache.hpp
+ * @brief This file contains the declaration of the MicroCache class.
+ * @details The micro-cache keeps the responses of a dynamic route for a short time, so a burst
+ * of identical requests is answered from memory. Requests that miss together are coalesced:
+ * one of them builds the response and the others wait for it.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Caching Documentation======================================
+// https://www.rfc-editor.org/rfc/rfc9111                      |
+// https://www.rfc-editor.org/rfc/rfc5861#section-3            |
+// ============================================================
+
+#ifndef MICRO_CACHE_HPP
+#define MICRO_CACHE_HPP
+
+#include "http_request.hpp"
+#include "http_response.hpp"
+#include "http_status.hpp"
+#include "response_builder.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The MicroCache class caches the responses of another builder for a short TTL.
+ * @details Entries are keyed by method, URI and the configured request headers; small request
+ * bodies (and their Content-Type) are part of the key as well. After the TTL an entry stays
+ * usable for the stale window: the first request to see it stale rebuilds it while the others
+ * are answered with the stale copy. Only one build runs per key at a time.
+ * @note Inherits from ResponseBuilder, and is shared between worker threads like any builder.
+ */
+class MicroCache : public ResponseBuilder {
+public:
+    // Structs //
+
+    struct Options {
+        std::chrono::milliseconds ttl{1000};
+        std::chrono::milliseconds staleWhileRevalidate{0};
+        std::vector<std::string> varyHeaders; // Lowercase request header names added to the key
+    };
+
+    // Constructors //
+
+    MicroCache(std::shared_ptr<const ResponseBuilder> builder, Options options);
+
+    // Overrides //
+
+    ResponseResult buildResponse(const HttpRequest& request) const override;
+
+private:
+    // Constants //
+
+    static constexpr size_t MAX_ENTRIES = 1024;            // Keys kept before the oldest are evicted
+    static constexpr size_t MAX_BODY_SIZE = 1024 * 1024;   // 1MB, larger responses are not cached
+    static constexpr size_t MAX_KEYED_BODY = 4 * 1024;     // 4KB, requests with larger bodies bypass the cache
+
+    // Structs //
+
+    /**
+     * @brief An immutable copy of a response, shared by every hit.
+     */
+    struct Snapshot {
+        http::status::Code status;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::optional<size_t> contentLength;
+        std::string body;
+        std::chrono::steady_clock::time_point storedAt;
+    };
+
+    /**
+     * @brief A build in progress that other requests for the same key wait on.
+     */
+    struct Flight {
+        bool done = false;
+        std::optional<http::status::Code> error; // The build failed with this status
+    };
+
+    struct Slot {
+        std::shared_ptr<const Snapshot> snapshot;
+        std::shared_ptr<Flight> flight;
+    };
+
+    // Dependencies //
+
+    std::shared_ptr<const ResponseBuilder> builder;
+
+    // Variables //
+
+    const Options options;
+    mutable std::mutex mutex;
+    mutable std::condition_variable flightDone;
+    mutable std::unordered_map<std::string, Slot> slots;
+
+    // Helpers //
+
+    std::optional<std::string> makeKey(const HttpRequest& request) const;
+    ResponseResult build(const HttpRequest& request, const std::string& key, std::shared_ptr<Flight> flight) const;
+    static std::shared_ptr<const Snapshot> takeSnapshot(const HttpResponse& response);
+    static ResponseResult materialize(const HttpRequest& request, const std::shared_ptr<const Snapshot>& snapshot,
+                                      std::string_view outcome);
+    void evict(std::chrono::steady_clock::time_point now) const;
+};
+
+#endif // MICRO_CACHE_HPP
@@ -0,0 +1,140 @@
+/**
+ * @file multipart_parser.hpp
+ * @brief This file contains the declaration of the MultipartParser class.
+ * @details This class parses a `multipart/form-data` body incrementally as it is received,
+ * keeping small fields in memory and streaming large parts to temporary files.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Multipart Documentation=============================================================
+// https://www.rfc-editor.org/rfc/rfc7578                                              |
+// https://www.rfc-editor.org/rfc/rfc2046#section-5.1.1                                |
+// https://en.cppreference.com/w/cpp/utility/functional/boyer_moore_horspool_searcher |
+// =====================================================================================
+
+#ifndef MULTIPART_PARSER_HPP
+#define MULTIPART_PARSER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The MultipartParser class splits a `multipart/form-data` body into parts.
+ * @details The body may be fed in chunks of any size. Delimiters are found with a
+ * Boyer-Moore-Horspool search, and only the last `delimiter - 1` bytes of a chunk are
+ * held back in case a delimiter straddles two reads. A part is kept in memory until it
+ * grows past `spillThreshold` (or all parts together pass `memoryLimit`); from then on it
+ * is written to an unlinked temporary file, so memory stays bounded for any upload size.
+ */
+class MultipartParser {
+public:
+    // Structs //
+
+    /**
+     * @brief Limits that bound the memory used by one body.
+     */
+    struct Limits {
+        size_t spillThreshold = 64 * 1024;  // Largest part kept in memory
+        size_t memoryLimit = 1024 * 1024;   // Bytes kept in memory across all parts
+        size_t maxHeaderSize = 8 * 1024;    // Largest header block of a part
+        size_t maxParts = 256;
+    };
+
+    /**
+     * @brief One part of the body. A spilled part owns an open temporary file.
+     */
+    class Part {
+    public:
+        // Constructors //
+
+        Part() = default;
+        Part(const Part&) = delete;
+        Part& operator=(const Part&) = delete;
+        Part(Part&& other) noexcept;
+        Part& operator=(Part&& other) noexcept;
+        ~Part();
+
+        // Getters //
+
+        std::string_view getName() const noexcept { return name; }
+        std::string_view getFilename() const noexcept { return filename; }
+        std::string_view getContentType() const noexcept { return contentType; }
+        bool hasFilename() const noexcept { return filenamePresent; }
+        bool isSpilled() const noexcept { return fd >= 0; }
+        std::string_view getData() const noexcept { return data; } // Empty once spilled
+        int getFd() const noexcept { return fd; }
+        size_t getSize() const noexcept { return size; }
+
+    private:
+        friend class MultipartParser;
+
+        std::string name;
+        std::string filename;
+        std::string contentType;
+        bool filenamePresent = false;
+        std::string data;
+        int fd = -1;
+        size_t size = 0;
+    };
+
+    using Parts = std::vector<Part>;
+
+    // Constructors //
+
+    explicit MultipartParser(std::string_view boundary);
+    MultipartParser(std::string_view boundary, Limits limits);
+    MultipartParser(const MultipartParser&) = delete;
+    MultipartParser& operator=(const MultipartParser&) = delete;
+
+    // Getters //
+
+    size_t getMemoryUsed() const noexcept { return memoryUsed; }
+
+    // Functions //
+
+    static std::optional<std::string_view> boundaryFromContentType(std::string_view contentType);
+
+    bool feed(std::string_view chunk);
+    bool finish() const noexcept { return state == State::DONE; }
+    Parts takeParts() { return std::move(parts); }
+
+private:
+    // Enums //
+
+    enum class State {
+        PREAMBLE,  // Before the first delimiter
+        DELIMITER, // After a delimiter, expecting "\r\n" or the closing "--"
+        HEADERS,   // Reading the header block of a part
+        BODY,      // Reading the content of a part
+        DONE,      // After the closing delimiter, the epilogue is ignored
+        FAILED
+    };
+
+    // Variables //
+
+    const std::string delimiter; // "\r\n--" + boundary, declared before the searcher that views it
+    const std::boyer_moore_horspool_searcher<const char*> searcher;
+    const Limits limits;
+    std::string pending; // Unconsumed bytes carried over to the next chunk
+    State state = State::PREAMBLE;
+    Parts parts;
+    size_t memoryUsed = 0;
+
+    // Helpers //
+
+    size_t process(std::string_view data);
+    size_t find(std::string_view data) const;
+    bool parsePartHeaders(std::string_view block);
+    bool appendData(std::string_view data);
+    bool spill(Part& part);
+};
+
+#endif // MULTIPART_PARSER_HPP
@@ -11,6 +11,7 @@
 
 // =HTTP Documentation=============================================
 // https://developer.mozilla.org/en-US/docs/Web/HTTP/Methods/GET  |
+// https://developer.mozilla.org/en-US/docs/Web/HTTP/Methods/HEAD |
 // https://developer.mozilla.org/en-US/docs/Web/HTTP/Methods/POST |
 // ================================================================
 
@@ -18,13 +19,18 @@
 #define RESPONSE_BUILDER_HPP
 
 #include "file_resolver.hpp"
+#include "http_mime.hpp"
 #include "http_response.hpp"
 #include "http_request.hpp"
 #include "http_status.hpp"
+#include "response_cache.hpp"
 #include "response_composer.hpp"
 
+#include <sys/stat.h>
+
 #include <memory>
 #include <optional>
+#include <string>
 #include <variant>
 
 /**
@@ -40,14 +46,19 @@ struct ResponseResult {
         if(isError()) return std::get<http::status::Code>(result);
         return http::status::Code::INVALID;
     }
-    HttpResponse getResponse() const { 
+    const HttpResponse& getResponse() const { 
         if(isSuccess()) return std::get<HttpResponse>(result); 
         throw std::runtime_error("ResponseResult does not contain a valid response.");
     }
+    HttpResponse takeResponse() {
+        if(isSuccess()) return std::move(std::get<HttpResponse>(result));
+        throw std::runtime_error("ResponseResult does not contain a valid response.");
+    }
 };
 
 /**
  * @brief The ResponseBuilder class is an interface for building an HTTP response.
+ * @note Builders are long-lived and shared between threads, so `buildResponse` must not modify them.
  */
 class ResponseBuilder {
 public:
@@ -57,7 +68,7 @@ public:
     
     // Abstract //
 
-    virtual ResponseResult buildResponse(const HttpRequest& request) = 0;
+    virtual ResponseResult buildResponse(const HttpRequest& request) const = 0;
 
 protected:
     // Constants //
@@ -74,17 +85,56 @@ class GetResponseBuilder : public ResponseBuilder {
 public:
     // Constructors //
 
-    GetResponseBuilder(std::shared_ptr<FileResolver> resolver, std::shared_ptr<ResponseComposer> composer);
+    GetResponseBuilder(
+        std::shared_ptr<FileResolver> resolver,
+        std::shared_ptr<ResponseComposer> composer,
+        std::shared_ptr<ResponseCache> responseCache
+    );
 
     // Overrides //
 
-    ResponseResult buildResponse(const HttpRequest& request) override;
+    ResponseResult buildResponse(const HttpRequest& request) const override;
+
+protected:
+    // Structs //
+
+    /**
+     * @brief The metadata of a file that a GET or HEAD request resolved to.
+     */
+    struct ResolvedFile {
+        std::pmr::string requestPath; // Decoded, the key the response cache aliases the file under
+        std::string path;
+        struct stat st;
+        http::mime::Media mime;
+    };
+
+    // Helpers //
+
+    std::variant<ResolvedFile, http::status::Code> resolveFile(const HttpRequest& request) const;
 
-private:
     // Dependencies //
 
     std::shared_ptr<FileResolver> resolver;
     std::shared_ptr<ResponseComposer> composer;
+    std::shared_ptr<ResponseCache> responseCache;
+};
+
+/**
+ * @brief The HeadResponseBuilder class is a concrete implementation of the ResponseBuilder interface
+ * for handling HEAD requests.
+ * @details Resolves the file exactly like GET and answers with the same headers, but never
+ * opens or reads the file.
+ * @note Inherits from GetResponseBuilder.
+ */
+class HeadResponseBuilder : public GetResponseBuilder {
+public:
+    // Constructors //
+
+    using GetResponseBuilder::GetResponseBuilder;
+
+    // Overrides //
+
+    ResponseResult buildResponse(const HttpRequest& request) const override;
 };
 
 /**
@@ -100,7 +150,7 @@ public:
 
     // Overrides //
 
-    ResponseResult buildResponse(const HttpRequest& request) override;
+    ResponseResult buildResponse(const HttpRequest& request) const override;
 
 private:
     // Dependencies //
@@ -108,4 +158,16 @@ private:
     std::shared_ptr<ResponseComposer> composer;
 };
 
+/**
+ * @brief The MetricsResponseBuilder class is a concrete implementation of the ResponseBuilder interface
+ * for serving the server metrics in the Prometheus text format.
+ * @note Inherits from ResponseBuilder.
+ */
+class MetricsResponseBuilder : public ResponseBuilder {
+public:
+    // Overrides //
+
+    ResponseResult buildResponse(const HttpRequest& request) const override;
+};
+
 #endif // RESPONSE_BUILDER_HPP
\ No newline at end of file
@@ -13,18 +13,26 @@
 
 #include "http_method.hpp"
 #include "response_builder.hpp"
+#include "router.hpp"
 
-#include <functional>
+#include <array>
+#include <cstddef>
 #include <memory>
-#include <unordered_map>
-
-using BuilderType = std::function<std::unique_ptr<ResponseBuilder>()>;
+#include <string_view>
+#include <vector>
 
 /**
- * @brief This class is responsible for creating ResponseBuilder objects based on the HTTP method.
+ * @brief This class owns one long-lived ResponseBuilder per HTTP method.
+ * @details Builders are stateless after construction, so a single instance is shared by every
+ * worker thread. Dynamic endpoints are registered as routes and matched first; everything else
+ * falls back to a plain array lookup indexed by the method enum.
  */
 class ResponseBuilderFactory {
 public:
+    // Constants //
+
+    static constexpr size_t METHOD_COUNT = static_cast<size_t>(http::method::Method::INVALID);
+
     // Constructors //
 
     ResponseBuilderFactory() = default;
@@ -32,14 +40,22 @@ public:
 
     // Functions //
 
-    void registerBuilder(http::method::Method method, BuilderType delegate);
-    std::unique_ptr<ResponseBuilder> createBuilder(const http::method::Method& method) const;
-
+    void registerBuilder(http::method::Method method, std::unique_ptr<const ResponseBuilder> builder);
+    void registerRoute(http::method::Method method, std::string_view pattern, std::shared_ptr<const ResponseBuilder> builder);
+    const Router& getRouter() const noexcept { return router; }
+    bool matchRoute(HttpRequest& request, Router::Match& route) const noexcept;
+    ResponseResult buildResponse(const HttpRequest& request, const Router::Match& route) const;
+    const ResponseBuilder* getBuilder(http::method::Method method) const noexcept {
+        size_t index = static_cast<size_t>(method);
+        return (index < METHOD_COUNT) ? builders[index].get() : nullptr;
+    }
 
 private:
     // Variables //
 
-    std::unordered_map<http::method::Method, BuilderType> builderRegistry;
+    std::array<std::unique_ptr<const ResponseBuilder>, METHOD_COUNT> builders;
+    std::vector<std::shared_ptr<const ResponseBuilder>> routeBuilders; // Owned here, one builder may serve several routes
+    Router router;
 };
 
-#endif // RESPONSE_BUILDER_FACTORY_HPP
\ No newline at end of file
+#endif // RESPONSE_BUILDER_FACTORY_HPP
@@ -0,0 +1,155 @@
+/**
+ * @file response_cache.hpp
+ * @brief This file contains the declaration of the ResponseCache class.
+ * @details This class keeps complete serialized responses for small files so that a hit
+ * can be sent straight to the socket without building an `HttpResponse`.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Linux Documentation========================================
+// https://man7.org/linux/man-pages/man2/stat.2.html          |
+// ============================================================
+
+#ifndef RESPONSE_CACHE_HPP
+#define RESPONSE_CACHE_HPP
+
+#include "http_encoding.hpp"
+#include "http_response.hpp"
+#include "response_composer.hpp"
+
+#include <sys/stat.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @brief The ResponseCache class stores fully serialized responses keyed by file and encoding.
+ * @details Each entry is one contiguous block: the status line and fixed headers, followed by the
+ * body. The per-request `date` and `connection` headers are written between the two when sending.
+ * Entries are revalidated against the file's `stat()` at most once per `REVALIDATE_INTERVAL`.
+ *
+ * There is one entry per resolved file. Request paths (decoded, without the query) are aliases
+ * of it, so differently spelled requests for the same file share one copy and only a few
+ * aliases are kept per file. Eviction follows the CLOCK algorithm: entries are queued in
+ * insertion order, and an entry that was hit since it last reached the front gets another pass.
+ */
+class ResponseCache {
+public:
+    // Enums //
+
+    /**
+     * @brief The content encoding of a cached variant.
+     * @note Only identity bodies are produced by the server right now.
+     */
+    enum class Encoding {
+        IDENTITY,
+        COUNT
+    };
+
+    // Constants //
+
+    static constexpr std::chrono::milliseconds REVALIDATE_INTERVAL{1000};
+    static constexpr size_t MAX_ALIASES = 8; // Request paths remembered per file
+    static constexpr size_t ENCODING_COUNT = static_cast<size_t>(Encoding::COUNT);
+
+    // Structs //
+
+    /**
+     * @brief A cached response. Immutable once published, apart from its validation timestamp.
+     */
+    struct Entry {
+        std::string bytes;
+        size_t headersLength = 0;
+        std::string path;
+        struct timespec modified{};
+        off_t size = 0;
+        mutable std::atomic<int64_t> validatedAt{0}; // steady_clock ticks of the last stat()
+        mutable std::atomic<bool> referenced{false};  // Hit since the eviction clock last passed it
+
+        std::string_view headers() const noexcept { return std::string_view(bytes).substr(0, headersLength); }
+        std::string_view body() const noexcept { return std::string_view(bytes).substr(headersLength); }
+    };
+
+    // Constructors //
+
+    explicit ResponseCache(size_t capacityBytes);
+
+    // Getters //
+
+    bool isEnabled() const noexcept { return capacity > 0; }
+    size_t getSize() const;
+
+    // Functions //
+
+    std::shared_ptr<const Entry> lookup(std::string_view requestPath, Encoding encoding = Encoding::IDENTITY);
+    std::shared_ptr<const Entry> reuse(
+        std::string_view requestPath,
+        const std::string& path,
+        const struct stat& fileStat,
+        Encoding encoding = Encoding::IDENTITY
+    );
+    std::shared_ptr<const Entry> store(
+        std::string_view requestPath,
+        const std::string& path,
+        const struct stat& fileStat,
+        const HttpResponse& response,
+        const ResponseComposer& composer,
+        Encoding encoding = Encoding::IDENTITY
+    );
+
+    /**
+     * @brief Appends the path a request URI is cached under: the query and fragment are dropped
+     * and the rest is percent-decoded.
+     * @param uri The request URI.
+     * @param out The string to append to (any `std::basic_string<char>`, including `std::pmr::string`).
+     */
+    template<typename String>
+    static void appendRequestPath(std::string_view uri, String& out) {
+        http::encoding::decodeAppend(uri.substr(0, uri.find_first_of("?#")), out);
+    }
+
+private:
+    // Structs //
+
+    /**
+     * @brief The bookkeeping for one cached file, guarded by the mutex.
+     */
+    struct Slot {
+        std::shared_ptr<const Entry> entry;
+        std::list<std::string> aliases;                                   // Request paths, viewed by the alias index
+        std::list<std::pair<Encoding, std::string_view>>::iterator queued; // Position in the eviction queue
+    };
+
+    // Variables //
+
+    const size_t capacity;
+    size_t size = 0; // Bytes held by all entries and aliases, guarded by the mutex
+    mutable std::shared_mutex mutex;
+    std::array<std::unordered_map<std::string_view, Slot>, ENCODING_COUNT> files;                           // Keys view `Entry::path`
+    std::array<std::unordered_map<std::string_view, std::shared_ptr<const Entry>>, ENCODING_COUNT> aliases; // Keys view `Slot::aliases`
+    std::list<std::pair<Encoding, std::string_view>> queue;                                                  // Eviction order, oldest first
+
+    // Helpers //
+
+    bool isFresh(const Entry& entry) const noexcept;
+    static bool matches(const Entry& entry, const struct stat& fileStat) noexcept;
+    void addAlias(Slot& slot, std::string_view requestPath, Encoding encoding);
+    void erase(const std::string& path, Encoding encoding, const Entry* expected);
+    void remove(std::unordered_map<std::string_view, Slot>::iterator it, Encoding encoding);
+    void evictFor(size_t bytes);
+};
+
+#endif // RESPONSE_CACHE_HPP
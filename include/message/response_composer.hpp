@@ -15,15 +15,51 @@
 #include "http_response.hpp"
 #include "http_status.hpp"
 
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
 /**
  * @brief The ResponseComposer class is used to build raw HTTP responses from HttpResponse objects.
  */
 class ResponseComposer {
 public:
+    // Constants //
+
+    static constexpr size_t INITIAL_HEADER_CAPACITY = 512;
+    static constexpr int FIRST_ERROR_CODE = 400;
+    static constexpr int LAST_ERROR_CODE = 599;
+
+    // Structs //
+
+    /**
+     * @brief An error response serialized once at startup and never modified afterwards.
+     * @details The bytes hold the status line and the fixed headers followed by the body. The
+     * per-request `date` and `connection` headers (and the blank line) go between the two.
+     */
+    struct PrebuiltResponse {
+        std::string bytes;
+        size_t headersLength = 0;
+
+        std::string_view headers() const noexcept { return std::string_view(bytes).substr(0, headersLength); }
+        std::string_view body() const noexcept { return std::string_view(bytes).substr(headersLength); }
+    };
+
+    // Constructors //
+
+    ResponseComposer();
+
     // Functions //
     
     std::string composeResponseString(const HttpResponse& response) const;
-    std::string composeErrorMessage(HttpResponse& response, http::status::Code code);
+    size_t serializeHeaders(const HttpResponse& response, char* buffer, size_t capacity) const noexcept;
+    const PrebuiltResponse& getErrorResponse(http::status::Code code) const noexcept;
+
+private:
+    // Variables //
+
+    std::array<PrebuiltResponse, LAST_ERROR_CODE - FIRST_ERROR_CODE + 1> errorResponses;
 };
 
 #endif // RESPONSE_COMPOSER_HPP
\ No newline at end of file
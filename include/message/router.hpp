@@ -0,0 +1,150 @@
+/**
+ * @file router.hpp
+ * @brief This file contains the declaration of the Router and RouteParams classes.
+ * @details The router maps a method and a path pattern to a ResponseBuilder. Patterns are
+ * compiled into a radix tree so a lookup walks the path once, without allocating.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Radix Tree Documentation=========================================
+// https://en.wikipedia.org/wiki/Radix_tree                         |
+// https://github.com/julienschmidt/httprouter#how-does-it-work     |
+// ==================================================================
+
+#ifndef ROUTER_HPP
+#define ROUTER_HPP
+
+#include "http_method.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ResponseBuilder;
+
+/**
+ * @brief The parameters captured by a route, such as `id` in `/users/:id`.
+ * @details Values are stored as offsets into the matched path rather than views, so they
+ * stay correct when the request that owns the path is moved.
+ */
+class RouteParams {
+public:
+    // Constants //
+
+    static constexpr size_t MAX_PARAMS = 8;
+
+    // Getters //
+
+    size_t size() const noexcept { return count; }
+    std::string_view getName(size_t index) const noexcept { return params[index].name; }
+
+    /**
+     * @brief Gets the value of a parameter.
+     * @param path The path the route was matched against.
+     * @param name The parameter name from the pattern.
+     * @return The raw (still percent-encoded) value, or `std::nullopt` if the route has no such parameter.
+     */
+    std::optional<std::string_view> get(std::string_view path, std::string_view name) const noexcept {
+        for(size_t i = 0; i < count; ++i) {
+            if(params[i].name == name) return path.substr(params[i].offset, params[i].length);
+        }
+        return std::nullopt;
+    }
+
+    // Functions //
+
+    bool push(std::string_view name, size_t offset, size_t length) noexcept {
+        if(count == MAX_PARAMS) return false;
+        params[count++] = Param{name, offset, length};
+        return true;
+    }
+    void pop() noexcept { --count; }
+    void clear() noexcept { count = 0; }
+
+private:
+    // Structs //
+
+    struct Param {
+        std::string_view name; // Views the pattern stored in the router
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
+    // Variables //
+
+    std::array<Param, MAX_PARAMS> params{};
+    size_t count = 0;
+};
+
+/**
+ * @brief The Router class dispatches requests to builders by method and path pattern.
+ * @details Patterns are made of static text, `:name` parameters that match one path segment,
+ * and an optional trailing `*name` that matches the rest of the path (a prefix route). When
+ * several routes could match, static text wins over a parameter, which wins over a prefix.
+ * Routes are registered at startup; matching is read-only and safe from any thread.
+ */
+class Router {
+public:
+    // Structs //
+
+    /**
+     * @brief The outcome of a lookup.
+     */
+    struct Match {
+        const ResponseBuilder* builder = nullptr;
+        bool pathMatched = false; // A route exists for the path, maybe only for other methods
+        uint32_t allowedMethods = 0; // Bit per method routed on the path, for `Allow`
+        RouteParams params;
+    };
+
+    // Constructors //
+
+    Router();
+    ~Router();
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+
+    // Functions //
+
+    void add(http::method::Method method, std::string_view pattern, const ResponseBuilder* builder);
+    bool match(http::method::Method method, std::string_view path, Match& result) const noexcept;
+    bool hasRoutes(http::method::Method method) const noexcept;
+
+private:
+    // Constants //
+
+    static constexpr size_t METHOD_COUNT = static_cast<size_t>(http::method::Method::INVALID);
+
+    // Structs //
+
+    struct Node {
+        std::string prefix;                         // Static text consumed by this node
+        std::string indices;                        // First byte of each static child, for a quick scan
+        std::vector<std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> paramChild;           // `:name`, one segment
+        std::unique_ptr<Node> wildcardChild;        // `*name`, the rest of the path
+        std::string paramName;                      // Name of the parameter that leads to this node
+        std::array<const ResponseBuilder*, METHOD_COUNT> handlers{};
+        uint32_t methods = 0;                       // Bit per method with a handler
+    };
+
+    // Variables //
+
+    std::unique_ptr<Node> root;
+    uint32_t methodMask = 0; // Bit per method that has at least one route
+
+    // Helpers //
+
+    static Node* insertStatic(Node* node, std::string_view text);
+    static const Node* find(const Node* node, std::string_view path, size_t offset, RouteParams& params) noexcept;
+};
+
+#endif // ROUTER_HPP
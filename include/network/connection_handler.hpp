@@ -20,13 +20,24 @@
 #ifndef CONNECTION_HANDLER_HPP
 #define CONNECTION_HANDLER_HPP
 
+#include "event_loop.hpp"
 #include "http_request.hpp"
 #include "http_response.hpp"
+#include "request_timer.hpp"
 #include "response_builder_factory.hpp"
+#include "response_cache.hpp"
+#include "rate_limiter.hpp"
 #include "response_composer.hpp"
+#include "reverse_proxy.hpp"
 #include "socket.hpp"
+#include "sse_broadcaster.hpp"
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <string_view>
 
 /**
  * @brief The ConnectionHandler class is a delegated handler for a single client connection.
@@ -38,13 +49,19 @@ public:
     ConnectionHandler(
         std::unique_ptr<Socket> client_socket,
         std::shared_ptr<ResponseBuilderFactory> factory,
-        std::shared_ptr<ResponseComposer> composer
+        std::shared_ptr<ResponseComposer> composer,
+        std::shared_ptr<ResponseCache> responseCache,
+        std::shared_ptr<EventLoop> eventLoop,
+        std::shared_ptr<SseBroadcaster> broadcaster,
+        std::shared_ptr<RateLimiter> rateLimiter,
+        RequestTimer connectionTimer = {}
     );
     ~ConnectionHandler() noexcept;
 
     // Functions //
 
     void processRequests();
+    static void reject(const Socket& socket, const ResponseComposer& composer, http::status::Code code) noexcept;
 
 private:
     // Constants //
@@ -52,23 +69,49 @@ private:
     static constexpr int KEEP_ALIVE_TIMEOUT = 60000;    // 60 seconds timeout
     static constexpr int MAX_KEEP_ALIVE_REQUESTS = 100; // Max 100 requests per connection
     static constexpr int BUFFER_SIZE = 128 * 1024;      // 128KB
+    static constexpr int HEADER_BUFFER_SIZE = 8 * 1024; // 8KB, serialized response headers
+    static constexpr int BODY_READ_TIMEOUT = 5000;      // 5 seconds to receive the next part of a body
+    static constexpr size_t MAX_BODY_SIZE = 8 * 1024 * 1024; // 8MB
+    static constexpr size_t MAX_UPLOAD_SIZE = 1024 * 1024 * 1024; // 1GB, multipart bodies are streamed
+    static constexpr int ARENA_SIZE = 16 * 1024;        // 16KB, request-scoped allocations before falling back to the heap
+    static constexpr std::string_view H2C_SWITCHING_PROTOCOLS = "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
 
     // Dependencies //
 
     std::unique_ptr<Socket> client_socket;
     std::shared_ptr<ResponseBuilderFactory> factory;
     std::shared_ptr<ResponseComposer> composer;
+    std::shared_ptr<ResponseCache> responseCache;
+    std::shared_ptr<EventLoop> eventLoop;
+    std::shared_ptr<SseBroadcaster> broadcaster;
+    std::shared_ptr<RateLimiter> rateLimiter;
+
+    // Variables //
+
+    RequestTimer timer; // Phases of the request currently being handled
+    uint64_t clientKey = 0; // Rate limiter key of the peer, looked up with the first request
+    alignas(std::max_align_t) std::byte arenaBuffer[ARENA_SIZE];
+    std::pmr::monotonic_buffer_resource arena; // Backs the request and response, released after each request
+    std::string pipelined; // Bytes received after the current request, the start of the next one
 
     // Helpers //
     bool waitForSocketEvent(int fd, short event_mask, int timeout_ms);
     bool waitForData();
+    bool isHttp2Preface();
+    void logIfSlow(const HttpRequest& request) const;
 
     // Functions //
 
-    bool handleRequest();
-    HttpRequest parseRequest();
+    bool handleRequest(bool isReused);
+    HttpRequest parseHead(std::pmr::string& requestData, size_t& bodyStart);
+    void readBody(HttpRequest& request, std::pmr::string& requestData, size_t bodyStart);
+    bool forwardRequest(const ReverseProxy& proxy, const HttpRequest& request, std::string_view received,
+                        bool keepAlive, std::chrono::steady_clock::time_point start);
+    void readMultipartBody(HttpRequest& request, std::string_view received, std::string_view boundary, char* buffer);
+    size_t receiveBodyChunk(char* buffer, size_t size);
     void sendResponse(HttpResponse& response);
-    void sendErrorResponse(HttpResponse& response, const http::status::Code& code);
+    void sendPrebuilt(std::string_view headers, std::string_view body, bool keepAlive);
+    void sendErrorResponse(http::status::Code code, bool keepAlive, bool omitBody = false) noexcept;
 };
 
 #endif // CONNECTION_HANDLER_HPP
\ No newline at end of file
@@ -36,6 +36,7 @@ public:
 
     // Functions //
     void addSocket(const Socket& socket, uint32_t events);
+    void modifySocket(int fd, uint32_t events);
     void removeSocket(int fd);
     std::vector<epoll_event> waitForEvents(int timeout_ms = -1) const;
     void wakeup();
@@ -0,0 +1,116 @@
+/**
+ * @file event_loop.hpp
+ * @brief This file contains the declaration of the EventLoop class.
+ * @details The event loop owns long-lived, mostly idle connections (such as WebSockets) after
+ * their handshake, so they wait in epoll instead of pinning a `ThreadPool` worker each.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Linux Documentation================================
+// https://man7.org/linux/man-pages/man7/epoll.7.html |
+// ====================================================
+
+#ifndef EVENT_LOOP_HPP
+#define EVENT_LOOP_HPP
+
+#include "epoll_manager.hpp"
+#include "socket.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief The EventLoop class drives parked connections from a single thread.
+ * @details Connections are handed over from worker threads with `adopt` and are then only
+ * touched by the loop thread. Every callback must return quickly and never block: reads and
+ * writes are non-blocking, and unsent output is kept until the socket is writable again.
+ */
+class EventLoop {
+public:
+    /**
+     * @brief A connection parked in the event loop.
+     */
+    class Connection {
+    public:
+        virtual ~Connection() = default;
+
+        virtual const Socket& getSocket() const noexcept = 0;
+        virtual bool wantsWrite() const noexcept = 0;
+
+        /**
+         * @brief Called when the socket is readable.
+         * @param buffer Scratch space shared by all connections, valid for this call only.
+         * @param size The size of `buffer`.
+         * @return `false` to close the connection.
+         */
+        virtual bool onReadable(char* buffer, size_t size) = 0;
+        virtual bool onWritable() = 0;                                     // `false` to close the connection
+        virtual bool onTick(std::chrono::steady_clock::time_point now) = 0; // Once per `TICK_MS`, `false` to close
+        virtual void onAdopted() {}                                        // Registered, now owned by the loop thread
+        virtual void onShutdown() noexcept {}                              // The server is stopping
+    };
+
+    // Constructors //
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Getters //
+
+    bool isActive() const noexcept { return running; }
+
+    // Lifecycle //
+
+    void shutdown();
+    void adopt(std::unique_ptr<Connection> connection);
+    void post(std::function<void()> task);
+
+private:
+    // Constants //
+
+    static constexpr int MAX_EVENTS = 256;
+    static constexpr int TICK_MS = 1000;
+    static constexpr size_t READ_BUFFER_SIZE = 64 * 1024; // 64KB, shared by every connection
+
+    // Structs //
+
+    struct Entry {
+        std::unique_ptr<Connection> connection;
+        bool writing = false; // EPOLLOUT is in the interest set
+    };
+
+    // Variables //
+
+    std::unique_ptr<EpollManager> epollManager;
+    std::unordered_map<int, Entry> connections; // Loop thread only
+    std::unique_ptr<char[]> readBuffer;
+    std::atomic<bool> running;
+    std::thread thread;
+
+    std::mutex inboxMutex;
+    std::vector<std::unique_ptr<Connection>> adopted; // Waiting for the loop thread to register them
+    std::vector<std::function<void()>> posted;        // Waiting for the loop thread to run them
+
+    // Functions //
+
+    void run();
+    void registerAdopted();
+    bool runPosted();
+    void dispatch(const epoll_event& event);
+    void tick(std::chrono::steady_clock::time_point now);
+    bool refresh(int fd, Entry& entry);
+};
+
+#endif // EVENT_LOOP_HPP
@@ -0,0 +1,266 @@
+/**
+ * @file http2_session.hpp
+ * @brief This file contains the declaration of the Http2Session class.
+ * @details This class serves one cleartext HTTP/2 (h2c) connection, started either with the
+ * connection preface (prior knowledge) or by upgrading an HTTP/1.1 request. Requests on every
+ * stream are answered by the same response builders as HTTP/1.1.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =HTTP/2 Documentation=======================================
+// https://www.rfc-editor.org/rfc/rfc7540                     |
+// https://www.rfc-editor.org/rfc/rfc7540#section-3.2         |
+// https://www.rfc-editor.org/rfc/rfc7540#section-5.3         |
+// https://www.rfc-editor.org/rfc/rfc7540#section-6.9         |
+// ============================================================
+
+#ifndef HTTP2_SESSION_HPP
+#define HTTP2_SESSION_HPP
+
+#include "hpack.hpp"
+#include "http_request.hpp"
+#include "multipart_parser.hpp"
+#include "response_builder_factory.hpp"
+#include "response_composer.hpp"
+#include "socket.hpp"
+
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief The Http2Session class multiplexes requests over one HTTP/2 connection.
+ * @details Frames are read and written by the worker thread that owns the connection.
+ * Responses are queued per stream and DATA frames are scheduled by stream priority,
+ * within the flow-control windows granted by the peer. Static files are still sent
+ * with `sendfile()`, one DATA frame at a time.
+ */
+class Http2Session {
+public:
+    // Constants //
+
+    static constexpr std::string_view PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+    // Constructors //
+
+    Http2Session(Socket& socket, std::shared_ptr<ResponseBuilderFactory> factory, std::shared_ptr<ResponseComposer> composer);
+    ~Http2Session();
+    Http2Session(const Http2Session&) = delete;
+    Http2Session& operator=(const Http2Session&) = delete;
+
+    // Functions //
+
+    static bool isPrefacePrefix(std::string_view data) noexcept;
+    static bool isUpgradeRequest(const HttpRequest& request);
+
+    void run();
+    void runUpgraded(HttpRequest& request);
+
+private:
+    // Constants //
+
+    static constexpr size_t FRAME_HEADER_SIZE = 9;
+    static constexpr uint32_t DEFAULT_WINDOW_SIZE = 65535;
+    static constexpr uint32_t MAX_WINDOW_SIZE = 0x7fffffff;
+    static constexpr uint32_t LOCAL_MAX_FRAME_SIZE = 16384;        // Largest frame we accept, the protocol minimum
+    static constexpr uint32_t LOCAL_STREAM_WINDOW = 1024 * 1024;   // 1MB per stream for request bodies
+    static constexpr uint32_t LOCAL_CONNECTION_WINDOW = 4 * 1024 * 1024; // 4MB across all streams
+    static constexpr uint32_t MAX_CONCURRENT_STREAMS = 100;
+    static constexpr uint32_t MAX_STREAMS_PER_CONNECTION = 1000;   // Then GOAWAY, like MAX_KEEP_ALIVE_REQUESTS
+    static constexpr size_t MAX_HEADER_BLOCK_SIZE = 64 * 1024;     // 64KB of compressed headers per request
+    static constexpr size_t MAX_HEADER_LIST_SIZE = 64 * 1024;      // 64KB of decoded headers per request
+    static constexpr size_t MAX_BODY_SIZE = 8 * 1024 * 1024;       // 8MB, as for HTTP/1.1
+    static constexpr size_t MAX_UPLOAD_SIZE = 1024 * 1024 * 1024;  // 1GB, multipart bodies are streamed
+    static constexpr size_t FLUSH_THRESHOLD = 64 * 1024;           // Queued frame bytes that trigger a write
+    static constexpr size_t WRITE_QUANTUM = 256 * 1024;            // DATA bytes written before reading frames again
+    static constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+    static constexpr int IDLE_TIMEOUT = 500;                       // Same proactive closure as HTTP/1.1
+    static constexpr int STALL_TIMEOUT = 5000;                     // Open streams waiting on the peer
+    static constexpr int POLL_INTERVAL = 100;                      // Checks whether the server is still running
+    static constexpr uint16_t DEFAULT_WEIGHT = 16;
+    static constexpr uint64_t STRIDE = 1u << 16;                   // Virtual time per byte at weight 1
+
+    // Enums //
+
+    enum class FrameType : uint8_t {
+        DATA = 0x0,
+        HEADERS = 0x1,
+        PRIORITY = 0x2,
+        RST_STREAM = 0x3,
+        SETTINGS = 0x4,
+        PUSH_PROMISE = 0x5,
+        PING = 0x6,
+        GOAWAY = 0x7,
+        WINDOW_UPDATE = 0x8,
+        CONTINUATION = 0x9
+    };
+
+    enum class ErrorCode : uint32_t {
+        NO_ERROR = 0x0,
+        PROTOCOL_ERROR = 0x1,
+        INTERNAL_ERROR = 0x2,
+        FLOW_CONTROL_ERROR = 0x3,
+        STREAM_CLOSED = 0x5,
+        FRAME_SIZE_ERROR = 0x6,
+        REFUSED_STREAM = 0x7,
+        CANCEL = 0x8,
+        COMPRESSION_ERROR = 0x9,
+        ENHANCE_YOUR_CALM = 0xb
+    };
+
+    enum Flag : uint8_t {
+        END_STREAM = 0x1,
+        ACK = 0x1,
+        END_HEADERS = 0x4,
+        PADDED = 0x8,
+        PRIORITY_FLAG = 0x20
+    };
+
+    enum class Setting : uint16_t {
+        HEADER_TABLE_SIZE = 0x1,
+        ENABLE_PUSH = 0x2,
+        MAX_CONCURRENT_STREAMS = 0x3,
+        INITIAL_WINDOW_SIZE = 0x4,
+        MAX_FRAME_SIZE = 0x5,
+        MAX_HEADER_LIST_SIZE = 0x6
+    };
+
+    // Structs //
+
+    struct FrameHeader {
+        uint32_t length = 0;
+        FrameType type = FrameType::DATA;
+        uint8_t flags = 0;
+        uint32_t streamId = 0;
+    };
+
+    struct Priority {
+        uint32_t dependency = 0;
+        uint16_t weight = DEFAULT_WEIGHT;
+        bool exclusive = false;
+    };
+
+    struct Stream {
+        uint32_t id = 0;
+        bool remoteClosed = false;           // END_STREAM received, the request is complete
+        bool responding = false;             // Response headers sent, DATA still queued
+
+        // Request
+        HpackDecoder::HeaderList fields;
+        std::string body;
+        std::unique_ptr<MultipartParser> multipart;
+        size_t received = 0;
+        bool malformed = false;              // Answer 400 once the request is complete
+        bool tooLarge = false;               // Answered 413 right away, the rest of the upload is not read
+        int64_t receiveWindow = 0;
+        uint32_t unacknowledged = 0;         // Bytes consumed since our last WINDOW_UPDATE
+
+        // Response
+        int64_t sendWindow = 0;
+        MessageBody responseBody;            // Dynamic content, sent from `sent`
+        size_t sent = 0;
+        int fileFd = -1;                     // Static content, sent with sendfile()
+        off_t fileOffset = 0;
+        size_t fileRemaining = 0;
+
+        // Priority
+        uint32_t parent = 0;
+        uint16_t weight = DEFAULT_WEIGHT;
+        uint64_t pass = 0;                   // Stride scheduling position
+
+        ~Stream();
+        size_t pending() const noexcept { return (fileFd >= 0) ? fileRemaining : responseBody.size() - sent; }
+    };
+
+    /**
+     * @brief A connection error, answered with GOAWAY before the connection closes.
+     */
+    class ConnectionError : public std::runtime_error {
+    public:
+        ConnectionError(ErrorCode code, const std::string& message) : std::runtime_error(message), code(code) {}
+        ErrorCode code;
+    };
+
+    // Dependencies //
+
+    Socket& socket;
+    std::shared_ptr<ResponseBuilderFactory> factory;
+    std::shared_ptr<ResponseComposer> composer;
+
+    // Variables //
+
+    HpackDecoder decoder;
+    std::map<uint32_t, std::unique_ptr<Stream>> streams;
+    std::string input;                       // Received bytes not parsed yet
+    std::string output;                      // Frames queued for the next write
+    bool prefaceReceived = false;
+    bool goawaySent = false;
+    bool peerGoaway = false;
+
+    uint32_t lastStreamId = 0;               // Highest stream the client opened
+    uint32_t streamCount = 0;
+    uint32_t continuationStream = 0;         // Stream whose header block is unfinished
+    bool continuationEndStream = false;
+    std::string headerBlock;
+    std::optional<Priority> headerPriority;  // From the HEADERS frame that started the block
+
+    uint32_t peerInitialWindow = DEFAULT_WINDOW_SIZE;
+    uint32_t peerMaxFrameSize = LOCAL_MAX_FRAME_SIZE;
+    int64_t connectionSendWindow = DEFAULT_WINDOW_SIZE;
+    int64_t connectionReceiveWindow = DEFAULT_WINDOW_SIZE;
+    uint32_t connectionUnacknowledged = 0;
+    uint64_t virtualTime = 0;                // Pass of the stream scheduled last
+
+    // Functions //
+
+    void serve();
+    bool receive(int timeoutMs);
+    void processFrames();
+    void handleFrame(const FrameHeader& header, std::string_view payload);
+
+    void handleData(const FrameHeader& header, std::string_view payload);
+    void handleHeaders(const FrameHeader& header, std::string_view payload);
+    void handleHeaderBlock(uint32_t streamId, bool endStream);
+    void handlePriority(const FrameHeader& header, std::string_view payload);
+    void handleRstStream(const FrameHeader& header, std::string_view payload);
+    void handleSettings(const FrameHeader& header, std::string_view payload);
+    void handlePing(const FrameHeader& header, std::string_view payload);
+    void handleWindowUpdate(const FrameHeader& header, std::string_view payload);
+
+    static std::string_view removePadding(const FrameHeader& header, std::string_view payload);
+    static Priority parsePriority(std::string_view payload) noexcept;
+
+    void queuePreface();
+    void applySettings(std::string_view payload);
+    void setPriority(Stream& stream, const Priority& priority);
+    void appendBody(Stream& stream, std::string_view data);
+    bool consumeWindow(Stream* stream, size_t length, bool endStream);
+    void completeRequest(Stream& stream);
+    void respond(Stream& stream, HttpRequest& request);
+    void respondWithError(Stream& stream, http::status::Code code, bool omitBody);
+    void sendHeaders(Stream& stream, std::string_view block, bool endStream);
+
+    bool writeData();
+    Stream* nextStream() noexcept;
+    void finishStream(Stream& stream);
+    void closeStream(uint32_t streamId) noexcept;
+    void resetStream(uint32_t streamId, ErrorCode code);
+    void goAway(ErrorCode code) noexcept;
+
+    void queueFrame(FrameType type, uint8_t flags, uint32_t streamId, std::string_view payload);
+    void queueFrameHeader(FrameType type, uint8_t flags, uint32_t streamId, size_t length);
+    void flush(int flags = MSG_NOSIGNAL);
+};
+
+#endif // HTTP2_SESSION_HPP
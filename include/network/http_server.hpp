@@ -18,10 +18,14 @@
 #define HTTP_SERVER_HPP
 
 #include "epoll_manager.hpp"
+#include "event_loop.hpp"
 #include "file_resolver.hpp"
 #include "response_builder_factory.hpp"
+#include "response_cache.hpp"
+#include "rate_limiter.hpp"
 #include "response_composer.hpp"
 #include "socket.hpp"
+#include "sse_broadcaster.hpp"
 #include "thread_pool.hpp"
 
 #include <csignal>
@@ -63,12 +67,16 @@ private:
     std::shared_ptr<ResponseBuilderFactory> factory;
     std::shared_ptr<ResponseComposer> composer;
     std::shared_ptr<FileResolver> resolver;
+    std::shared_ptr<ResponseCache> responseCache;
+    std::shared_ptr<RateLimiter> rateLimiter;
 
     // Components //
 
     std::unique_ptr<Socket> socket;
     std::unique_ptr<EpollManager> epollManager;
     std::unique_ptr<ThreadPool> threadPool;
+    std::shared_ptr<EventLoop> eventLoop;
+    std::shared_ptr<SseBroadcaster> broadcaster;
     std::atomic<bool> running;
 
     // Lifecycle //
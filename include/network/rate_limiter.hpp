@@ -0,0 +1,112 @@
+/**
+ * @file rate_limiter.hpp
+ * @brief This file contains the declaration of the RateLimiter class.
+ * @details The rate limiter keeps one connection and one request token bucket per client
+ * address. Buckets live in a fixed, sharded open-addressing table whose slots are updated with
+ * compare-and-swap, so neither the accept loop nor the workers ever take a lock to check them.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Rate Limiting Documentation======================================
+// https://www.rfc-editor.org/rfc/rfc6585#section-4                  |
+// https://en.wikipedia.org/wiki/Token_bucket                        |
+// https://en.cppreference.com/w/cpp/atomic/atomic/compare_exchange  |
+// ==================================================================
+
+#ifndef RATE_LIMITER_HPP
+#define RATE_LIMITER_HPP
+
+#include <sys/socket.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief The RateLimiter class enforces per-client connection and request rates.
+ * @details Each bucket is a single 64-bit word holding the time of its last refill and the
+ * tokens left in thousandths, so taking a token is one compare-and-swap. A client's slot is
+ * found within one shard of the table; when the shard is full, the slot of a client whose
+ * buckets have refilled completely is reused, and if there is none the client is let through.
+ */
+class RateLimiter {
+public:
+    // Constants //
+
+    static constexpr int MAX_BURST = 4000; // Tokens a bucket may hold, limited by the packed layout
+
+    // Structs //
+
+    struct Limit {
+        int perSecond = 0; // 0 disables the limit
+        int burst = 0;     // Tokens available at once, at least 1
+    };
+
+    // Constructors //
+
+    RateLimiter(Limit connections, Limit requests);
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    // Getters //
+
+    bool limitsConnections() const noexcept { return connections.perSecond > 0; }
+    bool limitsRequests() const noexcept { return requests.perSecond > 0; }
+
+    // Functions //
+
+    bool allowConnection(uint64_t client) noexcept;
+    bool allowRequest(uint64_t client) noexcept;
+    static uint64_t clientKey(const sockaddr_storage& address, socklen_t length) noexcept;
+    static uint64_t clientKey(int fd) noexcept;
+
+private:
+    // Constants //
+
+    static constexpr size_t SHARD_COUNT = 256;
+    static constexpr size_t SLOTS_PER_SHARD = 64;   // Probed linearly, two slots per cache line
+    static constexpr int TOKEN_BITS = 22;           // Thousandths of a token, MAX_BURST * 1000 fits
+    static constexpr uint64_t TOKEN_MASK = (uint64_t{1} << TOKEN_BITS) - 1;
+    static constexpr uint64_t EMPTY = 0;            // Slot key of an unused slot
+
+    // Structs //
+
+    /**
+     * @brief One client's buckets. Both start at 0, which reads as completely refilled.
+     * @note 32 bytes, so a slot never straddles a cache line.
+     */
+    struct alignas(32) Slot {
+        std::atomic<uint64_t> key{EMPTY};
+        std::atomic<uint64_t> connectionBucket{0};
+        std::atomic<uint64_t> requestBucket{0};
+        uint64_t padding = 0;
+    };
+    static_assert(sizeof(Slot) == 32, "Two slots per cache line");
+
+    struct alignas(64) Shard {
+        std::array<Slot, SLOTS_PER_SHARD> slots;
+    };
+
+    // Variables //
+
+    const Limit connections;
+    const Limit requests;
+    const std::chrono::steady_clock::time_point epoch; // Bucket times are milliseconds since this
+    std::unique_ptr<Shard[]> shards;
+
+    // Helpers //
+
+    uint64_t nowMs() const noexcept;
+    Slot* findSlot(uint64_t client, uint64_t now) noexcept;
+    bool isIdle(const Slot& slot, uint64_t now) const noexcept;
+    static bool take(std::atomic<uint64_t>& bucket, const Limit& limit, uint64_t now) noexcept;
+    static bool isFull(uint64_t state, const Limit& limit, uint64_t now) noexcept;
+};
+
+#endif // RATE_LIMITER_HPP
@@ -0,0 +1,132 @@
+/**
+ * @file reverse_proxy.hpp
+ * @brief This file contains the declaration of the ReverseProxy class.
+ * @details The reverse proxy forwards requests on its routes to a group of upstream HTTP/1.1
+ * servers. Upstream connections are kept alive in per-upstream pools, and bodies are moved
+ * between the sockets with `splice()` so they never pass through user space whole.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Proxy Documentation========================================
+// https://www.rfc-editor.org/rfc/rfc9110#section-7.6.1        |
+// https://www.rfc-editor.org/rfc/rfc9112#section-6            |
+// https://www.rfc-editor.org/rfc/rfc9112#section-7.1          |
+// https://man7.org/linux/man-pages/man2/splice.2.html         |
+// ============================================================
+
+#ifndef REVERSE_PROXY_HPP
+#define REVERSE_PROXY_HPP
+
+#include "http_request.hpp"
+#include "http_status.hpp"
+#include "response_builder.hpp"
+#include "socket.hpp"
+
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief The ReverseProxy class forwards requests to upstream servers.
+ * @details HTTP/1.1 requests are handed to `forward` by the ConnectionHandler before their body
+ * is read, so bodies stream in both directions. Like every builder it is shared between worker
+ * threads; the pools are locked per upstream.
+ */
+class ReverseProxy : public ResponseBuilder {
+public:
+    // Enums //
+
+    enum class Balance {
+        ROUND_ROBIN,
+        LEAST_CONNECTIONS
+    };
+
+    // Structs //
+
+    /**
+     * @brief The outcome of forwarding one request.
+     */
+    struct Result {
+        http::status::Code status;
+        bool responded; // `false` if nothing was sent and the caller should send an error for `status`
+    };
+
+    // Constructors //
+
+    ReverseProxy(const std::vector<std::string>& upstreams, Balance balance);
+
+    // Functions //
+
+    Result forward(const HttpRequest& request, std::string_view received, const Socket& client, bool& keepAlive) const;
+    static Balance balanceFromString(std::string_view name);
+
+    // Overrides //
+
+    ResponseResult buildResponse(const HttpRequest& request) const override;
+
+private:
+    // Constants //
+
+    static constexpr int CONNECT_TIMEOUT = 3000;   // 3 seconds to connect to an upstream
+    static constexpr int UPSTREAM_TIMEOUT = 30000; // 30 seconds of upstream silence before giving up
+    static constexpr int CLIENT_TIMEOUT = 30000;   // 30 seconds for the client to take or send more bytes
+    static constexpr size_t MAX_HEAD_SIZE = 16 * 1024;  // 16KB, larger response heads are rejected
+    static constexpr size_t MAX_IDLE_CONNECTIONS = 32;  // Pooled connections kept per upstream
+    static constexpr std::chrono::seconds IDLE_TIMEOUT{15}; // Pooled connections older than this are closed
+
+    // Structs //
+
+    struct IdleConnection {
+        std::unique_ptr<Socket> socket;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    struct Upstream {
+        std::string name; // host:port as configured, also sent as Host when the client sent none
+        sockaddr_storage address{};
+        socklen_t addressLength = 0;
+        std::mutex mutex;
+        std::vector<IdleConnection> idle; // Most recently used last
+        std::atomic<int> active{0};       // Requests in flight, for least-connections
+    };
+
+    /**
+     * @brief An upstream connection checked out for one exchange.
+     */
+    struct Lease {
+        Upstream* upstream = nullptr;
+        std::unique_ptr<Socket> socket;
+        bool reused = false; // Taken from the pool, so it may have been closed by the upstream
+
+        ~Lease() {
+            if(upstream) upstream->active.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+
+    // Variables //
+
+    std::vector<std::unique_ptr<Upstream>> upstreams;
+    Balance balance;
+    mutable std::atomic<size_t> next{0};
+
+    // Functions //
+
+    size_t pick() const;
+    bool acquire(Upstream& upstream, Lease& lease) const;
+    void release(Lease& lease, bool reusable) const;
+    std::string buildRequestHead(const HttpRequest& request, const Socket& client, const Upstream& upstream) const;
+    Result relayResponse(const HttpRequest& request, Lease& lease, const Socket& client, bool& keepAlive,
+                         bool& reusable, bool& retry) const;
+};
+
+#endif // REVERSE_PROXY_HPP
@@ -26,6 +26,7 @@
 #define SOCKET_HPP
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 /**
  * @brief The Socket class serves as a wrapper around the socket file descriptor 
@@ -61,6 +62,7 @@ public:
     void listen(int backlog);
     ssize_t recv(void* buf, size_t len, int flags) const;
     ssize_t send(const void* buf, size_t len, int flags) const;
+    ssize_t sendv(struct iovec* iov, int iovcnt, int flags) const;
     ssize_t sendfile(int file_fd, off_t* offset, size_t count) const;
 
 private:
@@ -0,0 +1,150 @@
+/**
+ * @file sse_broadcaster.hpp
+ * @brief This file contains the declaration of the SseBroadcaster class.
+ * @details The broadcaster keeps Server-Sent Events subscribers parked in the EventLoop and
+ * fans every published event out to them. An event is serialized once into a shared buffer
+ * that all subscriber queues point at.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =Server-Sent Events Documentation===========================================================
+// https://html.spec.whatwg.org/multipage/server-sent-events.html                             |
+// https://html.spec.whatwg.org/multipage/server-sent-events.html#event-stream-interpretation |
+// https://man7.org/linux/man-pages/man2/sendmsg.2.html                                       |
+// ============================================================================================
+
+#ifndef SSE_BROADCASTER_HPP
+#define SSE_BROADCASTER_HPP
+
+#include "event_loop.hpp"
+#include "response_builder.hpp"
+#include "socket.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+/**
+ * @brief The SseBroadcaster class delivers published events to every `text/event-stream` subscriber.
+ * @details Subscribers are only touched on the loop thread; `publish` posts the shared payload
+ * there. Each subscriber queues references to payloads, not copies, and a subscriber that falls
+ * too far behind loses its oldest unsent events instead of growing without bound.
+ * @note The broadcaster must outlive the event loop's connections.
+ */
+class SseBroadcaster {
+public:
+    // Constants //
+
+    static constexpr size_t MAX_EVENT_SIZE = 64 * 1024; // 64KB of data per event
+
+    // Constructors //
+
+    explicit SseBroadcaster(std::shared_ptr<EventLoop> eventLoop);
+    SseBroadcaster(const SseBroadcaster&) = delete;
+    SseBroadcaster& operator=(const SseBroadcaster&) = delete;
+
+    // Functions //
+
+    void subscribe(std::unique_ptr<Socket> socket);
+    uint64_t publish(std::string_view event, std::string_view data);
+    static std::string serialize(uint64_t id, std::string_view event, std::string_view data);
+
+private:
+    // Constants //
+
+    static constexpr std::string_view STREAM_HEADERS =
+        "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\nX-Accel-Buffering: no\r\n\r\nretry: 3000\n\n";
+
+    /**
+     * @brief One subscriber connection parked in the event loop.
+     */
+    class Subscriber : public EventLoop::Connection {
+    public:
+        // Constructors //
+
+        Subscriber(std::unique_ptr<Socket> socket, SseBroadcaster& broadcaster);
+        ~Subscriber() override;
+
+        // Functions //
+
+        void enqueue(const std::shared_ptr<const std::string>& payload);
+
+        // EventLoop::Connection //
+
+        const Socket& getSocket() const noexcept override { return *socket; }
+        bool wantsWrite() const noexcept override { return !queue.empty() || failed; }
+        bool onReadable(char* buffer, size_t size) override;
+        bool onWritable() override;
+        bool onTick(std::chrono::steady_clock::time_point now) override;
+        void onAdopted() override;
+
+    private:
+        // Constants //
+
+        static constexpr size_t MAX_QUEUED_BYTES = 256 * 1024;             // 256KB before the oldest events are dropped
+        static constexpr size_t MAX_IOVECS = 64;                           // Events written per sendmsg()
+        static constexpr std::chrono::seconds HEARTBEAT_INTERVAL{15};      // Idle time before a comment keeps proxies open
+        static constexpr std::chrono::seconds STALL_TIMEOUT{30};           // Time without write progress before dropping
+
+        // Dependencies //
+
+        std::unique_ptr<Socket> socket;
+        SseBroadcaster& broadcaster;
+
+        // Variables //
+
+        std::deque<std::shared_ptr<const std::string>> queue; // Shared payloads, the front may be partly sent
+        size_t headOffset = 0;                                 // Bytes of the front payload already sent
+        size_t queuedBytes = 0;                                // Unsent bytes across the queue
+        bool registered = false;                               // Listed in the broadcaster's subscribers
+        bool failed = false;                                   // A write failed, close on the next event
+        std::chrono::steady_clock::time_point lastProgress;    // Last write that made progress
+
+        // Functions //
+
+        bool flush();
+    };
+
+    // Dependencies //
+
+    std::shared_ptr<EventLoop> eventLoop;
+
+    // Variables //
+
+    std::mutex publishMutex;                    // Keeps ids in the order events are posted
+    uint64_t nextId = 0;
+    std::unordered_set<Subscriber*> subscribers; // Loop thread only
+};
+
+/**
+ * @brief The SsePublishResponseBuilder class is a concrete implementation of the ResponseBuilder interface
+ * for publishing a request body as an event. The `event` query parameter names the event type.
+ * @note Inherits from ResponseBuilder.
+ */
+class SsePublishResponseBuilder : public ResponseBuilder {
+public:
+    // Constructors //
+
+    explicit SsePublishResponseBuilder(std::shared_ptr<SseBroadcaster> broadcaster);
+
+    // Overrides //
+
+    ResponseResult buildResponse(const HttpRequest& request) const override;
+
+private:
+    // Dependencies //
+
+    std::shared_ptr<SseBroadcaster> broadcaster;
+};
+
+#endif // SSE_BROADCASTER_HPP
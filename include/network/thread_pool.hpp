@@ -11,11 +11,17 @@
 #ifndef THREAD_POOL_HPP
 #define THREAD_POOL_HPP
 
+#include "event_loop.hpp"
+#include "rate_limiter.hpp"
+#include "request_timer.hpp"
 #include "response_builder_factory.hpp"
+#include "response_cache.hpp"
 #include "response_composer.hpp"
 #include "socket.hpp"
+#include "sse_broadcaster.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -25,6 +31,12 @@
 
 /**
  * @brief The ThreadPool class is responsible for managing a pool of worker threads.
+ * @details With a queue delay target set, admission follows CoDel: the pool is overloaded
+ * once connections kept waiting longer than the target for a whole interval without the queue
+ * ever draining, and recovers as soon as one is dequeued within it. While overloaded,
+ * connections that waited more than twice the target are shed at dequeue, and new connections
+ * are refused at enqueue while the oldest queued one has waited past the target. Shed
+ * connections get a prebuilt `503 Service Unavailable` with `Retry-After`.
  */
 class ThreadPool {
 public:
@@ -33,24 +45,34 @@ public:
     ThreadPool(
         size_t numThreads,
         std::shared_ptr<ResponseBuilderFactory> factory,
-        std::shared_ptr<ResponseComposer> composer
+        std::shared_ptr<ResponseComposer> composer,
+        std::shared_ptr<ResponseCache> responseCache,
+        std::shared_ptr<EventLoop> eventLoop,
+        std::shared_ptr<SseBroadcaster> broadcaster,
+        std::shared_ptr<RateLimiter> rateLimiter,
+        std::chrono::milliseconds queueTarget = std::chrono::milliseconds(0)
     );
     ~ThreadPool();
 
     // Getters //
 
     bool isActive() const { return !workers.empty(); }
+    bool isOverloaded() const noexcept { return overloaded.load(std::memory_order_relaxed); }
 
     // Lifecycle //
 
     void shutdown();
-    void enqueue(std::unique_ptr<Socket> client_socket);
+    void enqueue(std::unique_ptr<Socket> client_socket, RequestTimer timer = {});
 
 private:
     // Dependencies //
 
     std::shared_ptr<ResponseBuilderFactory> factory;
     std::shared_ptr<ResponseComposer> composer;
+    std::shared_ptr<ResponseCache> responseCache;
+    std::shared_ptr<EventLoop> eventLoop;
+    std::shared_ptr<SseBroadcaster> broadcaster;
+    std::shared_ptr<RateLimiter> rateLimiter;
     
     // Threads //
 
@@ -60,12 +82,30 @@ private:
 
     // Tasks //
 
+    /**
+     * @brief A queued client connection along with its accept/queue timestamps.
+     */
+    struct Task {
+        std::unique_ptr<Socket> client_socket;
+        RequestTimer timer;
+    };
+
     std::mutex queue_mtx;
-    std::queue<std::unique_ptr<Socket>> task_queue;
+    std::queue<Task> task_queue;
+
+    // Admission Control //
+
+    static constexpr std::chrono::milliseconds CODEL_INTERVAL{100}; // How long the delay must stay above target
+
+    const RequestTimer::Clock::duration queueTarget; // Acceptable standing queue delay, 0 disables shedding
+    RequestTimer::Clock::time_point firstAboveTime{}; // When the overload starts if the delay stays high, guarded by queue_mtx
+    std::atomic<bool> overloaded{false};
 
     // Thread Functions //
 
     void workerThread();
+    bool shouldShed(RequestTimer::Clock::time_point now, RequestTimer::Clock::duration sojourn);
+    void shed(std::unique_ptr<Socket> client_socket);
 };
 
 #endif // THREAD_POOL_HPP
\ No newline at end of file
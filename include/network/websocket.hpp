@@ -0,0 +1,147 @@
+/**
+ * @file websocket.hpp
+ * @brief This file contains the declaration of the WebSocketConnection class.
+ * @details This class validates the WebSocket opening handshake and then serves the
+ * connection from the EventLoop: it decodes masked frames as they arrive, reassembles
+ * fragmented messages, answers pings and performs the closing handshake.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+// =WebSocket Documentation====================================
+// https://www.rfc-editor.org/rfc/rfc6455                     |
+// https://www.rfc-editor.org/rfc/rfc6455#section-4.2         |
+// https://www.rfc-editor.org/rfc/rfc6455#section-5.2         |
+// https://www.rfc-editor.org/rfc/rfc6455#section-7.4         |
+// ============================================================
+
+#ifndef WEBSOCKET_HPP
+#define WEBSOCKET_HPP
+
+#include "event_loop.hpp"
+#include "http_request.hpp"
+#include "socket.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief The WebSocketConnection class serves one upgraded connection from the EventLoop.
+ * @details Frames are decoded straight from the loop's read buffer; only an unfinished frame
+ * header and the message being assembled are kept per connection, so idle connections cost
+ * little more than their socket. Complete messages are echoed back to the client.
+ */
+class WebSocketConnection : public EventLoop::Connection {
+public:
+    // Enums //
+
+    enum class Opcode : uint8_t {
+        CONTINUATION = 0x0,
+        TEXT = 0x1,
+        BINARY = 0x2,
+        CLOSE = 0x8,
+        PING = 0x9,
+        PONG = 0xA
+    };
+
+    enum class CloseCode : uint16_t {
+        NORMAL = 1000,
+        GOING_AWAY = 1001,
+        PROTOCOL_ERROR = 1002,
+        NO_STATUS = 1005,
+        INVALID_PAYLOAD = 1007,
+        MESSAGE_TOO_BIG = 1009,
+        INTERNAL_ERROR = 1011
+    };
+
+    // Constructors //
+
+    explicit WebSocketConnection(std::unique_ptr<Socket> socket);
+    ~WebSocketConnection() override;
+    WebSocketConnection(const WebSocketConnection&) = delete;
+    WebSocketConnection& operator=(const WebSocketConnection&) = delete;
+
+    // Handshake //
+
+    static bool isUpgradeRequest(const HttpRequest& request);
+    static std::optional<std::string> acceptHandshake(const HttpRequest& request);
+    static std::string acceptKey(std::string_view key);
+
+    // Framing //
+
+    static void unmask(char* data, size_t length, const std::array<uint8_t, 4>& mask, size_t offset) noexcept;
+    static bool isValidUtf8(std::string_view str) noexcept;
+
+    // EventLoop::Connection //
+
+    const Socket& getSocket() const noexcept override { return *socket; }
+    bool wantsWrite() const noexcept override { return !output.empty(); }
+    bool onReadable(char* buffer, size_t size) override;
+    bool onWritable() override;
+    bool onTick(std::chrono::steady_clock::time_point now) override;
+    void onShutdown() noexcept override;
+
+private:
+    // Constants //
+
+    static constexpr size_t MAX_MESSAGE_SIZE = 1024 * 1024;        // 1MB, larger messages close with 1009
+    static constexpr size_t MAX_CONTROL_PAYLOAD = 125;
+    static constexpr size_t MAX_OUTPUT_SIZE = 4 * 1024 * 1024;     // 4MB queued for a slow reader before dropping it
+    static constexpr size_t RETAINED_CAPACITY = 64 * 1024;         // Buffers larger than this are freed once idle
+    static constexpr std::chrono::seconds PING_INTERVAL{30};       // Silence before we ping
+    static constexpr std::chrono::seconds IDLE_TIMEOUT{60};        // Silence before we give up
+
+    // Structs //
+
+    struct Frame {
+        bool fin = false;
+        Opcode opcode = Opcode::CONTINUATION;
+        std::array<uint8_t, 4> mask{};
+        uint64_t remaining = 0;   // Payload bytes not received yet
+        uint64_t processed = 0;   // Payload bytes received, keeps the mask aligned across reads
+    };
+
+    // Dependencies //
+
+    std::unique_ptr<Socket> socket;
+
+    // Variables //
+
+    std::array<uint8_t, 14> header{}; // Longest frame header: 2 + 8 length + 4 mask
+    size_t headerSize = 0;
+    bool inPayload = false;
+    Frame frame;
+
+    std::string control;              // Payload of the control frame being received
+    std::string message;              // Data message being reassembled from fragments
+    Opcode messageOpcode = Opcode::TEXT;
+    bool inMessage = false;
+
+    std::string output;               // Frames the socket did not take yet
+    bool closeSent = false;
+    bool pingSent = false;
+    std::chrono::steady_clock::time_point lastActivity;
+
+    // Functions //
+
+    bool consume(char* data, size_t size);
+    size_t headerLength() const noexcept;
+    size_t takeHeader(const char* data, size_t size);
+    bool startFrame();
+    bool finishFrame();
+    void onMessage(Opcode opcode, std::string_view payload);
+
+    void queueFrame(Opcode opcode, std::string_view payload);
+    void queueClose(CloseCode code);
+    bool flush();
+};
+
+#endif // WEBSOCKET_HPP
@@ -0,0 +1,99 @@
+/**
+ * @file clock.cpp
+ * @brief This file contains the definition of the Clock class.
+ * @details This class is a singleton that caches preformatted timestamps for the
+ * logger and the HTTP `Date` header, refreshing them at most once per second.
+ * 
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "clock.hpp"
+
+#include <time.h>
+
+#include <cstdio>
+#include <mutex>
+
+// Constructors //
+
+/**
+ * @brief Constructs the Clock and formats the current second.
+ */
+Clock::Clock() noexcept : snapshot(nullptr) {
+    refresh(now());
+}
+
+// Functions //
+
+/**
+ * @brief Refreshes the cached timestamps if the second has changed.
+ * @note Called once per event loop tick by the server.
+ */
+void Clock::update() noexcept {
+    time_t seconds = now();
+    if(snapshot.load(std::memory_order_acquire)->seconds == seconds) return;
+
+    std::scoped_lock<std::mutex> lock(updateMutex);
+    refresh(seconds);
+}
+
+// Helpers //
+
+/**
+ * @brief Gets the current wall clock second using the coarse (vDSO) clock.
+ */
+time_t Clock::now() noexcept {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return ts.tv_sec;
+}
+
+/**
+ * @brief Returns the current snapshot, refreshing it if it is stale.
+ * @details Readers only take the mutex when the second has rolled over, and even then
+ * they never wait on it: if another thread is already refreshing, the previous
+ * second is returned instead.
+ */
+const Clock::Snapshot* Clock::current() noexcept {
+    const Snapshot* snap = snapshot.load(std::memory_order_acquire);
+    time_t seconds = now();
+    if(snap->seconds == seconds) return snap;
+
+    std::unique_lock<std::mutex> lock(updateMutex, std::try_to_lock);
+    if(lock.owns_lock()) refresh(seconds);
+    return snapshot.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Formats `seconds` into the next slot and publishes it.
+ * @param seconds The wall clock second to format.
+ * @note The caller must hold `updateMutex` (or be the constructor).
+ */
+void Clock::refresh(time_t seconds) noexcept {
+    const Snapshot* snap = snapshot.load(std::memory_order_relaxed);
+    if(snap && snap->seconds == seconds) return; // Another thread already refreshed
+
+    Snapshot& slot = slots[nextSlot];
+    nextSlot = (nextSlot + 1) % SLOT_COUNT;
+
+    struct tm local;
+    struct tm gmt;
+    localtime_r(&seconds, &local);
+    gmtime_r(&seconds, &gmt);
+
+    strftime(slot.log, sizeof(slot.log), "%Y-%m-%d %H:%M:%S", &local);
+
+    // RFC 7231 IMF-fixdate, formatted by hand since strftime's %a/%b are locale dependent
+    static constexpr const char* DAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    static constexpr const char* MONTHS[] = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+    };
+    snprintf(slot.http, sizeof(slot.http), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+        DAYS[gmt.tm_wday], gmt.tm_mday, MONTHS[gmt.tm_mon], gmt.tm_year + 1900,
+        gmt.tm_hour, gmt.tm_min, gmt.tm_sec);
+
+    slot.seconds = seconds;
+    snapshot.store(&slot, std::memory_order_release);
+}
@@ -17,6 +17,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cctype>
 #include <iostream>
 #include <memory>
@@ -61,18 +62,42 @@ void Config::parseCommandLine(int argc, char* argv[]) {
         {"root",          required_argument, 0, 'r'}, // -r or --root path
         {"index",         required_argument, 0, 'i'}, // -i or --index file
         {"threads",       required_argument, 0, 't'}, // -t count or --threads count
+        {"metrics",       required_argument, 0, 'm'}, // -m path or --metrics path
+        {"slow",          required_argument, 0, 's'}, // -s ms or --slow ms
+        {"cache",         required_argument, 0, 'c'}, // -c MB or --cache MB
+        {"websocket",     required_argument, 0, 'w'}, // -w path or --websocket path
+        {"events",        required_argument, 0, 'e'}, // -e path or --events path
+        {"proxy",         required_argument, 0, 'x'}, // -x prefix@host:port[,host:port] or --proxy ...
+        {"balance",       required_argument, 0, 'b'}, // -b policy or --balance policy
+        {"micro-cache",   required_argument, 0, 'k'}, // -k ttl[,stale] or --micro-cache ttl[,stale]
+        {"cache-vary",    required_argument, 0, 'v'}, // -v header[,header] or --cache-vary header[,header]
+        {"conn-limit",    required_argument, 0, 'n'}, // -n rate[,burst] or --conn-limit rate[,burst]
+        {"req-limit",     required_argument, 0, 'l'}, // -l rate[,burst] or --req-limit rate[,burst]
+        {"queue-target",  required_argument, 0, 'q'}, // -q ms or --queue-target ms
         {0,               0,                 0,  0 }  // Required null terminator
     };
 
     // Parse command line arguments
     int opt, option_index, verbosityCount = 0;
-    while((opt = getopt_long(argc, argv, "p:dr:i:t:", long_options, &option_index)) != -1) {
+    while((opt = getopt_long(argc, argv, "p:dr:i:t:m:s:c:w:e:x:b:k:v:n:l:q:", long_options, &option_index)) != -1) {
         switch(opt) {
             case 'p': parsePort(optarg, parsedData);             break;
             case 'd': verbosityCount++; parsedData.debug = true; break;
             case 'r': parseRootFolder(optarg, parsedData);       break;
             case 'i': parseIndexFile(optarg, parsedData);        break;
             case 't': parseThreadCount(optarg, parsedData);      break;
+            case 'm': parseMetricsPath(optarg, parsedData);      break;
+            case 's': parseSlowRequestMs(optarg, parsedData);    break;
+            case 'c': parseResponseCacheMb(optarg, parsedData);  break;
+            case 'w': parseWebSocketPath(optarg, parsedData);    break;
+            case 'e': parseEventsPath(optarg, parsedData);       break;
+            case 'x': parseProxyRoute(optarg, parsedData);       break;
+            case 'b': parseProxyBalance(optarg, parsedData);     break;
+            case 'k': parseMicroCache(optarg, parsedData);       break;
+            case 'v': parseMicroCacheVary(optarg, parsedData);   break;
+            case 'n': parseRateLimit(optarg, parsedData.connectionRate, parsedData.connectionBurst); break;
+            case 'l': parseRateLimit(optarg, parsedData.requestRate, parsedData.requestBurst);       break;
+            case 'q': parseQueueTarget(optarg, parsedData);      break;
             case '?': handleInvalidOption(optopt, argv);         break;
         }
     }
@@ -141,6 +166,220 @@ void Config::parseThreadCount(const char* optarg, ConfigData& data) {
     }
 }
 
+/**
+ * @brief Parses the metrics endpoint path from the command line arguments.
+ * @param optarg The argument value.
+ * @param data The ConfigData struct to store the parsed data.
+ * @throws std::invalid_argument if the path does not start with '/'.
+ */
+void Config::parseMetricsPath(const char* optarg, ConfigData& data) {
+    checkInvalidSyntax(optarg);
+    data.metricsPath = n_utils::str_manip::trim(optarg);
+    if(data.metricsPath.empty() || data.metricsPath.front() != '/') {
+        throw std::invalid_argument("Metrics path must start with '/'.");
+    }
+}
+
+/**
+ * @brief Parses the slow request threshold from the command line arguments.
+ * @param optarg The argument value.
+ * @param data The ConfigData struct to store the parsed data.
+ * @throws std::invalid_argument if the threshold is invalid.
+ */
+void Config::parseSlowRequestMs(const char* optarg, ConfigData& data) {
+    checkInvalidSyntax(optarg);
+    try {
+        data.slowRequestMs = std::stoi(n_utils::str_manip::trim(optarg));
+        if(data.slowRequestMs < 0) {
+            throw std::invalid_argument("Slow request threshold must be 0 or greater.");
+        }
+    }
+    catch(const std::exception& e) {
+        throw std::invalid_argument("Invalid slow request threshold.");
+    }
+}
+
+/**
+ * @brief Parses the response cache size from the command line arguments.
+ * @param optarg The argument value.
+ * @param data The ConfigData struct to store the parsed data.
+ * @throws std::invalid_argument if the size is invalid.
+ */
+void Config::parseResponseCacheMb(const char* optarg, ConfigData& data) {
+    checkInvalidSyntax(optarg);
+    try {
+        data.responseCacheMb = std::stoi(n_utils::str_manip::trim(optarg));
+        if(data.responseCacheMb < 0) {
+            throw std::invalid_argument("Response cache size must be 0 or greater.");
+        }
+    }
+    catch(const std::exception& e) {
+        throw std::invalid_argument("Invalid response cache size.");
+    }
+}
+
+/**
+ * @brief Parses the WebSocket endpoint path from the command line arguments.
+ * @param optarg The argument value.
+ * @param data The ConfigData struct to store the parsed data.
+ * @throws std::invalid_argument if the path does not start with '/'.
+ */
+void Config::parseWebSocketPath(const char* optarg, ConfigData& data) {
+    checkInvalidSyntax(optarg);
+    data.webSocketPath = n_utils::str_manip::trim(optarg);
+    if(data.webSocketPath.empty() || data.webSocketPath.front() != '/') {
+        throw std::invalid_argument("WebSocket path must start with '/'.");
+    }
+}
+
+/**
+ * @brief Parses the Server-Sent Events endpoint path from the command line arguments.
+ * @param optarg The argument value.
+ * @param data The ConfigData struct to store the parsed data.
+ * @throws std::invalid_argument if the path does not start with '/'.
+ */
+void Config::parseEventsPath(const char* optarg, ConfigData& data) {
+    checkInvalidSyntax(optarg);
+    data.eventsPath = n_utils::str_manip::trim(optarg);
+    if(data.eventsPath.empty() || data.eventsPath.front() != '/') {
+        throw std::invalid_argument("Events path must start with '/'.");
+    }
+}
+
+/**
+ * @brief Parses a reverse proxy route from the command line arguments.
+ * @details The format is `prefix@host:port[,host:port...]`; the option may be repeated.
+ * @param optarg The argument value.
+ * @param data The ConfigData struct to store the parsed data.
+ * @throws std::invalid_argument if the prefix does not start with '/' or no upstream is given.
+ */
+void Config::parseProxyRoute(const char* optarg, ConfigData& data) {
+    checkInvalidSyntax(optarg);
+    std::string value = n_utils::str_manip::trim(optarg);
+    size_t at = value.find('@');
+    if(at == std::string::npos) {
+        throw std::invalid_argument("Proxy route must be prefix@host:port[,host:port...].");
+    }
+
+    ProxyRoute route;
+    route.prefix = value.substr(0, at);
+    if(route.prefix.empty() || route.prefix.front() != '/') {
+        throw std::invalid_argument("Proxy prefix must start with '/'.");
+    }
+    if(route.prefix.size() > 1 && route.prefix.back() == '/') route.prefix.pop_back();
+
+    size_t start = at + 1;
+    while(start <= value.size()) {
+        size_t comma = value.find(',', start);
+        std::string upstream = n_utils::str_manip::trim(value.substr(start, comma - start));
+        if(upstream.empty()) throw std::invalid_argument("Proxy upstream must not be empty.");
+        route.upstreams.push_back(std::move(upstream));
+        if(comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    data.proxyRoutes.push_back(std::move(route));
+}
+
+/**
+ * @brief Parses the reverse proxy balancing policy from the command line arguments.
+ * @param optarg The argument value.
+ * @param data The ConfigData struct to store the parsed data.
+ * @throws std::invalid_argument if the policy is unknown.
+ */
+void Config::parseProxyBalance(const char* optarg, ConfigData& data) {
+    checkInvalidSyntax(optarg);
+    data.proxyBalance = n_utils::str_manip::trim(optarg);
+    if(data.proxyBalance != "round-robin" && data.proxyBalance != "rr" &&
+       data.proxyBalance != "least-conn" && data.proxyBalance != "lc") {
+        throw std::invalid_argument("Balance must be round-robin (rr) or least-conn (lc).");
+    }
+}
+
+/**
+ * @brief Parses the micro-cache TTL and stale window from the command line arguments.
+ * @details The format is `ttl-ms[,stale-ms]`; a TTL of 0 disables the micro-cache.
+ * @param optarg The argument value.
+ * @param data The ConfigData struct to store the parsed data.
+ * @throws std::invalid_argument if either value is not a number of 0 or greater.
+ */
+void Config::parseMicroCache(const char* optarg, ConfigData& data) {
+    checkInvalidSyntax(optarg);
+    std::string value = n_utils::str_manip::trim(optarg);
+    size_t comma = value.find(',');
+    try {
+        data.microCacheTtlMs = std::stoi(value.substr(0, comma));
+        data.microCacheStaleMs = (comma == std::string::npos) ? 0 : std::stoi(value.substr(comma + 1));
+        if(data.microCacheTtlMs < 0 || data.microCacheStaleMs < 0) {
+            throw std::invalid_argument("Micro-cache times must be 0 or greater.");
+        }
+    }
+    catch(const std::exception& e) {
+        throw std::invalid_argument("Invalid micro-cache TTL.");
+    }
+}
+
+/**
+ * @brief Parses the request headers that vary micro-cache keys from the command line arguments.
+ * @param optarg The argument value, a comma-separated list of header names.
+ * @param data The ConfigData struct to store the parsed data.
+ */
+void Config::parseMicroCacheVary(const char* optarg, ConfigData& data) {
+    checkInvalidSyntax(optarg);
+    std::string value = optarg;
+    size_t start = 0;
+    while(start <= value.size()) {
+        size_t comma = value.find(',', start);
+        std::string name = n_utils::str_manip::trim(value.substr(start, comma - start));
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+        if(!name.empty()) data.microCacheVary.push_back(std::move(name));
+        if(comma == std::string::npos) break;
+        start = comma + 1;
+    }
+}
+
+/**
+ * @brief Parses a per-client rate limit from the command line arguments.
+ * @details The format is `rate[,burst]` with the rate per second; the burst defaults to the rate.
+ * @param optarg The argument value.
+ * @param rate Receives the rate per second.
+ * @param burst Receives the burst.
+ * @throws std::invalid_argument if the values are not numbers in range.
+ */
+void Config::parseRateLimit(const char* optarg, int& rate, int& burst) {
+    checkInvalidSyntax(optarg);
+    std::string value = n_utils::str_manip::trim(optarg);
+    size_t comma = value.find(',');
+    try {
+        rate = std::stoi(value.substr(0, comma));
+        burst = (comma == std::string::npos) ? std::min(rate, MAX_RATE_BURST) : std::stoi(value.substr(comma + 1));
+        if(rate < 0 || rate > MAX_RATE || (rate > 0 && (burst < 1 || burst > MAX_RATE_BURST))) {
+            throw std::invalid_argument("Rate limit out of range.");
+        }
+    }
+    catch(const std::exception& e) {
+        throw std::invalid_argument("Invalid rate limit, expected rate[,burst] with a burst of 1 to " + std::to_string(MAX_RATE_BURST) + ".");
+    }
+}
+
+/**
+ * @brief Parses the queue delay target for load shedding from the command line arguments.
+ * @param optarg The argument value.
+ * @param data The ConfigData struct to store the parsed data.
+ * @throws std::invalid_argument if the target is invalid.
+ */
+void Config::parseQueueTarget(const char* optarg, ConfigData& data) {
+    checkInvalidSyntax(optarg);
+    try {
+        data.queueTargetMs = std::stoi(n_utils::str_manip::trim(optarg));
+        if(data.queueTargetMs < 0) {
+            throw std::invalid_argument("Queue delay target must be 0 or greater.");
+        }
+    }
+    catch(const std::exception& e) {
+        throw std::invalid_argument("Invalid queue delay target.");
+    }
+}
+
 /**
  * @brief Handles invalid command line options.
  * @param optopt The invalid option character.
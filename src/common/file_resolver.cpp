@@ -29,7 +29,7 @@
  * @returns A variant containing the full path or a status reason.
  */
 std::variant<std::string, http::status::Code> FileResolver::sanitizePath(std::string_view uri) const {
-    Logger::getInstance().log("Sanitizing path: " + std::string(uri), Logger::LogLevel::DEBUG);
+    Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] { return "Sanitizing path: " + std::string(uri); });
 
     // Get canonical root folder using realpath
     char rootResolved[PATH_MAX];
@@ -68,7 +68,7 @@ std::variant<std::string, http::status::Code> FileResolver::sanitizePath(std::st
         return http::status::Code::NOT_FOUND;
     }
     std::string fullPath(fullResolved);
-    Logger::getInstance().log("Resolved full path: " + fullPath, Logger::LogLevel::DEBUG);
+    Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] { return "Resolved full path: " + fullPath; });
 
     // Check that fullPath begins with root folder (prevent traversal)
     if(fullPath.find(root) != 0) {
@@ -9,8 +9,8 @@
  * COP4635 Sys & Net II - Project 1
  */
 
+#include "clock.hpp"
 #include "logger.hpp"
-#include "n_utils.hpp"
 
 #include <iostream>
 #include <mutex>
@@ -19,32 +19,34 @@
 #include <sstream>
 
 /**
- * @brief This method logs a message to the console.
- * @param message The message to log.
- * @param level The log level of the message.
+ * @brief Returns the stream used for non-error log messages.
  */
-void Logger::log(std::string_view message, const LogLevel& level) noexcept {
-    std::ostream& out = (level == LogLevel::ERROR) ? std::cerr : std::cout;
-    log(message, level, out);
+std::ostream& Logger::outputStream() noexcept {
+    return std::cout;
 }
 
 /**
- * @brief This method logs a message to the specified output stream.
- * @details The `out` param allows the caller to specify what stream type to write to.
+ * @brief Returns the stream used for error log messages.
+ */
+std::ostream& Logger::errorStream() noexcept {
+    return std::cerr;
+}
+
+/**
+ * @brief This method writes a message to the specified output stream.
+ * @details The level check is done inline by `log()`, so this is only reached
+ * for messages that will actually be printed.
  * @param message The message to log.
  * @param level The log level of the message.
  * @param out The output stream to write the log message to.
  */
-void Logger::log(std::string_view message, const LogLevel& level, std::ostream& out) noexcept {
-    // Prevent messages below the current log level from being printed
-    if(level < currentLevel) return;
-
+void Logger::write(std::string_view message, const LogLevel& level, std::ostream& out) noexcept {
     // Lock the mutex to prevent multiple threads from writing at the same time
     std::scoped_lock<std::mutex> lock(logMutex);
 
     std::ostringstream oss;
     // Add the timestamp and log level to the message
-    oss << "[" << n_utils::io_time::getCurrentTimestamp() << "]" << "[" << toString(level) << "]";
+    oss << "[" << Clock::getInstance().getLogTimestamp() << "]" << "[" << toString(level) << "]";
 
     // Add padding to the message based on the log level
     if(level == LogLevel::DEBUG || level == LogLevel::ERROR) oss << " " << message;
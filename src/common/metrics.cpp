@@ -0,0 +1,274 @@
+/**
+ * @file metrics.cpp
+ * @brief This file contains the definition of the Metrics class.
+ * @details This class is a singleton that collects server counters, gauges and latency
+ * histograms, and renders them in the Prometheus text exposition format.
+ * 
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "http_method.hpp"
+#include "http_status.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+namespace {
+    constexpr const char* COUNTER_NAMES[] = {
+        "http_connections_accepted_total",
+        "http_keep_alive_reused_total",
+        "http_response_bytes_sent_total",
+        "http_response_bytes_sendfile_total",
+        "http_response_cache_hits_total",
+        "http_response_cache_misses_total",
+        "websocket_messages_received_total",
+        "sse_events_published_total",
+        "sse_events_dropped_total",
+        "proxy_upstream_connects_total",
+        "proxy_upstream_reused_total",
+        "proxy_upstream_failures_total",
+        "micro_cache_hits_total",
+        "micro_cache_misses_total",
+        "micro_cache_stale_total",
+        "micro_cache_coalesced_total",
+        "rate_limited_connections_total",
+        "rate_limited_requests_total",
+        "http_connections_shed_total"
+    };
+
+    constexpr const char* COUNTER_HELP[] = {
+        "Client connections accepted.",
+        "Requests served on an already used keep-alive connection.",
+        "Bytes written with send().",
+        "Bytes written with sendfile().",
+        "GET requests served from the response cache.",
+        "GET requests that missed the response cache.",
+        "Complete WebSocket messages received.",
+        "Server-Sent Events published.",
+        "Server-Sent Events dropped from the queue of a slow subscriber.",
+        "Connections opened to proxy upstreams.",
+        "Proxied requests sent on a pooled upstream connection.",
+        "Proxy upstream connections that failed or answered with a malformed response.",
+        "Dynamic responses served fresh from the micro-cache.",
+        "Dynamic responses built because the micro-cache had no usable entry.",
+        "Stale micro-cache entries served while another request refreshed them.",
+        "Requests that waited for an identical request's build instead of building their own.",
+        "Connections refused at accept time because the client exceeded its connection rate.",
+        "Requests answered with 429 because the client exceeded its request rate.",
+        "Connections answered with 503 because the queue delay stayed above target."
+    };
+
+    constexpr const char* GAUGE_NAMES[] = {
+        "http_active_connections",
+        "http_thread_pool_queue_depth",
+        "websocket_open_connections",
+        "sse_subscribers"
+    };
+
+    constexpr const char* GAUGE_HELP[] = {
+        "Connections currently being handled.",
+        "Connections waiting in the thread pool queue.",
+        "WebSocket connections parked in the event loop.",
+        "Server-Sent Events streams parked in the event loop."
+    };
+
+    constexpr const char* HISTOGRAM_NAMES[] = {
+        "http_request_duration_seconds",
+        "http_thread_pool_queue_wait_seconds"
+    };
+
+    constexpr const char* HISTOGRAM_HELP[] = {
+        "Time from parsed request to response sent.",
+        "Time a connection waited in the thread pool queue."
+    };
+
+    /**
+     * @brief Formats a microsecond bound as seconds for the `le` label.
+     */
+    std::string formatSeconds(uint64_t microseconds) {
+        std::ostringstream oss;
+        oss << static_cast<double>(microseconds) / 1e6;
+        return oss.str();
+    }
+
+    /**
+     * @brief Formats a nanosecond total as seconds for `_sum`.
+     * @details Written with every significant digit of the double; the stream default of 6 would
+     * round a growing sum off, so rates computed from it would read as zero.
+     */
+    std::string formatSum(uint64_t nanoseconds) {
+        std::ostringstream oss;
+        oss << std::setprecision(std::numeric_limits<double>::max_digits10) << static_cast<double>(nanoseconds) / 1e9;
+        return oss.str();
+    }
+}
+
+// Constructors //
+
+/**
+ * @brief Constructs the Metrics object and builds the dense status code index.
+ */
+Metrics::Metrics() {
+    // Slot 0 collects any code that is not a known status code
+    size_t next = 1;
+    for(http::status::Code code : http::status::ALL_CODES) {
+        int value = static_cast<int>(code);
+        if(value <= 0 || value >= static_cast<int>(MAX_STATUS) || next >= STATUS_SLOTS) continue;
+        statusIndex[value] = static_cast<uint8_t>(next);
+        statusCodes[next] = code;
+        next++;
+    }
+}
+
+// Recording //
+
+/**
+ * @brief Increments a counter on the calling thread's shard.
+ * @param counter The counter to increment.
+ * @param amount The amount to add.
+ */
+void Metrics::increment(Counter counter, uint64_t amount) noexcept {
+    add(localShard().counters[static_cast<size_t>(counter)], amount);
+}
+
+/**
+ * @brief Adjusts a shared gauge.
+ * @param gauge The gauge to adjust.
+ * @param delta The (signed) amount to add.
+ */
+void Metrics::adjust(Gauge gauge, int64_t delta) noexcept {
+    gauges[static_cast<size_t>(gauge)].value.fetch_add(delta, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Records a duration in a latency histogram.
+ * @param histogram The histogram to record into.
+ * @param duration The measured duration.
+ */
+void Metrics::observe(Histogram histogram, std::chrono::nanoseconds duration) noexcept {
+    HistogramData& data = localShard().histograms[static_cast<size_t>(histogram)];
+    uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+    uint64_t us = ns / 1000;
+
+    size_t bucket = 0;
+    while(bucket < BUCKET_BOUNDS_US.size() && us > BUCKET_BOUNDS_US[bucket]) bucket++;
+
+    add(data.buckets[bucket], 1);
+    add(data.sumNs, ns);
+    add(data.count, 1);
+}
+
+/**
+ * @brief Counts a completed request by method and status code.
+ * @param method The request method.
+ * @param code The response status code.
+ */
+void Metrics::recordRequest(http::method::Method method, http::status::Code code) noexcept {
+    size_t methodSlot = std::min(static_cast<size_t>(method), METHOD_COUNT - 1);
+    int value = static_cast<int>(code);
+    size_t statusSlot = (value > 0 && value < static_cast<int>(MAX_STATUS)) ? statusIndex[value] : 0;
+    add(localShard().requests[methodSlot][statusSlot], 1);
+}
+
+// Functions //
+
+/**
+ * @brief Renders every metric in the Prometheus text format.
+ * @return The exposition text.
+ */
+std::string Metrics::render() const {
+    std::array<uint64_t, COUNTER_COUNT> counters{};
+    std::array<std::array<uint64_t, STATUS_SLOTS>, METHOD_COUNT> requests{};
+    std::array<std::array<uint64_t, BUCKET_COUNT>, HISTOGRAM_COUNT> buckets{};
+    std::array<uint64_t, HISTOGRAM_COUNT> sums{};
+    std::array<uint64_t, HISTOGRAM_COUNT> counts{};
+
+    // Sum the shards
+    {
+        std::scoped_lock<std::mutex> lock(registryMutex);
+        for(const auto& shard : shards) {
+            for(size_t i = 0; i < COUNTER_COUNT; ++i) {
+                counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+            }
+            for(size_t m = 0; m < METHOD_COUNT; ++m) {
+                for(size_t s = 0; s < STATUS_SLOTS; ++s) {
+                    requests[m][s] += shard->requests[m][s].load(std::memory_order_relaxed);
+                }
+            }
+            for(size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+                const HistogramData& data = shard->histograms[h];
+                for(size_t b = 0; b < BUCKET_COUNT; ++b) {
+                    buckets[h][b] += data.buckets[b].load(std::memory_order_relaxed);
+                }
+                sums[h] += data.sumNs.load(std::memory_order_relaxed);
+                counts[h] += data.count.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::ostringstream oss;
+
+    oss << "# HELP http_requests_total Requests served by method and status code.\n"
+        << "# TYPE http_requests_total counter\n";
+    for(size_t m = 0; m < METHOD_COUNT; ++m) {
+        for(size_t s = 0; s < STATUS_SLOTS; ++s) {
+            if(requests[m][s] == 0) continue;
+            oss << "http_requests_total{method=\"" << http::method::toString(static_cast<http::method::Method>(m))
+                << "\",code=\"" << (s == 0 ? "other" : http::status::getCode(statusCodes[s]))
+                << "\"} " << requests[m][s] << "\n";
+        }
+    }
+
+    for(size_t i = 0; i < COUNTER_COUNT; ++i) {
+        oss << "# HELP " << COUNTER_NAMES[i] << " " << COUNTER_HELP[i] << "\n"
+            << "# TYPE " << COUNTER_NAMES[i] << " counter\n"
+            << COUNTER_NAMES[i] << " " << counters[i] << "\n";
+    }
+
+    for(size_t i = 0; i < GAUGE_COUNT; ++i) {
+        oss << "# HELP " << GAUGE_NAMES[i] << " " << GAUGE_HELP[i] << "\n"
+            << "# TYPE " << GAUGE_NAMES[i] << " gauge\n"
+            << GAUGE_NAMES[i] << " " << gauges[i].value.load(std::memory_order_relaxed) << "\n";
+    }
+
+    for(size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+        const char* name = HISTOGRAM_NAMES[h];
+        oss << "# HELP " << name << " " << HISTOGRAM_HELP[h] << "\n"
+            << "# TYPE " << name << " histogram\n";
+
+        uint64_t cumulative = 0;
+        for(size_t b = 0; b < BUCKET_COUNT; ++b) {
+            cumulative += buckets[h][b];
+            oss << name << "_bucket{le=\""
+                << (b < BUCKET_BOUNDS_US.size() ? formatSeconds(BUCKET_BOUNDS_US[b]) : "+Inf")
+                << "\"} " << cumulative << "\n";
+        }
+        oss << name << "_sum " << formatSum(sums[h]) << "\n"
+            << name << "_count " << counts[h] << "\n";
+    }
+
+    return oss.str();
+}
+
+// Helpers //
+
+/**
+ * @brief Returns the calling thread's shard, registering one on first use.
+ * @note The registry lock is only taken once per thread.
+ */
+Metrics::Shard& Metrics::localShard() {
+    thread_local Shard* shard = nullptr;
+    if(shard) return *shard;
+
+    std::scoped_lock<std::mutex> lock(registryMutex);
+    shards.push_back(std::make_unique<Shard>());
+    shard = shards.back().get();
+    return *shard;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file request_timer.cpp
+ * @brief This file contains the definition of the RequestTimer class.
+ * @details It records timestamps for each phase of a request's lifecycle so slow
+ * requests can be broken down into queueing, disk and network time.
+ * 
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "request_timer.hpp"
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+thread_local RequestTimer* RequestTimer::active = nullptr;
+
+// Functions //
+
+/**
+ * @brief Gets the time between the first and last recorded phases.
+ * @return The elapsed duration, or zero if fewer than two phases were recorded.
+ */
+RequestTimer::Clock::duration RequestTimer::elapsed() const noexcept {
+    Clock::time_point first{};
+    Clock::time_point last{};
+    for(const auto& mark : marks) {
+        if(mark == Clock::time_point{}) continue;
+        if(first == Clock::time_point{} || mark < first) first = mark;
+        if(mark > last) last = mark;
+    }
+    return last - first;
+}
+
+/**
+ * @brief Describes how long each recorded phase took since the previous one.
+ * @return A string such as "enqueued=+0.012ms dequeued=+3.401ms ... total=5.120ms".
+ */
+std::string RequestTimer::describe() const {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3);
+
+    Clock::time_point previous{};
+    for(size_t i = 0; i < PHASE_COUNT; ++i) {
+        if(marks[i] == Clock::time_point{}) continue;
+        if(previous != Clock::time_point{}) {
+            std::chrono::duration<double, std::milli> delta = marks[i] - previous;
+            oss << toString(static_cast<Phase>(i)) << "=+" << delta.count() << "ms ";
+        }
+        previous = marks[i];
+    }
+
+    std::chrono::duration<double, std::milli> total = elapsed();
+    oss << "total=" << total.count() << "ms";
+    return oss.str();
+}
+
+// Helpers //
+
+/**
+ * @brief Converts a phase to its display name.
+ */
+const char* RequestTimer::toString(Phase phase) noexcept {
+    switch(phase) {
+        case Phase::ACCEPTED:       return "accepted";
+        case Phase::ENQUEUED:       return "enqueued";
+        case Phase::DEQUEUED:       return "dequeued";
+        case Phase::FIRST_BYTE:     return "first_byte";
+        case Phase::HEADERS_PARSED: return "headers_parsed";
+        case Phase::RESOLVED:       return "resolved";
+        case Phase::RESPONSE_BUILT: return "response_built";
+        case Phase::HEADERS_SENT:   return "headers_sent";
+        case Phase::BODY_SENT:      return "body_sent";
+        default:                    return "unknown";
+    }
+}
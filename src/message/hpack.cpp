@@ -0,0 +1,378 @@
+/**
+ * @file hpack.cpp
+ * @brief This file contains the definitions of the HPACK primitives and the HpackDecoder class.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "hpack.hpp"
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+
+namespace {
+    constexpr size_t SYMBOL_COUNT = 257; // 256 octets and EOS
+    constexpr size_t MAX_CODE_LENGTH = 30;
+
+    /**
+     * @brief The Huffman code length of every octet (RFC 7541 Appendix B), EOS is 30 bits.
+     * @details The code is canonical, so the codes themselves follow from the lengths.
+     */
+    constexpr std::array<uint8_t, SYMBOL_COUNT> CODE_LENGTHS = {
+        13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+        28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+        6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+        5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+        13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+        7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+        15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+        6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+        20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+        24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+        22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+        21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+        26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+        19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+        20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+        26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+        30
+    };
+
+    /**
+     * @brief The canonical Huffman tables derived from `CODE_LENGTHS`.
+     */
+    struct HuffmanTables {
+        std::array<uint32_t, SYMBOL_COUNT> codes{};                 // Code of each symbol
+        std::array<uint32_t, MAX_CODE_LENGTH + 1> firstCode{};      // First code of each length
+        std::array<uint16_t, MAX_CODE_LENGTH + 1> count{};          // Number of codes of each length
+        std::array<uint16_t, MAX_CODE_LENGTH + 1> offset{};         // Index into `symbols` of each length
+        std::array<uint16_t, SYMBOL_COUNT> symbols{};               // Symbols sorted by (length, symbol)
+    };
+
+    constexpr HuffmanTables makeHuffmanTables() noexcept {
+        HuffmanTables tables{};
+        uint32_t code = 0;
+        uint16_t index = 0;
+        for(size_t length = 1; length <= MAX_CODE_LENGTH; ++length) {
+            tables.firstCode[length] = code;
+            tables.offset[length] = index;
+            for(size_t symbol = 0; symbol < SYMBOL_COUNT; ++symbol) {
+                if(CODE_LENGTHS[symbol] != length) continue;
+                tables.codes[symbol] = code++;
+                tables.symbols[index++] = static_cast<uint16_t>(symbol);
+                ++tables.count[length];
+            }
+            code <<= 1;
+        }
+        return tables;
+    }
+
+    constexpr HuffmanTables HUFFMAN = makeHuffmanTables();
+
+    // Spot checks against RFC 7541 Appendix B
+    static_assert(HUFFMAN.codes['0'] == 0x0 && HUFFMAN.codes[' '] == 0x14 && HUFFMAN.codes['a'] == 0x3);
+    static_assert(HUFFMAN.codes[0] == 0x1ff8 && HUFFMAN.codes[255] == 0x3ffffee && HUFFMAN.codes[256] == 0x3fffffff);
+
+    /**
+     * @brief Decodes a prefixed integer (RFC 7541 Section 5.1).
+     * @param data The remaining block, advanced past the integer.
+     * @param prefixBits The number of bits of the first byte that belong to the integer.
+     * @param value Receives the integer.
+     * @return `false` if the integer is truncated or too large.
+     */
+    bool decodeInteger(std::string_view& data, uint8_t prefixBits, uint64_t& value) noexcept {
+        if(data.empty()) return false;
+        uint64_t maxPrefix = (1u << prefixBits) - 1;
+        value = static_cast<uint8_t>(data[0]) & maxPrefix;
+        data.remove_prefix(1);
+        if(value < maxPrefix) return true;
+
+        for(unsigned shift = 0; shift <= 28; shift += 7) {
+            if(data.empty()) return false;
+            uint8_t byte = static_cast<uint8_t>(data[0]);
+            data.remove_prefix(1);
+            value += static_cast<uint64_t>(byte & 0x7F) << shift;
+            if((byte & 0x80) == 0) return true;
+        }
+        return false; // Longer than any size this decoder accepts
+    }
+
+    /**
+     * @brief Decodes a string literal (RFC 7541 Section 5.2).
+     * @param data The remaining block, advanced past the string.
+     * @param out Receives the string.
+     * @return `false` if the string is truncated or its Huffman coding is invalid.
+     */
+    bool decodeString(std::string_view& data, std::string& out) {
+        if(data.empty()) return false;
+        bool huffman = (static_cast<uint8_t>(data[0]) & 0x80) != 0;
+        uint64_t length;
+        if(!decodeInteger(data, 7, length) || length > data.size()) return false;
+
+        std::string_view raw = data.substr(0, length);
+        data.remove_prefix(length);
+        out.clear();
+        if(!huffman) {
+            out.assign(raw);
+            return true;
+        }
+        return http::hpack::huffmanDecode(raw, out);
+    }
+}
+
+namespace http::hpack {
+    /**
+     * @brief Encodes a prefixed integer (RFC 7541 Section 5.1).
+     * @param value The integer.
+     * @param prefixBits The number of bits of the first byte used by the integer.
+     * @param firstByte The representation's flag bits for the first byte.
+     * @param out The block to append to.
+     */
+    void encodeInteger(uint64_t value, uint8_t prefixBits, uint8_t firstByte, std::string& out) {
+        uint64_t maxPrefix = (1u << prefixBits) - 1;
+        if(value < maxPrefix) {
+            out.push_back(static_cast<char>(firstByte | value));
+            return;
+        }
+        out.push_back(static_cast<char>(firstByte | maxPrefix));
+        value -= maxPrefix;
+        while(value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    /**
+     * @brief Encodes a string literal, Huffman coded when that is shorter.
+     * @param str The string.
+     * @param out The block to append to.
+     */
+    void encodeString(std::string_view str, std::string& out) {
+        size_t huffmanLength = huffmanEncodedLength(str);
+        if(huffmanLength < str.size()) {
+            encodeInteger(huffmanLength, 7, 0x80, out);
+            huffmanEncode(str, out);
+        }
+        else {
+            encodeInteger(str.size(), 7, 0x00, out);
+            out.append(str);
+        }
+    }
+
+    /**
+     * @brief Encodes the `:status` pseudo-header, as one byte for the static-table codes.
+     * @param status The status code.
+     * @param out The block to append to.
+     */
+    void encodeStatus(int status, std::string& out) {
+        switch(status) {
+            case 200: out.push_back(static_cast<char>(0x80 | 8));  return;
+            case 204: out.push_back(static_cast<char>(0x80 | 9));  return;
+            case 206: out.push_back(static_cast<char>(0x80 | 10)); return;
+            case 304: out.push_back(static_cast<char>(0x80 | 11)); return;
+            case 400: out.push_back(static_cast<char>(0x80 | 12)); return;
+            case 404: out.push_back(static_cast<char>(0x80 | 13)); return;
+            case 500: out.push_back(static_cast<char>(0x80 | 14)); return;
+            default: break;
+        }
+        char digits[3];
+        auto result = std::to_chars(digits, digits + sizeof(digits), status);
+        encodeInteger(8, 4, 0x00, out); // Literal without indexing, name `:status`
+        encodeInteger(static_cast<uint64_t>(result.ptr - digits), 7, 0x00, out);
+        out.append(digits, result.ptr);
+    }
+
+    /**
+     * @brief Encodes a header field as a literal without indexing.
+     * @details Uses the static table for the name when it has one; nothing is added to the
+     * peer's dynamic table.
+     * @param name The lowercase header name.
+     * @param value The header value.
+     * @param out The block to append to.
+     */
+    void encodeField(std::string_view name, std::string_view value, std::string& out) {
+        if(size_t index = staticNameIndex(name); index != 0) {
+            encodeInteger(index, 4, 0x00, out);
+        }
+        else {
+            out.push_back(0x00);
+            encodeString(name, out);
+        }
+        encodeString(value, out);
+    }
+
+    /**
+     * @brief Computes the Huffman coded length of a string.
+     * @param str The string.
+     * @return The length in bytes, including the EOS padding.
+     */
+    size_t huffmanEncodedLength(std::string_view str) noexcept {
+        size_t bits = 0;
+        for(unsigned char c : str) bits += CODE_LENGTHS[c];
+        return (bits + 7) / 8;
+    }
+
+    /**
+     * @brief Huffman codes a string, padding the last byte with the EOS prefix.
+     * @param str The string.
+     * @param out The block to append to.
+     */
+    void huffmanEncode(std::string_view str, std::string& out) {
+        uint64_t buffer = 0;
+        unsigned bits = 0;
+        for(unsigned char c : str) {
+            buffer = (buffer << CODE_LENGTHS[c]) | HUFFMAN.codes[c];
+            bits += CODE_LENGTHS[c];
+            while(bits >= 8) {
+                bits -= 8;
+                out.push_back(static_cast<char>(buffer >> bits));
+            }
+        }
+        if(bits > 0) {
+            out.push_back(static_cast<char>((buffer << (8 - bits)) | (0xFF >> bits)));
+        }
+    }
+
+    /**
+     * @brief Decodes a Huffman coded string.
+     * @details Walks the canonical code one bit at a time: a code of length `n` is complete
+     * once it falls inside the range of codes of that length.
+     * @param str The coded bytes.
+     * @param out The string to append to.
+     * @return `false` if the coding is invalid (EOS in the data, or bad padding).
+     */
+    bool huffmanDecode(std::string_view str, std::string& out) {
+        out.reserve(out.size() + str.size() * 8 / 5);
+        uint32_t code = 0;
+        size_t length = 0;
+        for(unsigned char byte : str) {
+            for(int bit = 7; bit >= 0; --bit) {
+                code = (code << 1) | ((byte >> bit) & 1);
+                ++length;
+                uint32_t index = code - HUFFMAN.firstCode[length];
+                if(index < HUFFMAN.count[length]) {
+                    uint16_t symbol = HUFFMAN.symbols[HUFFMAN.offset[length] + index];
+                    if(symbol == 256) return false; // EOS must not appear in the data
+                    out.push_back(static_cast<char>(symbol));
+                    code = 0;
+                    length = 0;
+                }
+                else if(length == MAX_CODE_LENGTH) {
+                    return false;
+                }
+            }
+        }
+        // Padding is at most 7 bits, all ones (a prefix of EOS)
+        return length < 8 && code == (1u << length) - 1;
+    }
+}
+
+// HpackDecoder //
+
+/**
+ * @brief Decodes a complete header block.
+ * @param block The header block, joined from HEADERS and CONTINUATION frames.
+ * @param fields Receives the decoded fields, replacing its content.
+ * @param maxListSize The largest decoded header list accepted (names, values and 32 bytes each).
+ * @return `false` on a compression error, which is fatal for the connection.
+ */
+bool HpackDecoder::decode(std::string_view block, HeaderList& fields, size_t maxListSize) {
+    fields.clear();
+    size_t listSize = 0;
+    bool sizeUpdateAllowed = true;
+
+    while(!block.empty()) {
+        uint8_t first = static_cast<uint8_t>(block[0]);
+        std::string name;
+        std::string value;
+
+        if(first & 0x80) {
+            // Indexed header field
+            uint64_t index;
+            std::string_view n, v;
+            if(!decodeInteger(block, 7, index) || !lookup(index, n, v)) return false;
+            name.assign(n);
+            value.assign(v);
+        }
+        else if((first & 0xE0) == 0x20) {
+            // Dynamic table size update, only allowed before the first field
+            uint64_t size;
+            if(!sizeUpdateAllowed || !decodeInteger(block, 5, size) || size > tableLimit) return false;
+            tableCapacity = size;
+            evict(0);
+            continue;
+        }
+        else {
+            // Literal, with incremental indexing (01), without indexing (0000) or never indexed (0001)
+            bool indexing = (first & 0xC0) == 0x40;
+            uint64_t index;
+            if(!decodeInteger(block, indexing ? 6 : 4, index)) return false;
+            if(index == 0) {
+                if(!decodeString(block, name)) return false;
+            }
+            else {
+                std::string_view n, v;
+                if(!lookup(index, n, v)) return false;
+                name.assign(n);
+            }
+            if(!decodeString(block, value)) return false;
+            if(indexing) insert(name, value);
+        }
+
+        sizeUpdateAllowed = false;
+        listSize += name.size() + value.size() + http::hpack::ENTRY_OVERHEAD;
+        if(listSize > maxListSize) return false;
+        fields.emplace_back(std::move(name), std::move(value));
+    }
+    return true;
+}
+
+// Helpers //
+
+/**
+ * @brief Resolves an index into the static or dynamic table.
+ * @return `false` if the index is out of range.
+ */
+bool HpackDecoder::lookup(uint64_t index, std::string_view& name, std::string_view& value) const noexcept {
+    if(index == 0) return false;
+    if(index <= http::hpack::STATIC_TABLE_SIZE) {
+        name = http::hpack::STATIC_TABLE[index - 1].name;
+        value = http::hpack::STATIC_TABLE[index - 1].value;
+        return true;
+    }
+    index -= http::hpack::STATIC_TABLE_SIZE + 1;
+    if(index >= table.size()) return false;
+    name = table[index].first;
+    value = table[index].second;
+    return true;
+}
+
+/**
+ * @brief Adds an entry to the dynamic table, evicting the oldest entries to make room.
+ * @note An entry larger than the table empties it and is not added (RFC 7541 Section 4.4).
+ */
+void HpackDecoder::insert(std::string name, std::string value) {
+    size_t size = name.size() + value.size() + http::hpack::ENTRY_OVERHEAD;
+    if(size > tableCapacity) {
+        table.clear();
+        tableSize = 0;
+        return;
+    }
+    evict(size);
+    table.emplace_front(std::move(name), std::move(value));
+    tableSize += size;
+}
+
+/**
+ * @brief Evicts the oldest entries until `needed` more bytes fit.
+ */
+void HpackDecoder::evict(size_t needed) noexcept {
+    while(!table.empty() && tableSize + needed > tableCapacity) {
+        tableSize -= table.back().first.size() + table.back().second.size() + http::hpack::ENTRY_OVERHEAD;
+        table.pop_back();
+    }
+}
@@ -14,8 +14,10 @@
 #include "logger.hpp"
 #include "n_utils.hpp"
 
+#include <charconv>
 #include <iostream>
 #include <sstream>
+#include <system_error>
 
 // Getters //
 
@@ -25,14 +27,46 @@ std::string HttpRequest::getStatusLine() const noexcept {
     return oss.str();
 }
 
+/**
+ * @brief Gets the value of the Content-Length header.
+ * @return The body length, or `std::nullopt` if the header is absent or not a valid number.
+ */
+std::optional<size_t> HttpRequest::getContentLength() const {
+    auto header = getHeader("Content-Length");
+    if(!header) return std::nullopt;
+    std::string_view value = header->substr(0, header->find_last_not_of(" \t") + 1);
+
+    size_t length = 0;
+    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), length);
+    if(ec != std::errc() || ptr != value.data() + value.size() || value.empty()) return std::nullopt;
+    return length;
+}
+
 // Functions //
 
 /**
  * @brief Parse raw HTTP request data into a structured object.
  * @param rawData The raw HTTP request data.
  * @return `true` if parsing succeeded, `false` if invalid.
+ * @note The body is a view into `rawData`, which must outlive the request.
  */
 bool HttpRequest::parse(std::string_view rawData) {
+    size_t bodyStart = 0;
+    if(!parseHead(rawData, bodyStart)) return false;
+    if(!parseBody(rawData, bodyStart)) {
+        Logger::getInstance().log("Malformed request: Invalid body.", Logger::LogLevel::ERROR);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse the start line and headers of a request.
+ * @param rawData The raw HTTP request data, at least up to the blank line ending the headers.
+ * @param bodyStart Set to the offset of the first body byte in `rawData`.
+ * @return `true` if parsing succeeded, `false` if invalid.
+ */
+bool HttpRequest::parseHead(std::string_view rawData, size_t& bodyStart) {
     size_t startLineEnd = rawData.find("\r\n");
     if(startLineEnd == std::string_view::npos) {
         Logger::getInstance().log("Malformed request: Missing start line end.", Logger::LogLevel::ERROR);
@@ -52,13 +86,31 @@ bool HttpRequest::parse(std::string_view rawData) {
     }
     std::string_view headersBlock = rawData.substr(headersStart, headersEnd - headersStart);
     parseHeaders(headersBlock);
-    
-    size_t bodyStart = headersEnd + 4; // Move past "\r\n\r\n"
-    if(!parseBody(rawData, bodyStart)) {
-        Logger::getInstance().log("Malformed request: Invalid body.", Logger::LogLevel::ERROR);
+
+    // Check for Content-Length (impl. Transfer-Encoding later)
+    if(getHeader("Content-Length") && !getContentLength()) {
+        Logger::getInstance().log("Invalid Content-Length header.", Logger::LogLevel::ERROR);
         return false;
     }
 
+    bodyStart = headersEnd + 4; // Move past "\r\n\r\n"
+    return true;
+}
+
+/**
+ * @brief Attaches the request body once all of it has been received.
+ * @param rawData The raw HTTP request data.
+ * @param bodyStart The offset of the first body byte, from `parseHead`.
+ * @return `true` if the full body is present, `false` if it is incomplete.
+ * @note The body is a view into `rawData`, which must outlive the request.
+ */
+bool HttpRequest::parseBody(std::string_view rawData, size_t bodyStart) {
+    size_t contentLength = getContentLength().value_or(0);
+    if(bodyStart > rawData.size() || rawData.size() - bodyStart < contentLength) {
+        Logger::getInstance().log("Incomplete request body received.", Logger::LogLevel::ERROR);
+        return false;
+    }
+    setBody(MessageBody(nullptr, rawData.substr(bodyStart, contentLength)));
     return true;
 }
 
@@ -122,37 +174,6 @@ void HttpRequest::parseHeaders(std::string_view headersBlock) {
     }
 }
 
-bool HttpRequest::parseBody(std::string_view rawData, const size_t& bodyStart) {
-    if(bodyStart < rawData.size()) {
-        // Check for Content-Length (impl. Transfer-Encoding later)
-        if(auto contentLengthHeader = getHeader("Content-Length")) {
-            try {
-                size_t contentLength = std::stoul(std::string(*contentLengthHeader));
-                if(rawData.size() - bodyStart >= contentLength) {
-                    setBody(rawData.substr(bodyStart, contentLength));
-                } 
-                else {
-                    Logger::getInstance().log("Incomplete request body received.", Logger::LogLevel::ERROR);
-                    return false;
-                }
-            } 
-            catch(const std::invalid_argument& e) {
-                Logger::getInstance().log("Invalid Content-Length header.", Logger::LogLevel::ERROR);
-                return false;
-            }
-            catch(const std::out_of_range& e) {
-                Logger::getInstance().log("Content-Length value out of range.", Logger::LogLevel::ERROR);
-                return false;
-            }
-        } 
-    }
-    else{
-        setBody("");
-    }
-
-    return true;
-}
-
 /**
  * @brief Displays the HTTP request for debugging.
  */
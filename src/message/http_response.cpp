@@ -18,7 +18,12 @@
 
 // Constructors //
 
-HttpResponse::HttpResponse() noexcept : status(http::status::Code::OK), isStatic(false) {}
+/**
+ * @brief Constructs a new HttpResponse object.
+ * @param resource The memory resource backing the headers and strings, normally the connection arena.
+ */
+HttpResponse::HttpResponse(std::pmr::memory_resource* resource)
+    : HttpMessage(resource), status(http::status::Code::OK), isStatic(false), filePath(resource) {}
 
 // Overrides //
 
@@ -45,6 +50,7 @@ void HttpResponse::display() const {
     for(const auto& [key, value] : getAllHeaders()) {
         oss << key << ": " << value << "\n";
     }
+    if(contentLength) oss << "content-length: " << *contentLength << "\n";
 
     oss << n_utils::io_style::seperator("Body", '-', lineWidth) << "\n";
     oss << getBody() << "\n";
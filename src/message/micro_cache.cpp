@@ -0,0 +1,225 @@
+/**
+ * @file micro_cache.cpp
+ * @brief This file contains the definition of the MicroCache class.
+ * @details The micro-cache keeps the responses of a dynamic route for a short time, so a burst
+ * of identical requests is answered from memory. Requests that miss together are coalesced:
+ * one of them builds the response and the others wait for it.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "metrics.hpp"
+#include "micro_cache.hpp"
+#include "n_utils.hpp"
+
+#include <algorithm>
+
+// Constructors //
+
+/**
+ * @brief Constructs a new MicroCache object.
+ * @param builder The builder whose responses are cached.
+ * @param options The TTL, stale window and the request headers that vary the key.
+ */
+MicroCache::MicroCache(std::shared_ptr<const ResponseBuilder> builder, Options options)
+    : builder(std::move(builder)), options(std::move(options)) {}
+
+// Overrides //
+
+/**
+ * @brief Answers from the cache, waits for a build of the same key, or builds the response.
+ * @param request The request.
+ * @return The response, marked with `X-Cache` (`HIT`, `STALE` or `MISS`) and `Age`, or an error status.
+ */
+ResponseResult MicroCache::buildResponse(const HttpRequest& request) const {
+    std::optional<std::string> key = makeKey(request);
+    if(!key) return builder->buildResponse(request);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+    auto it = slots.find(*key);
+    if(it == slots.end()) {
+        if(slots.size() >= MAX_ENTRIES) evict(now);
+        it = slots.emplace(*key, Slot{}).first;
+    }
+    Slot& slot = it->second;
+
+    if(slot.snapshot) {
+        auto age = now - slot.snapshot->storedAt;
+        if(age < options.ttl) {
+            std::shared_ptr<const Snapshot> snapshot = slot.snapshot;
+            lock.unlock();
+            Metrics::getInstance().increment(Metrics::Counter::MICRO_CACHE_HITS);
+            return materialize(request, snapshot, "HIT");
+        }
+        if(age < options.ttl + options.staleWhileRevalidate && slot.flight) {
+            std::shared_ptr<const Snapshot> snapshot = slot.snapshot; // Someone else is refreshing it
+            lock.unlock();
+            Metrics::getInstance().increment(Metrics::Counter::MICRO_CACHE_STALE);
+            return materialize(request, snapshot, "STALE");
+        }
+        if(age >= options.ttl + options.staleWhileRevalidate) slot.snapshot.reset();
+    }
+
+    if(!slot.flight) {
+        // This request builds the response, later ones wait for it or take the stale copy
+        auto flight = std::make_shared<Flight>();
+        slot.flight = flight;
+        lock.unlock();
+        return build(request, *key, std::move(flight));
+    }
+
+    // Coalesce with the build in progress
+    std::shared_ptr<Flight> flight = slot.flight;
+    flightDone.wait(lock, [&] { return flight->done; });
+    Metrics::getInstance().increment(Metrics::Counter::MICRO_CACHE_COALESCED);
+    if(flight->error) return ResponseResult{ *flight->error };
+    // Otherwise look again: the entry is there, or the response was not cacheable and this request builds its own
+    if(auto done = slots.find(*key); done != slots.end() && done->second.snapshot && !done->second.flight) {
+        std::shared_ptr<const Snapshot> snapshot = done->second.snapshot;
+        lock.unlock();
+        return materialize(request, snapshot, "HIT");
+    }
+    lock.unlock();
+    return builder->buildResponse(request);
+}
+
+// Helpers //
+
+/**
+ * @brief Builds the key for a request.
+ * @return The key, or nothing if the request should bypass the cache.
+ */
+std::optional<std::string> MicroCache::makeKey(const HttpRequest& request) const {
+    std::string_view body = request.getBody();
+    if(request.getParts() != nullptr || body.size() > MAX_KEYED_BODY) return std::nullopt;
+
+    std::string key;
+    key.reserve(request.getURI().size() + body.size() + 64);
+    key.append(request.getMethod()).push_back('\0');
+    key.append(request.getURI()).push_back('\0');
+    for(const std::string& name : options.varyHeaders) {
+        key.append(request.getHeader(name).value_or("")).push_back('\0');
+    }
+    if(!body.empty()) {
+        key.append(request.getHeader("Content-Type").value_or("")).push_back('\0');
+        key.append(body);
+    }
+    return key;
+}
+
+/**
+ * @brief Builds the response for a key, stores it, and wakes the requests waiting for it.
+ * @param request The request.
+ * @param key The request's key.
+ * @param flight The flight registered for the key.
+ * @return The response built.
+ */
+ResponseResult MicroCache::build(const HttpRequest& request, const std::string& key, std::shared_ptr<Flight> flight) const {
+    Metrics::getInstance().increment(Metrics::Counter::MICRO_CACHE_MISSES);
+    ResponseResult result{ http::status::Code::INTERNAL_SERVER_ERROR };
+    std::shared_ptr<const Snapshot> snapshot;
+    try {
+        result = builder->buildResponse(request);
+        if(result.isSuccess()) snapshot = takeSnapshot(result.getResponse());
+    }
+    catch(...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        flight->done = true;
+        flight->error = http::status::Code::INTERNAL_SERVER_ERROR;
+        if(auto it = slots.find(key); it != slots.end()) {
+            it->second.flight.reset();
+            if(!it->second.snapshot) slots.erase(it);
+        }
+        flightDone.notify_all();
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        flight->done = true;
+        if(!result.isSuccess()) flight->error = result.getError();
+        if(auto it = slots.find(key); it != slots.end()) {
+            it->second.flight.reset();
+            if(snapshot) it->second.snapshot = snapshot; // A failed refresh keeps the stale copy until it expires
+            if(!it->second.snapshot) slots.erase(it);
+        }
+    }
+    flightDone.notify_all();
+
+    if(result.isSuccess()) {
+        std::get<HttpResponse>(result.result).setHeader("X-Cache", "MISS");
+    }
+    return result;
+}
+
+/**
+ * @brief Copies a response for the cache.
+ * @return The copy, or nothing if the response must not be shared.
+ */
+std::shared_ptr<const MicroCache::Snapshot> MicroCache::takeSnapshot(const HttpResponse& response) {
+    using n_utils::str_manip::hasToken;
+
+    if(response.getIsStatic() || response.getBody().size() > MAX_BODY_SIZE) return nullptr;
+    if(response.getHeader("Set-Cookie")) return nullptr;
+    std::string_view cacheControl = response.getHeader("Cache-Control").value_or("");
+    if(hasToken(cacheControl, "no-store") || hasToken(cacheControl, "private") || hasToken(cacheControl, "no-cache")) return nullptr;
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->status = response.getStatus();
+    for(const auto& [name, value] : response.getAllHeaders()) {
+        if(name == "date" || name == "connection") continue; // Written per request by the handler
+        snapshot->headers.emplace_back(name, value);
+    }
+    snapshot->contentLength = response.getContentLength();
+    snapshot->body.assign(response.getBody());
+    snapshot->storedAt = std::chrono::steady_clock::now();
+    return snapshot;
+}
+
+/**
+ * @brief Builds a response from a cached copy, sharing its body.
+ * @param request The request, whose resource backs the response.
+ * @param snapshot The cached copy.
+ * @param outcome The `X-Cache` value.
+ * @return The response.
+ */
+ResponseResult MicroCache::materialize(const HttpRequest& request, const std::shared_ptr<const Snapshot>& snapshot,
+                                       std::string_view outcome) {
+    auto age = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - snapshot->storedAt);
+
+    HttpResponse response(request.getResource());
+    response.setStatus(snapshot->status);
+    for(const auto& [name, value] : snapshot->headers) response.setHeader(name, value);
+    if(snapshot->contentLength) response.setContentLength(*snapshot->contentLength);
+    response.setHeader("Age", std::to_string(age.count()));
+    response.setHeader("X-Cache", outcome);
+    response.setBody(MessageBody(snapshot, snapshot->body));
+    return ResponseResult{ std::move(response) };
+}
+
+/**
+ * @brief Makes room for a new key, called with the mutex held.
+ * @details Expired entries go first; if none have expired, the oldest entry does. Keys with a
+ * build in progress are never evicted.
+ * @param now The current time.
+ */
+void MicroCache::evict(std::chrono::steady_clock::time_point now) const {
+    auto oldest = slots.end();
+    for(auto it = slots.begin(); it != slots.end();) {
+        const Slot& slot = it->second;
+        if(slot.flight) {
+            ++it;
+            continue;
+        }
+        if(!slot.snapshot || now - slot.snapshot->storedAt >= options.ttl + options.staleWhileRevalidate) {
+            it = slots.erase(it);
+            continue;
+        }
+        if(oldest == slots.end() || slot.snapshot->storedAt < oldest->second.snapshot->storedAt) oldest = it;
+        ++it;
+    }
+    if(slots.size() >= MAX_ENTRIES && oldest != slots.end()) slots.erase(oldest);
+}
@@ -0,0 +1,356 @@
+/**
+ * @file multipart_parser.cpp
+ * @brief This file contains the definition of the MultipartParser class.
+ * @details This class parses a `multipart/form-data` body incrementally as it is received,
+ * keeping small fields in memory and streaming large parts to temporary files.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "logger.hpp"
+#include "multipart_parser.hpp"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace {
+    /**
+     * @brief Removes leading and trailing spaces and tabs.
+     */
+    std::string_view trim(std::string_view str) noexcept {
+        size_t start = str.find_first_not_of(" \t");
+        if(start == std::string_view::npos) return {};
+        size_t end = str.find_last_not_of(" \t");
+        return str.substr(start, end - start + 1);
+    }
+
+    /**
+     * @brief Compares two strings ignoring ASCII case.
+     */
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) noexcept {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            return (x | 0x20) == (y | 0x20);
+        });
+    }
+
+    /**
+     * @brief Finds a `key=value` parameter in a header value such as `form-data; name="a"`.
+     * @details Quoted values may contain ';'. Backslash escapes are not processed, browsers
+     * percent-encode quotes in field and file names instead.
+     * @param header The header value, starting after the media type or disposition type.
+     * @param key The parameter name, matched case-insensitively.
+     * @return The unquoted value, or `std::nullopt` if the parameter is absent.
+     */
+    std::optional<std::string_view> findParameter(std::string_view header, std::string_view key) {
+        while(!header.empty()) {
+            size_t semicolon = header.find(';');
+            if(semicolon == std::string_view::npos) return std::nullopt;
+            header.remove_prefix(semicolon + 1);
+
+            std::string_view param = trim(header);
+            size_t equals = param.find('=');
+            if(equals == std::string_view::npos) continue;
+            std::string_view name = trim(param.substr(0, equals));
+            std::string_view value = trim(param.substr(equals + 1));
+
+            // A quoted value ends at its closing quote, wherever the next ';' is
+            if(!value.empty() && value[0] == '"') {
+                size_t close = value.find('"', 1);
+                if(close == std::string_view::npos) return std::nullopt;
+                if(equalsIgnoreCase(name, key)) return value.substr(1, close - 1);
+                header = value.substr(close + 1);
+                continue;
+            }
+            value = value.substr(0, value.find(';'));
+            if(equalsIgnoreCase(name, key)) return trim(value);
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Writes all of `data` to a file descriptor.
+     * @return `true` on success.
+     */
+    bool writeAll(int fd, std::string_view data) noexcept {
+        while(!data.empty()) {
+            ssize_t written = ::write(fd, data.data(), data.size());
+            if(written < 0) {
+                if(errno == EINTR) continue;
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(written));
+        }
+        return true;
+    }
+}
+
+// Part //
+
+MultipartParser::Part::Part(Part&& other) noexcept
+    : name(std::move(other.name)),
+      filename(std::move(other.filename)),
+      contentType(std::move(other.contentType)),
+      filenamePresent(other.filenamePresent),
+      data(std::move(other.data)),
+      fd(std::exchange(other.fd, -1)),
+      size(other.size) {}
+
+MultipartParser::Part& MultipartParser::Part::operator=(Part&& other) noexcept {
+    if(this != &other) {
+        if(fd >= 0) ::close(fd);
+        name = std::move(other.name);
+        filename = std::move(other.filename);
+        contentType = std::move(other.contentType);
+        filenamePresent = other.filenamePresent;
+        data = std::move(other.data);
+        fd = std::exchange(other.fd, -1);
+        size = other.size;
+    }
+    return *this;
+}
+
+MultipartParser::Part::~Part() {
+    if(fd >= 0) ::close(fd);
+}
+
+// Constructors //
+
+/**
+ * @brief Constructs a new MultipartParser object with the default limits.
+ * @param boundary The boundary from the request's Content-Type header.
+ */
+MultipartParser::MultipartParser(std::string_view boundary) : MultipartParser(boundary, Limits()) {}
+
+/**
+ * @brief Constructs a new MultipartParser object.
+ * @param boundary The boundary from the request's Content-Type header.
+ * @param limits The memory limits for this body.
+ */
+MultipartParser::MultipartParser(std::string_view boundary, Limits limits)
+    : delimiter("\r\n--" + std::string(boundary)),
+      searcher(delimiter.data(), delimiter.data() + delimiter.size()),
+      limits(limits),
+      pending("\r\n") {} // The first delimiter has no leading CRLF, supply one so every delimiter looks the same
+
+// Functions //
+
+/**
+ * @brief Extracts the boundary parameter from a `multipart/form-data` Content-Type.
+ * @param contentType The Content-Type header value.
+ * @return The boundary, or `std::nullopt` if this is not a valid multipart/form-data type.
+ */
+std::optional<std::string_view> MultipartParser::boundaryFromContentType(std::string_view contentType) {
+    size_t semicolon = contentType.find(';');
+    if(!equalsIgnoreCase(trim(contentType.substr(0, semicolon)), "multipart/form-data")) return std::nullopt;
+    if(semicolon == std::string_view::npos) return std::nullopt;
+
+    auto boundary = findParameter(contentType.substr(semicolon), "boundary");
+    if(!boundary || boundary->empty() || boundary->size() > 70) return std::nullopt; // RFC 2046 limit
+    return boundary;
+}
+
+/**
+ * @brief Parses the next chunk of the body.
+ * @param chunk The next bytes of the body.
+ * @return `false` if the body is malformed, exceeds a limit or a part could not be spilled.
+ */
+bool MultipartParser::feed(std::string_view chunk) {
+    if(state == State::FAILED) return false;
+
+    // Parse straight from the chunk when nothing was carried over
+    if(pending.empty()) {
+        size_t consumed = process(chunk);
+        pending.assign(chunk.substr(consumed));
+    }
+    else {
+        pending.append(chunk);
+        size_t consumed = process(pending);
+        pending.erase(0, consumed);
+    }
+    return state != State::FAILED;
+}
+
+// Helpers //
+
+/**
+ * @brief Consumes as much of `data` as can be parsed without more input.
+ * @param data The unparsed bytes.
+ * @return The number of bytes consumed.
+ */
+size_t MultipartParser::process(std::string_view data) {
+    size_t consumed = 0;
+    while(true) {
+        std::string_view rest = data.substr(consumed);
+        switch(state) {
+            case State::PREAMBLE: {
+                size_t pos = find(rest);
+                if(pos == std::string_view::npos) {
+                    // Keep a tail that could be the start of the delimiter
+                    return consumed + (rest.size() > delimiter.size() ? rest.size() - delimiter.size() + 1 : 0);
+                }
+                consumed += pos + delimiter.size();
+                state = State::DELIMITER;
+                break;
+            }
+            case State::DELIMITER: {
+                if(rest.size() < 2) return consumed;
+                if(rest[0] == ' ' || rest[0] == '\t') { // Transport padding
+                    consumed += 1;
+                    break;
+                }
+                if(rest.substr(0, 2) == "--") {
+                    state = State::DONE;
+                    break;
+                }
+                if(rest.substr(0, 2) != "\r\n") {
+                    state = State::FAILED;
+                    return consumed;
+                }
+                consumed += 2;
+                state = State::HEADERS;
+                break;
+            }
+            case State::HEADERS: {
+                // A part may have no headers at all
+                size_t end = (rest.substr(0, 2) == "\r\n") ? 0 : rest.find("\r\n\r\n");
+                if(end == std::string_view::npos) {
+                    if(rest.size() > limits.maxHeaderSize) state = State::FAILED;
+                    return consumed;
+                }
+                if(end > limits.maxHeaderSize || parts.size() >= limits.maxParts ||
+                   !parsePartHeaders(rest.substr(0, end))) {
+                    state = State::FAILED;
+                    return consumed;
+                }
+                consumed += (end == 0) ? 2 : end + 4;
+                state = State::BODY;
+                break;
+            }
+            case State::BODY: {
+                size_t pos = find(rest);
+                size_t safe = (pos != std::string_view::npos) ? pos
+                    : (rest.size() > delimiter.size() ? rest.size() - delimiter.size() + 1 : 0);
+                if(!appendData(rest.substr(0, safe))) {
+                    state = State::FAILED;
+                    return consumed;
+                }
+                consumed += safe;
+                if(pos == std::string_view::npos) return consumed;
+                consumed += delimiter.size();
+                state = State::DELIMITER;
+                break;
+            }
+            case State::DONE:
+                return data.size(); // Ignore the epilogue
+            case State::FAILED:
+                return consumed;
+        }
+    }
+}
+
+/**
+ * @brief Finds the next delimiter.
+ * @param data The bytes to search.
+ * @return The offset of the delimiter, or `npos`.
+ */
+size_t MultipartParser::find(std::string_view data) const {
+    const char* begin = data.data();
+    const char* end = begin + data.size();
+    const char* match = searcher(begin, end).first;
+    return (match == end) ? std::string_view::npos : static_cast<size_t>(match - begin);
+}
+
+/**
+ * @brief Starts a new part from its header block.
+ * @param block The header lines, without the terminating blank line.
+ * @return `false` if the part is not a form-data part.
+ */
+bool MultipartParser::parsePartHeaders(std::string_view block) {
+    Part part;
+    bool hasDisposition = false;
+
+    while(!block.empty()) {
+        size_t end = block.find("\r\n");
+        std::string_view line = block.substr(0, end);
+        block = (end == std::string_view::npos) ? std::string_view() : block.substr(end + 2);
+
+        size_t colon = line.find(':');
+        if(colon == std::string_view::npos) return false;
+        std::string_view key = trim(line.substr(0, colon));
+        std::string_view value = trim(line.substr(colon + 1));
+
+        if(equalsIgnoreCase(key, "Content-Disposition")) {
+            if(!equalsIgnoreCase(trim(value.substr(0, value.find(';'))), "form-data")) return false;
+            hasDisposition = true;
+            if(auto name = findParameter(value, "name")) part.name = *name;
+            if(auto filename = findParameter(value, "filename")) {
+                part.filename = *filename;
+                part.filenamePresent = true;
+            }
+        }
+        else if(equalsIgnoreCase(key, "Content-Type")) {
+            part.contentType = value;
+        }
+    }
+
+    if(!hasDisposition) return false;
+    parts.push_back(std::move(part));
+    return true;
+}
+
+/**
+ * @brief Appends content to the current part, spilling it to disk once it grows too large.
+ * @param data The content bytes.
+ * @return `false` if writing the temporary file failed.
+ */
+bool MultipartParser::appendData(std::string_view data) {
+    if(data.empty()) return true;
+    Part& part = parts.back();
+    part.size += data.size();
+
+    if(!part.isSpilled() &&
+       (part.data.size() + data.size() > limits.spillThreshold || memoryUsed + data.size() > limits.memoryLimit)) {
+        if(!spill(part)) return false;
+    }
+    if(part.isSpilled()) return writeAll(part.fd, data);
+
+    part.data.append(data);
+    memoryUsed += data.size();
+    return true;
+}
+
+/**
+ * @brief Moves a part's content into an unlinked temporary file.
+ * @param part The part to spill.
+ * @return `false` if the file could not be created or written.
+ */
+bool MultipartParser::spill(Part& part) {
+    const char* dir = std::getenv("TMPDIR");
+    std::string path = std::string((dir && *dir) ? dir : "/tmp") + "/upload-XXXXXX";
+    int fd = ::mkostemp(path.data(), O_CLOEXEC);
+    if(fd < 0) {
+        Logger::getInstance().log("Failed to create upload file: " + std::string(std::strerror(errno)), Logger::LogLevel::ERROR);
+        return false;
+    }
+    ::unlink(path.c_str()); // The file lives until the part closes it
+
+    part.fd = fd;
+    if(!writeAll(fd, part.data)) {
+        Logger::getInstance().log("Failed to write upload file: " + std::string(std::strerror(errno)), Logger::LogLevel::ERROR);
+        return false;
+    }
+    memoryUsed -= part.data.size();
+    std::string().swap(part.data);
+    Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] { return "Spilled upload part '" + part.name + "' to disk."; });
+    return true;
+}
@@ -10,20 +10,23 @@
  */
 
 #include "file_resolver.hpp"
-#include "http_encoding.hpp"
+#include "form_parser.hpp"
 #include "http_mime.hpp"
 #include "http_request.hpp"
 #include "http_response.hpp"
 #include "http_status.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
+#include "multipart_parser.hpp"
+#include "request_timer.hpp"
 #include "response_builder.hpp"
+#include "response_cache.hpp"
 #include "response_composer.hpp"
 
 #include <sys/stat.h>
 
 #include <cassert>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <utility>
 #include <variant>
@@ -35,46 +38,70 @@ using namespace http;
  * @brief Constructs a new GetResponseBuilder.
  * @param resolver The file resolver.
  * @param composer The response composer.
+ * @param responseCache The serialized response cache.
  */
 GetResponseBuilder::GetResponseBuilder(
     std::shared_ptr<FileResolver> resolver, 
-    std::shared_ptr<ResponseComposer> composer
-) : resolver(resolver), composer(composer) {
+    std::shared_ptr<ResponseComposer> composer,
+    std::shared_ptr<ResponseCache> responseCache
+) : resolver(resolver), composer(composer), responseCache(responseCache) {
     assert(this->resolver != nullptr);
     assert(this->composer != nullptr);
+    assert(this->responseCache != nullptr);
 }
 
 /**
- * @brief Builds a response to a GET request.
+ * @brief Resolves the file a GET or HEAD request refers to, using only its metadata.
  * @param request The HTTP request.
- * @return The response result.
+ * @return The resolved path, `stat` result and MIME type, or the error status.
  */
-ResponseResult GetResponseBuilder::buildResponse(const HttpRequest& request) {
-    std::string uri = std::string(request.getURI());
+std::variant<GetResponseBuilder::ResolvedFile, http::status::Code> GetResponseBuilder::resolveFile(const HttpRequest& request) const {
+    // Decode the path: drop the query and fragment, then percent-decode
+    ResolvedFile file{ std::pmr::string(request.getResource()), std::string(), {}, http::mime::Media::INVALID };
+    ResponseCache::appendRequestPath(request.getURI(), file.requestPath);
+    if(file.requestPath.find('\0') != std::pmr::string::npos) {
+        return http::status::Code::BAD_REQUEST; // "%00" would truncate the path
+    }
 
     // Sanitize the path
-    auto resolvedPath = resolver->sanitizePath(uri);
+    auto resolvedPath = resolver->sanitizePath(file.requestPath);
+    RequestTimer::markCurrent(RequestTimer::Phase::RESOLVED);
     if(std::holds_alternative<http::status::Code>(resolvedPath)) {
-        return ResponseResult{ std::get<http::status::Code>(resolvedPath) };
+        return std::get<http::status::Code>(resolvedPath);
     }
 
     // Get resolved path
-    std::string validPath = std::get<std::string>(resolvedPath);
+    file.path = std::move(std::get<std::string>(resolvedPath));
 
     // Verify the file exists and is a regular file using POSIX stat.
-    struct stat st;
-    if(stat(validPath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
-        return ResponseResult{ http::status::Code::NOT_FOUND };
+    if(stat(file.path.c_str(), &file.st) != 0 || !S_ISREG(file.st.st_mode)) {
+        return http::status::Code::NOT_FOUND;
     }
 
     // Determine MIME type by extracting extension from the path.
-    size_t dotPos = validPath.find_last_of('.');
-    std::string extension = (dotPos != std::string::npos) ? validPath.substr(dotPos) : "";
-    auto mime = http::mime::fromExtension(extension);
-    if(mime == http::mime::Media::INVALID) {
-        return ResponseResult{ http::status::Code::UNSUPPORTED_MEDIA_TYPE };
+    size_t dotPos = file.path.find_last_of('.');
+    std::string_view extension = (dotPos != std::string::npos) ? std::string_view(file.path).substr(dotPos) : "";
+    file.mime = http::mime::fromExtension(extension);
+    if(file.mime == http::mime::Media::INVALID) {
+        return http::status::Code::UNSUPPORTED_MEDIA_TYPE;
     }
-    std::string mimeType = http::mime::toString(mime);
+    return file;
+}
+
+/**
+ * @brief Builds a response to a GET request.
+ * @param request The HTTP request.
+ * @return The response result.
+ */
+ResponseResult GetResponseBuilder::buildResponse(const HttpRequest& request) const {
+    auto resolved = resolveFile(request);
+    if(std::holds_alternative<http::status::Code>(resolved)) {
+        return ResponseResult{ std::get<http::status::Code>(resolved) };
+    }
+    const ResolvedFile& file = std::get<ResolvedFile>(resolved);
+    const std::string& validPath = file.path;
+    const struct stat& st = file.st;
+    auto mime = file.mime;
 
     // Check if the file is too large (using stat for file size).
     bool isStatic = false;
@@ -82,33 +109,68 @@ ResponseResult GetResponseBuilder::buildResponse(const HttpRequest& request) {
     if(fileSize > MAX_FILE_SIZE) isStatic = true;
 
     // Build the response.
-    HttpResponse response;
+    HttpResponse response(request.getResource());
     response.setStatus(http::status::Code::OK)
-            .setHeader("Content-Type", mimeType);
+            .setHeader("Content-Type", http::mime::toString(mime));
             
 
     if(isStatic) {
         // For static files, delegate reading; no in-memory body.
-        response.setHeader("Content-Length", std::to_string(fileSize))
-                .setHeader("File-Path", validPath);
-        response.setBody("");
+        response.setContentLength(fileSize)
+                .setFilePath(validPath);
         response.setIsStatic(true);
     }
+    else if(auto entry = responseCache->reuse(file.requestPath, validPath, st)) {
+        // Cached already, e.g. for HTTP/2 which never takes the serialized fast path, share its body
+        response.setContentLength(entry->body().size());
+        response.setBody(MessageBody(entry, entry->body()));
+        response.setIsStatic(false);
+    }
     else {
         auto fileContent = resolver->readFile(validPath);
         if(std::holds_alternative<http::status::Code>(fileContent)) {
             return ResponseResult{ std::get<http::status::Code>(fileContent) };
         }
-        std::string contentStr = std::get<std::string>(fileContent);
-        response.setHeader("Content-Length", std::to_string(contentStr.size()));
+        std::string& contentStr = std::get<std::string>(fileContent);
+        response.setContentLength(contentStr.size());
         response.setBody(std::move(contentStr));
         response.setIsStatic(false);
+
+        // Keep the serialized response, `st` was taken before the read so a concurrent write only causes a miss
+        if(auto entry = responseCache->store(file.requestPath, validPath, st, response, *composer)) {
+            response.setBody(MessageBody(entry, entry->body())); // Share the cached bytes instead of a second copy
+        }
     }
 
-    return ResponseResult{ response };
+    return ResponseResult{ std::move(response) };
 }
 #pragma endregion GetResponseBuilder
 
+#pragma region HeadResponseBuilder
+/**
+ * @brief Builds a response to a HEAD request.
+ * @details The headers match what GET would send, including Content-Length, but the file
+ * is only `stat()`ed, never opened.
+ * @param request The HTTP request.
+ * @return The response result.
+ */
+ResponseResult HeadResponseBuilder::buildResponse(const HttpRequest& request) const {
+    auto resolved = resolveFile(request);
+    if(std::holds_alternative<http::status::Code>(resolved)) {
+        return ResponseResult{ std::get<http::status::Code>(resolved) };
+    }
+    const ResolvedFile& file = std::get<ResolvedFile>(resolved);
+
+    HttpResponse response(request.getResource());
+    response.setStatus(http::status::Code::OK)
+            .setContentLength(static_cast<size_t>(file.st.st_size))
+            .setHeader("Content-Type", http::mime::toString(file.mime));
+    response.setIsStatic(false); // No body and no file to send
+
+    return ResponseResult{ std::move(response) };
+}
+#pragma endregion HeadResponseBuilder
+
 #pragma region PostResponseBuilder
 /**
  * @brief Constructs a new PostResponseBuilder.
@@ -124,50 +186,81 @@ PostResponseBuilder::PostResponseBuilder(std::shared_ptr<ResponseComposer> compo
  * @return The response result.
  * @note This function only supports `url-encoded` form data (right now).
  */
-ResponseResult PostResponseBuilder::buildResponse(const HttpRequest& request) {
-    std::string requestContentType = request.getHeader("Content-Type").value_or("");
+ResponseResult PostResponseBuilder::buildResponse(const HttpRequest& request) const {
+    std::string_view requestContentType = request.getHeader("Content-Type").value_or("");
 
     // Extract the base MIME type (removing any parameters like ;charset=UTF-8)
     size_t semicolon = requestContentType.find(';');
-    if(semicolon != std::string::npos) {
+    if(semicolon != std::string_view::npos) {
         requestContentType = requestContentType.substr(0, semicolon);
     }
 
-    if(requestContentType != http::mime::toString(http::mime::Media::APP_FORM)) {
+    bool isMultipart = (request.getParts() != nullptr);
+    if(!isMultipart && requestContentType != http::mime::toString(http::mime::Media::APP_FORM)) {
         return ResponseResult{ http::status::Code::UNSUPPORTED_MEDIA_TYPE };
     }
-    if(request.getURI() != "/submit") {
-        return ResponseResult{ http::status::Code::NOT_FOUND };
-    }
 
-    std::unordered_map<std::string, std::string> formData;
-    std::istringstream bodyStream(request.getBody());
-    std::string keyValue, key, value;
-
-    // Parse the form data
-    while(std::getline(bodyStream, keyValue, '&')) {
-        size_t pos = keyValue.find('=');
-        // Handle key-value pairs with empty keys, and URL-decode both key and value.
-        key = (pos == std::string::npos) ? "" : http::encoding::decode(keyValue.substr(0, pos));
-        value = (pos == std::string::npos || pos == keyValue.length() - 1) ? "" : http::encoding::decode(keyValue.substr(pos + 1));
-        formData[key] = value;
-    }
+    // Parse the form data straight into the response body, in submission order
+    static constexpr std::string_view HEADER = "Received form data:\r\n";
+    static constexpr std::string_view FOOTER = "POST Successful!";
+    std::string_view formBody = request.getBody();
+    std::string responseBody;
+    responseBody.reserve(HEADER.size() + formBody.size() + FOOTER.size());
+    responseBody.append(HEADER);
 
-    // Build the response
-    std::ostringstream responseBody;
-    responseBody << "Received form data:\r\n";
-    for(const auto& [key, value] : formData) {
-        responseBody << key << ": " << value << "\r\n";
+    auto appendField = [&](std::string_view key, std::string_view value) {
+        responseBody.append(key).append(": ").append(value).append("\r\n");
+    };
+    if(isMultipart) {
+        // Uploaded files and spilled fields are summarized rather than echoed
+        for(const MultipartParser::Part& part : *request.getParts()) {
+            if(!part.hasFilename() && !part.isSpilled()) {
+                appendField(part.getName(), part.getData());
+                continue;
+            }
+            std::string summary = std::string(part.getFilename()) + " (" + std::to_string(part.getSize()) + " bytes";
+            if(!part.getContentType().empty()) summary.append(", ").append(part.getContentType());
+            appendField(part.getName(), summary.append(")"));
+        }
     }
-    responseBody << "POST Successful!";
+    else {
+        FormParser parser(request.getResource());
+        parser.feed(formBody, appendField);
+        parser.finish(appendField);
+    }
+    responseBody.append(FOOTER);
 
-    HttpResponse response;
+    HttpResponse response(request.getResource());
     response.setStatus(http::status::Code::OK)
+            .setContentLength(responseBody.length())
             .setHeader("Content-Type", http::mime::toString(http::mime::Media::TEXT_HTML))
-            .setHeader("Content-Length", std::to_string(responseBody.str().length()))
             .setHeader("Connection", "close")
-            .setBody(responseBody.str());
+            .setBody(std::move(responseBody));
+
+    return ResponseResult{ std::move(response) };
+}
+#pragma endregion PostResponseBuilder
+
+#pragma region MetricsResponseBuilder
+/**
+ * @brief Builds a response containing the current server metrics.
+ * @param request The HTTP request.
+ * @return The response result.
+ */
+ResponseResult MetricsResponseBuilder::buildResponse(const HttpRequest& request) const {
+    http::method::Method method = http::method::fromString(request.getMethod());
+    if(method != http::method::Method::GET && method != http::method::Method::HEAD) {
+        return ResponseResult{ http::status::Code::METHOD_NOT_ALLOWED };
+    }
+
+    std::string body = Metrics::getInstance().render();
+
+    HttpResponse response(request.getResource());
+    response.setStatus(http::status::Code::OK)
+            .setContentLength(body.length())
+            .setHeader("Content-Type", "text/plain; version=0.0.4")
+            .setBody(std::move(body));
 
-    return ResponseResult{ response };
+    return ResponseResult{ std::move(response) };
 }
-#pragma endregion PostResponseBuilder
\ No newline at end of file
+#pragma endregion MetricsResponseBuilder
\ No newline at end of file
@@ -9,32 +9,122 @@
  */
 
 #include "http_method.hpp"
+#include "http_mime.hpp"
 #include "response_builder.hpp"
 #include "response_builder_factory.hpp"
 #include "logger.hpp"
 
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+    /**
+     * @brief Builds the `405 Method Not Allowed` response for a routed path, listing its methods in `Allow`.
+     * @param allowedMethods Bit per method routed on the path. HEAD is allowed wherever GET is.
+     * @param resource The request's memory resource.
+     */
+    ResponseResult methodNotAllowed(uint32_t allowedMethods, std::pmr::memory_resource* resource) {
+        constexpr uint32_t GET_BIT = 1u << static_cast<unsigned>(http::method::Method::GET);
+        if(allowedMethods & GET_BIT) allowedMethods |= 1u << static_cast<unsigned>(http::method::Method::HEAD);
+
+        std::string allow;
+        for(unsigned i = 0; i < static_cast<unsigned>(http::method::Method::INVALID); ++i) {
+            if(!(allowedMethods & (1u << i))) continue;
+            if(!allow.empty()) allow.append(", ");
+            allow.append(http::method::toString(static_cast<http::method::Method>(i)));
+        }
+
+        http::status::Code code = http::status::Code::METHOD_NOT_ALLOWED;
+        std::string body = http::status::getCode(code) + " " + std::string(http::status::toString(code));
+        HttpResponse response(resource);
+        response.setStatus(code)
+                .setHeader("Content-Type", http::mime::toString(http::mime::Media::TEXT_HTML))
+                .setHeader("Allow", allow);
+        response.setContentLength(body.size());
+        response.setBody(std::move(body));
+        return ResponseResult{ std::move(response) };
+    }
+}
+
 ResponseBuilderFactory::~ResponseBuilderFactory() noexcept {
-    builderRegistry.clear();
+    for(auto& builder : builders) builder.reset();
+    routeBuilders.clear();
     Logger::getInstance().log("ResponseBuilderFactory destroyed.", Logger::LogLevel::DEBUG);
 }
 
 /**
- * @brief Registers a delegate builder class for a given HTTP method.
- * @param method The HTTP method to register the delegate for.
- * @param delegate The delegate builder class.
+ * @brief Registers the builder that serves a given HTTP method.
+ * @param method The HTTP method to register the builder for.
+ * @param builder The builder, shared by all threads for the lifetime of the factory.
+ * @throws std::invalid_argument if the method is not a valid HTTP method.
+ */
+void ResponseBuilderFactory::registerBuilder(http::method::Method method, std::unique_ptr<const ResponseBuilder> builder) {
+    size_t index = static_cast<size_t>(method);
+    if(index >= METHOD_COUNT) {
+        throw std::invalid_argument("Cannot register a builder for an invalid HTTP method.");
+    }
+    builders[index] = std::move(builder);
+}
+
+/**
+ * @brief Registers the builder that serves a method on a path pattern.
+ * @param method The HTTP method to register the builder for.
+ * @param pattern The path pattern, see `Router::add`.
+ * @param builder The builder, shared by all threads for the lifetime of the factory. The same
+ * builder may be registered for several methods and patterns.
+ * @throws std::invalid_argument if the method or pattern is invalid or already registered.
+ */
+void ResponseBuilderFactory::registerRoute(http::method::Method method, std::string_view pattern, std::shared_ptr<const ResponseBuilder> builder) {
+    routeBuilders.reserve(routeBuilders.size() + 1); // So the push below cannot fail after the route is added
+    router.add(method, pattern, builder.get());
+    routeBuilders.push_back(std::move(builder));
+}
+
+/**
+ * @brief Matches a request against the registered routes and attaches the captured parameters.
+ * @details HEAD falls back to the GET route of the same path, `buildResponse` drops the body.
+ * @param request The request, matched on its URI without the query string.
+ * @param route Receives the match; `route.pathMatched` means a route owns the path.
+ * @return `true` if a route serves the request.
  */
-void ResponseBuilderFactory::registerBuilder(http::method::Method method, BuilderType delegate) {
-    builderRegistry[method] = std::move(delegate);
+bool ResponseBuilderFactory::matchRoute(HttpRequest& request, Router::Match& route) const noexcept {
+    http::method::Method method = http::method::fromString(request.getMethod());
+    std::string_view path = request.getURI();
+    path = path.substr(0, path.find_first_of("?#"));
+
+    bool routed = router.match(method, path, route);
+    if(!routed && method == http::method::Method::HEAD && route.pathMatched) {
+        routed = router.match(http::method::Method::GET, path, route); // HEAD is GET without the body
+    }
+    if(routed) request.setRouteParams(route.params);
+    return routed;
 }
 
 /**
- * @brief Creates a ResponseBuilder object based on the HTTP method.
- * @returns A unique pointer to a ResponseBuilder or `nullptr` if no builder is found.
+ * @brief Builds the response with the matched route's builder, or the method's builder.
+ * @param request The request.
+ * @param route The result of `matchRoute`.
+ * @return The response, or the status to answer with when no builder serves the request.
  */
-std::unique_ptr<ResponseBuilder> ResponseBuilderFactory::createBuilder(const http::method::Method& method) const {
-    auto it = builderRegistry.find(method);
-    if(it != builderRegistry.end()) {
-        return it->second();
+ResponseResult ResponseBuilderFactory::buildResponse(const HttpRequest& request, const Router::Match& route) const {
+    http::method::Method method = http::method::fromString(request.getMethod());
+    const ResponseBuilder* builder = route.pathMatched ? route.builder : getBuilder(method);
+    if(!builder && !route.pathMatched) {
+        if(router.hasRoutes(method)) return ResponseResult{ http::status::Code::NOT_FOUND };
+        return ResponseResult{ http::status::Code::NOT_IMPLEMENTED }; // The method is not supported
     }
-    return nullptr;
-}
\ No newline at end of file
+
+    // Routed, but not for this method
+    ResponseResult result = builder ? builder->buildResponse(request) : methodNotAllowed(route.allowedMethods, request.getResource());
+    if(method == http::method::Method::HEAD && result.isSuccess()) {
+        // A GET route (or the 405) answered a HEAD request, keep its headers but drop the body
+        HttpResponse& response = std::get<HttpResponse>(result.result);
+        if(!response.getBody().empty() || response.getIsStatic()) {
+            if(!response.getContentLength()) response.setContentLength(response.getBody().size());
+            response.setBody(MessageBody());
+            response.setIsStatic(false);
+        }
+    }
+    return result;
+}
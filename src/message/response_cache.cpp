@@ -0,0 +1,261 @@
+/**
+ * @file response_cache.cpp
+ * @brief This file contains the definition of the ResponseCache class.
+ * @details This class keeps complete serialized responses for small files so that a hit
+ * can be sent straight to the socket without building an `HttpResponse`.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "response_cache.hpp"
+
+#include <sys/stat.h>
+
+#include <mutex>
+#include <string>
+#include <utility>
+
+// Constructors //
+
+/**
+ * @brief Constructs a new ResponseCache object.
+ * @param capacityBytes The maximum number of bytes held by all entries; 0 disables the cache.
+ */
+ResponseCache::ResponseCache(size_t capacityBytes) : capacity(capacityBytes) {}
+
+// Getters //
+
+/**
+ * @brief Gets the number of bytes held by all entries.
+ * @returns The current cache size in bytes.
+ */
+size_t ResponseCache::getSize() const {
+    std::shared_lock lock(mutex);
+    return size;
+}
+
+// Functions //
+
+/**
+ * @brief Looks up the cached response for a request path.
+ * @details Stale entries (the file changed or vanished) are dropped and reported as a miss.
+ * @param requestPath The decoded request path, see `appendRequestPath`.
+ * @param encoding The content encoding variant.
+ * @returns The cached entry, or `nullptr` on a miss.
+ */
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::lookup(std::string_view requestPath, Encoding encoding) {
+    std::shared_ptr<const Entry> entry;
+    {
+        std::shared_lock lock(mutex);
+        const auto& map = aliases[static_cast<size_t>(encoding)];
+        if(auto it = map.find(requestPath); it != map.end()) entry = it->second;
+    }
+
+    if(entry && !isFresh(*entry)) {
+        Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] { return "Response cache entry is stale: " + entry->path; });
+        erase(entry->path, encoding, entry.get());
+        entry.reset();
+    }
+    if(entry) entry->referenced.store(true, std::memory_order_relaxed);
+
+    Metrics::getInstance().increment(entry ? Metrics::Counter::RESPONSE_CACHE_HITS : Metrics::Counter::RESPONSE_CACHE_MISSES);
+    return entry;
+}
+
+/**
+ * @brief Finds the entry of a file that was already resolved, so its body need not be read again.
+ * @details Used by the response builders, which also serve HTTP/2 and request paths without an
+ * alias yet; the path is added as an alias when missing. Not counted as a hit or miss, the
+ * HTTP/1.1 fast path already counted the lookup.
+ * @param requestPath The decoded request path, see `appendRequestPath`.
+ * @param path The resolved file path.
+ * @param fileStat The file status just taken.
+ * @param encoding The content encoding variant.
+ * @returns The entry, or `nullptr` if the file is not cached or changed since.
+ */
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::reuse(
+    std::string_view requestPath,
+    const std::string& path,
+    const struct stat& fileStat,
+    Encoding encoding
+) {
+    if(!isEnabled()) return nullptr;
+    {
+        std::shared_lock lock(mutex);
+        const auto& map = files[static_cast<size_t>(encoding)];
+        auto it = map.find(path);
+        if(it == map.end() || !matches(*it->second.entry, fileStat)) return nullptr;
+        if(aliases[static_cast<size_t>(encoding)].count(requestPath) != 0 || it->second.aliases.size() >= MAX_ALIASES) {
+            it->second.entry->referenced.store(true, std::memory_order_relaxed);
+            return it->second.entry;
+        }
+    }
+
+    std::unique_lock lock(mutex);
+    auto& map = files[static_cast<size_t>(encoding)];
+    auto it = map.find(path);
+    if(it == map.end() || !matches(*it->second.entry, fileStat)) return nullptr;
+    addAlias(it->second, requestPath, encoding);
+    it->second.entry->referenced.store(true, std::memory_order_relaxed);
+    return it->second.entry;
+}
+
+/**
+ * @brief Serializes a successful in-memory response and stores it for its file.
+ * @details If the file is already cached unchanged, the request path is added as an alias of
+ * that entry and it is returned without serializing anything.
+ * @param requestPath The decoded request path, see `appendRequestPath`.
+ * @param path The resolved file path the body was read from.
+ * @param fileStat The file status taken before the body was read.
+ * @param response The response to cache; its body must hold the full file content.
+ * @param composer The composer used to serialize the headers.
+ * @param encoding The content encoding variant.
+ * @returns The stored entry, or `nullptr` if the response was not cached.
+ */
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::store(
+    std::string_view requestPath,
+    const std::string& path,
+    const struct stat& fileStat,
+    const HttpResponse& response,
+    const ResponseComposer& composer,
+    Encoding encoding
+) {
+    if(!isEnabled() || response.getIsStatic()) return nullptr;
+
+    // Another spelling of a cached file only needs an alias
+    {
+        std::unique_lock lock(mutex);
+        auto& map = files[static_cast<size_t>(encoding)];
+        if(auto it = map.find(path); it != map.end() && matches(*it->second.entry, fileStat)) {
+            addAlias(it->second, requestPath, encoding);
+            return it->second.entry;
+        }
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->bytes = composer.composeResponseString(response);
+    entry->bytes.resize(entry->bytes.size() - 2); // Drop the blank line, the per-request headers go there
+    entry->headersLength = entry->bytes.size();
+    entry->bytes.append(response.getBody());
+    entry->path = path;
+    entry->modified = fileStat.st_mtim;
+    entry->size = fileStat.st_size;
+    entry->validatedAt.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+
+    size_t bytes = entry->path.size() + entry->bytes.size() + requestPath.size();
+    if(bytes > capacity) return nullptr;
+
+    std::unique_lock lock(mutex);
+    auto& map = files[static_cast<size_t>(encoding)];
+    if(auto it = map.find(path); it != map.end()) remove(it, encoding);
+    evictFor(bytes);
+
+    Slot slot;
+    slot.entry = entry;
+    slot.queued = queue.emplace(queue.end(), encoding, entry->path);
+    size += entry->path.size() + entry->bytes.size();
+    addAlias(map.emplace(entry->path, std::move(slot)).first->second, requestPath, encoding);
+    return entry;
+}
+
+// Helpers //
+
+/**
+ * @brief Checks whether a cached entry still matches its file, calling `stat()` at most once per interval.
+ * @param entry The cached entry.
+ * @returns `true` if the entry can be served.
+ */
+bool ResponseCache::isFresh(const Entry& entry) const noexcept {
+    int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    int64_t interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(REVALIDATE_INTERVAL).count();
+    if(now - entry.validatedAt.load(std::memory_order_relaxed) < interval) return true;
+
+    struct stat st;
+    if(stat(entry.path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || !matches(entry, st)) return false;
+
+    entry.validatedAt.store(now, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Checks whether a cached entry was read from the file version described by `fileStat`.
+ */
+bool ResponseCache::matches(const Entry& entry, const struct stat& fileStat) noexcept {
+    return fileStat.st_size == entry.size &&
+           fileStat.st_mtim.tv_sec == entry.modified.tv_sec &&
+           fileStat.st_mtim.tv_nsec == entry.modified.tv_nsec;
+}
+
+/**
+ * @brief Makes a request path resolve to a cached file, unless the file already has `MAX_ALIASES`.
+ * @param slot The cached file.
+ * @param requestPath The decoded request path.
+ * @param encoding The content encoding variant.
+ * @note The caller must hold the exclusive lock.
+ */
+void ResponseCache::addAlias(Slot& slot, std::string_view requestPath, Encoding encoding) {
+    auto& map = aliases[static_cast<size_t>(encoding)];
+    if(slot.aliases.size() >= MAX_ALIASES || map.count(requestPath) != 0) return;
+    if(size + requestPath.size() > capacity) return;
+
+    std::string_view key = slot.aliases.emplace_back(requestPath);
+    map.emplace(key, slot.entry);
+    size += key.size();
+}
+
+/**
+ * @brief Removes a file's entry, unless it was already replaced by another thread.
+ * @param path The resolved file path.
+ * @param encoding The content encoding variant.
+ * @param expected The entry that was found to be stale.
+ */
+void ResponseCache::erase(const std::string& path, Encoding encoding, const Entry* expected) {
+    std::unique_lock lock(mutex);
+    auto& map = files[static_cast<size_t>(encoding)];
+    if(auto it = map.find(path); it != map.end() && it->second.entry.get() == expected) {
+        remove(it, encoding);
+    }
+}
+
+/**
+ * @brief Removes a file's entry together with its aliases and its place in the eviction queue.
+ * @param it The file to remove.
+ * @param encoding The content encoding variant.
+ * @note The caller must hold the exclusive lock.
+ */
+void ResponseCache::remove(std::unordered_map<std::string_view, Slot>::iterator it, Encoding encoding) {
+    Slot& slot = it->second;
+    auto& aliasMap = aliases[static_cast<size_t>(encoding)];
+    for(const std::string& alias : slot.aliases) {
+        aliasMap.erase(alias);
+        size -= alias.size();
+    }
+    size -= slot.entry->path.size() + slot.entry->bytes.size();
+    queue.erase(slot.queued);
+    files[static_cast<size_t>(encoding)].erase(it);
+}
+
+/**
+ * @brief Evicts entries until `bytes` more fit within the capacity.
+ * @details The oldest entry goes first, unless it was hit since the clock last passed it; then it
+ * is moved to the back instead.
+ * @param bytes The size of the entry about to be inserted.
+ * @note The caller must hold the exclusive lock.
+ */
+void ResponseCache::evictFor(size_t bytes) {
+    size_t chances = queue.size(); // Hits racing with this call cannot keep it going
+    while(size + bytes > capacity && !queue.empty()) {
+        auto [encoding, path] = queue.front();
+        auto it = files[static_cast<size_t>(encoding)].find(path);
+        if(chances > 0 && it->second.entry->referenced.exchange(false, std::memory_order_relaxed)) {
+            --chances;
+            queue.splice(queue.end(), queue, queue.begin()); // Second chance
+            continue;
+        }
+        remove(it, encoding);
+    }
+}
@@ -15,8 +15,39 @@
 #include "logger.hpp"
 #include "response_composer.hpp"
 
-#include <sstream>
+#include <charconv>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <system_error>
+
+// Constructors //
+
+/**
+ * @brief Constructs a new ResponseComposer object.
+ * @details Serializes every known 4xx and 5xx status into its immutable error response.
+ */
+ResponseComposer::ResponseComposer() {
+    for(http::status::Code code : http::status::ALL_CODES) {
+        int value = static_cast<int>(code);
+        if(value < FIRST_ERROR_CODE || value > LAST_ERROR_CODE) continue;
+
+        // Using the status code as the body
+        std::string body = http::status::getCode(code) + " " + std::string(http::status::toString(code));
+
+        PrebuiltResponse& prebuilt = errorResponses[value - FIRST_ERROR_CODE];
+        prebuilt.bytes.append(http::status::statusLine(code));
+        prebuilt.bytes.append("content-type: ").append(http::mime::toString(http::mime::Media::TEXT_HTML)).append("\r\n");
+        prebuilt.bytes.append("content-length: ").append(std::to_string(body.length())).append("\r\n");
+        if(code == http::status::Code::TOO_MANY_REQUESTS || code == http::status::Code::SERVICE_UNAVAILABLE) {
+            prebuilt.bytes.append("retry-after: 1\r\n"); // Rate limits refill and load shedding eases within about a second
+        }
+        prebuilt.headersLength = prebuilt.bytes.length();
+        prebuilt.bytes.append(body);
+    }
+}
+
+// Functions //
 
 /**
  * @brief Composes an HTTP response string from the given response object.
@@ -24,40 +55,75 @@
  * @returns The full HTTP response string.
  */
 std::string ResponseComposer::composeResponseString(const HttpResponse& response) const {
-    std::ostringstream responseStream;
-    responseStream << response.getStatusLine() << "\r\n";
-
-    for(const auto& [key, value] : response.getAllHeaders()) {
-        responseStream << key << ": " << value << "\r\n";
+    std::string responseString(INITIAL_HEADER_CAPACITY, '\0');
+    size_t length;
+    while((length = serializeHeaders(response, responseString.data(), responseString.size())) == 0) {
+        responseString.resize(responseString.size() * 2);
     }
-
-    responseStream << "\r\n";
-
-    return responseStream.str();
+    responseString.resize(length);
+    return responseString;
 }
 
-
 /**
- * @brief Composes an error message response.
- * @param code The HTTP status code.
- * @returns The error message response object.
+ * @brief Serializes the status line and headers of a response into a caller-provided buffer.
+ * @details The status line comes from a precomputed table and numbers are written with
+ * `std::to_chars`, so this never allocates.
+ * @param response The HTTP response object.
+ * @param buffer The buffer to write into.
+ * @param capacity The size of the buffer.
+ * @returns The number of bytes written, or 0 if the headers do not fit.
  */
-std::string ResponseComposer::composeErrorMessage(HttpResponse& response, http::status::Code code) {
-    // Using the status code as the body
-    std::string body = http::status::getCode(code) + " " + http::status::toString(code);
+size_t ResponseComposer::serializeHeaders(const HttpResponse& response, char* buffer, size_t capacity) const noexcept {
+    char* out = buffer;
+    char* const end = buffer + capacity;
 
-    response.setStatus(code)
-            .setHeader("Content-Type", http::mime::toString(http::mime::Media::TEXT_HTML))
-            .setHeader("Content-Length", std::to_string(body.length()))
-            .setHeader("Connection", "close")
-            .setBody(std::move(body));
+    auto append = [&](std::string_view str) {
+        if(static_cast<size_t>(end - out) < str.size()) return false;
+        std::memcpy(out, str.data(), str.size());
+        out += str.size();
+        return true;
+    };
+    auto appendNumber = [&](auto value) {
+        auto [ptr, ec] = std::to_chars(out, end, value);
+        if(ec != std::errc()) return false;
+        out = ptr;
+        return true;
+    };
+
+    // Status line
+    std::string_view statusLine = http::status::statusLine(response.getStatus());
+    if(response.getVersion() == "HTTP/1.1" && !statusLine.empty()) {
+        if(!append(statusLine)) return 0;
+    }
+    else {
+        // Uncommon version or code, build the line piece by piece
+        if(!append(response.getVersion()) || !append(" ") ||
+           !appendNumber(static_cast<int>(response.getStatus())) || !append(" ") ||
+           !append(http::status::toString(response.getStatus())) || !append("\r\n")) return 0;
+    }
 
-    std::ostringstream responseStream;
+    // Headers
     for(const auto& [key, value] : response.getAllHeaders()) {
-        responseStream << key << ": " << value << "\r\n";
+        if(!append(key) || !append(": ") || !append(value) || !append("\r\n")) return 0;
     }
-    responseStream << "\r\n";
-    responseStream << response.getBody();
+    if(auto contentLength = response.getContentLength()) {
+        if(!append("content-length: ") || !appendNumber(*contentLength) || !append("\r\n")) return 0;
+    }
+
+    if(!append("\r\n")) return 0;
+    return static_cast<size_t>(out - buffer);
+}
 
-    return responseStream.str();
+/**
+ * @brief Gets the prebuilt error response for a status code.
+ * @param code The HTTP status code, expected to be a 4xx or 5xx.
+ * @returns The prebuilt response, or the 500 response if the code has none.
+ */
+const ResponseComposer::PrebuiltResponse& ResponseComposer::getErrorResponse(http::status::Code code) const noexcept {
+    int value = static_cast<int>(code);
+    if(value >= FIRST_ERROR_CODE && value <= LAST_ERROR_CODE) {
+        const PrebuiltResponse& prebuilt = errorResponses[value - FIRST_ERROR_CODE];
+        if(!prebuilt.bytes.empty()) return prebuilt;
+    }
+    return errorResponses[static_cast<int>(http::status::Code::INTERNAL_SERVER_ERROR) - FIRST_ERROR_CODE];
 }
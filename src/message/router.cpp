@@ -0,0 +1,194 @@
+/**
+ * @file router.cpp
+ * @brief This file contains the definition of the Router class.
+ * @details The router maps a method and a path pattern to a ResponseBuilder. Patterns are
+ * compiled into a radix tree so a lookup walks the path once, without allocating.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "router.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+// Constructors //
+
+Router::Router() : root(std::make_unique<Node>()) {}
+
+Router::~Router() = default;
+
+// Functions //
+
+/**
+ * @brief Registers a builder for a method and path pattern.
+ * @details `/submit` matches that path only, `/users/:id` captures one segment as `id`,
+ * and a trailing `*name` segment captures the rest of the path as `name`.
+ * @param method The HTTP method.
+ * @param pattern The path pattern, starting with '/'.
+ * @param builder The builder, which must outlive the router.
+ * @throws std::invalid_argument if the pattern is malformed, conflicts with an existing
+ * parameter name, or is already registered for the method.
+ */
+void Router::add(http::method::Method method, std::string_view pattern, const ResponseBuilder* builder) {
+    size_t methodIndex = static_cast<size_t>(method);
+    if(methodIndex >= METHOD_COUNT || builder == nullptr) {
+        throw std::invalid_argument("Cannot register a route without a valid method and builder.");
+    }
+    if(pattern.empty() || pattern[0] != '/') {
+        throw std::invalid_argument("Route pattern must start with '/': " + std::string(pattern));
+    }
+
+    Node* node = root.get();
+    size_t pos = 0;
+    while(pos < pattern.size()) {
+        // Static text up to the next parameter
+        size_t special = pattern.find_first_of(":*", pos);
+        if(special == std::string_view::npos) special = pattern.size();
+        node = insertStatic(node, pattern.substr(pos, special - pos));
+        pos = special;
+        if(pos == pattern.size()) break;
+
+        if(pattern[pos - 1] != '/') {
+            throw std::invalid_argument("Route parameters must start a path segment: " + std::string(pattern));
+        }
+
+        bool isWildcard = (pattern[pos] == '*');
+        size_t end = isWildcard ? pattern.size() : pattern.find('/', pos);
+        if(end == std::string_view::npos) end = pattern.size();
+        std::string_view name = pattern.substr(pos + 1, end - pos - 1);
+        if(name.empty() || name.find_first_of(":*/") != std::string_view::npos) {
+            throw std::invalid_argument("Invalid route parameter in pattern: " + std::string(pattern));
+        }
+
+        std::unique_ptr<Node>& child = isWildcard ? node->wildcardChild : node->paramChild;
+        if(!child) {
+            child = std::make_unique<Node>();
+            child->paramName = name;
+        }
+        else if(child->paramName != name) {
+            throw std::invalid_argument("Route parameter '" + std::string(name) + "' conflicts with '" +
+                                        child->paramName + "' in pattern: " + std::string(pattern));
+        }
+        node = child.get();
+        pos = end;
+    }
+
+    if(node->handlers[methodIndex] != nullptr) {
+        throw std::invalid_argument("Route is already registered: " + std::string(pattern));
+    }
+    node->handlers[methodIndex] = builder;
+    node->methods |= (1u << methodIndex);
+    methodMask |= (1u << methodIndex);
+}
+
+/**
+ * @brief Finds the builder for a request.
+ * @param method The request method.
+ * @param path The request path, without the query string.
+ * @param result Receives the builder and the captured parameters.
+ * @return `true` if a route serves this method and path.
+ */
+bool Router::match(http::method::Method method, std::string_view path, Match& result) const noexcept {
+    result.builder = nullptr;
+    result.pathMatched = false;
+    result.allowedMethods = 0;
+    result.params.clear();
+
+    size_t methodIndex = static_cast<size_t>(method);
+    const Node* node = find(root.get(), path, 0, result.params);
+    if(node == nullptr) return false;
+
+    result.pathMatched = true;
+    result.allowedMethods = node->methods;
+    result.builder = (methodIndex < METHOD_COUNT) ? node->handlers[methodIndex] : nullptr;
+    return result.builder != nullptr;
+}
+
+/**
+ * @brief Checks whether any route is registered for a method.
+ * @param method The HTTP method.
+ * @return `true` if at least one route serves the method.
+ */
+bool Router::hasRoutes(http::method::Method method) const noexcept {
+    size_t methodIndex = static_cast<size_t>(method);
+    return methodIndex < METHOD_COUNT && (methodMask & (1u << methodIndex)) != 0;
+}
+
+// Helpers //
+
+/**
+ * @brief Inserts static text below a node, splitting existing edges where they diverge.
+ * @param node The node to insert below.
+ * @param text The static text.
+ * @return The node at the end of the text.
+ */
+Router::Node* Router::insertStatic(Node* node, std::string_view text) {
+    while(!text.empty()) {
+        size_t index = node->indices.find(text[0]);
+        if(index == std::string::npos) {
+            auto child = std::make_unique<Node>();
+            child->prefix = text;
+            node->indices.push_back(text[0]);
+            node->children.push_back(std::move(child));
+            return node->children.back().get();
+        }
+
+        std::unique_ptr<Node>& child = node->children[index];
+        size_t common = 0;
+        while(common < child->prefix.size() && common < text.size() && child->prefix[common] == text[common]) ++common;
+
+        // Split the edge so the shared part becomes its own node
+        if(common < child->prefix.size()) {
+            auto middle = std::make_unique<Node>();
+            middle->prefix = child->prefix.substr(0, common);
+            child->prefix.erase(0, common);
+            middle->indices.push_back(child->prefix[0]);
+            middle->children.push_back(std::move(child));
+            child = std::move(middle);
+        }
+
+        node = child.get();
+        text.remove_prefix(common);
+    }
+    return node;
+}
+
+/**
+ * @brief Walks the tree, preferring static edges, then parameters, then prefix routes.
+ * @param node The current node.
+ * @param path The full request path.
+ * @param offset The position in `path` this node starts matching at.
+ * @param params Receives the captured parameters; left as found if nothing matches.
+ * @return The node with handlers that matched, or `nullptr`.
+ */
+const Router::Node* Router::find(const Node* node, std::string_view path, size_t offset, RouteParams& params) noexcept {
+    std::string_view remaining = path.substr(offset);
+    if(remaining.empty() && node->methods != 0) return node;
+
+    if(!remaining.empty()) {
+        size_t index = node->indices.find(remaining[0]);
+        if(index != std::string::npos) {
+            const Node* child = node->children[index].get();
+            if(remaining.substr(0, child->prefix.size()) == child->prefix) {
+                if(const Node* found = find(child, path, offset + child->prefix.size(), params)) return found;
+            }
+        }
+
+        if(node->paramChild) {
+            size_t length = remaining.find('/');
+            if(length == std::string_view::npos) length = remaining.size();
+            if(length > 0 && params.push(node->paramChild->paramName, offset, length)) {
+                if(const Node* found = find(node->paramChild.get(), path, offset + length, params)) return found;
+                params.pop();
+            }
+        }
+    }
+
+    if(node->wildcardChild && params.push(node->wildcardChild->paramName, offset, remaining.size())) {
+        return node->wildcardChild.get();
+    }
+    return nullptr;
+}
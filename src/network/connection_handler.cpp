@@ -9,29 +9,43 @@
  * COP4635 Sys & Net II - Project 1
  */
 
+#include "clock.hpp"
+#include "config.hpp"
 #include "connection_handler.hpp"
+#include "http2_session.hpp"
 #include "http_request.hpp"
 #include "http_response.hpp"
 #include "http_method.hpp"
 #include "http_server.hpp"
 #include "http_status.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
+#include "multipart_parser.hpp"
 #include "response_builder_factory.hpp"
+#include "rate_limiter.hpp"
 #include "response_composer.hpp"
+#include "reverse_proxy.hpp"
+#include "sse_broadcaster.hpp"
+#include "websocket.hpp"
 
 #include <fcntl.h>
 #include <poll.h> // Using ppoll instead of select (blocking) or epoll since the `ThreadPool` uses epoll
 #include <sys/sendfile.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <iostream>
+#include <memory_resource>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <system_error>
 
 // Constructors //
@@ -41,12 +55,26 @@
  * @param client_socket The client socket to handle.
  * @param factory The response builder factory.
  * @param composer The response composer.
+ * @param responseCache The serialized response cache.
+ * @param eventLoop The event loop that upgraded WebSocket connections are handed to.
+ * @param broadcaster The Server-Sent Events broadcaster that subscriptions are handed to.
+ * @param rateLimiter The per-client request rate limiter.
+ * @param connectionTimer The accept/queue timestamps, attributed to the first request.
  */
 ConnectionHandler::ConnectionHandler(
     std::unique_ptr<Socket> client_socket,
     std::shared_ptr<ResponseBuilderFactory> factory,
-    std::shared_ptr<ResponseComposer> composer
-) : client_socket(std::move(client_socket)), factory(factory), composer(composer) {}
+    std::shared_ptr<ResponseComposer> composer,
+    std::shared_ptr<ResponseCache> responseCache,
+    std::shared_ptr<EventLoop> eventLoop,
+    std::shared_ptr<SseBroadcaster> broadcaster,
+    std::shared_ptr<RateLimiter> rateLimiter,
+    RequestTimer connectionTimer
+) : client_socket(std::move(client_socket)), factory(factory), composer(composer), responseCache(responseCache), eventLoop(eventLoop),
+    broadcaster(broadcaster), rateLimiter(rateLimiter),
+    timer(connectionTimer), arena(arenaBuffer, sizeof(arenaBuffer)) {
+    Metrics::getInstance().adjust(Metrics::Gauge::ACTIVE_CONNECTIONS, 1);
+}
 
 /**
  * @brief Destroys the ConnectionHandler object.
@@ -58,6 +86,7 @@ ConnectionHandler::~ConnectionHandler() {
         shutdown(client_socket->get(), SHUT_RDWR);
         client_socket.reset();
     }
+    Metrics::getInstance().adjust(Metrics::Gauge::ACTIVE_CONNECTIONS, -1);
 }
 
 // Functions //
@@ -68,11 +97,20 @@ ConnectionHandler::~ConnectionHandler() {
 void ConnectionHandler::processRequests() {
     int requestCount = 0;
     do {
-        if(!waitForData()) break; // No data received within timeout -> close connection
+        if(pipelined.empty() && !waitForData()) break; // No data received within timeout -> close connection
+
+        // A client with prior knowledge opens with the HTTP/2 preface instead of a request
+        if(requestCount == 0 && isHttp2Preface()) {
+            Http2Session session(*client_socket, factory, composer);
+            session.run();
+            break;
+        }
 
         // Handle the request
-        bool keepAlive = handleRequest();
+        bool keepAlive = handleRequest(requestCount > 0);
+        arena.release(); // Everything the request allocated is gone, reuse the arena
         requestCount++; // Increment request count
+        timer = RequestTimer{}; // Later requests are timed from their first byte
 
         // Check if it reached the max number of requests
         if(requestCount >= MAX_KEEP_ALIVE_REQUESTS) {
@@ -84,6 +122,40 @@ void ConnectionHandler::processRequests() {
     } while(true);
 }
 
+/**
+ * @brief Answers a connection that will not be served with a prebuilt error and no request read.
+ * @details The response is written once without blocking; whatever the socket does not take is
+ * dropped, so the caller never waits on the client. The caller closes the socket.
+ * @param socket The client socket.
+ * @param composer The composer holding the prebuilt error responses.
+ * @param code The status to answer with, such as `429` or `503`.
+ */
+void ConnectionHandler::reject(const Socket& socket, const ResponseComposer& composer, http::status::Code code) noexcept {
+    const ResponseComposer::PrebuiltResponse& prebuilt = composer.getErrorResponse(code);
+    char dynamicHeaders[128];
+    char* out = dynamicHeaders;
+    auto append = [&](std::string_view str) {
+        std::memcpy(out, str.data(), str.size());
+        out += str.size();
+    };
+    append("date: ");
+    append(Clock::getInstance().getHttpDate());
+    append("\r\nconnection: close\r\n\r\n");
+
+    struct iovec iov[3];
+    iov[0].iov_base = const_cast<char*>(prebuilt.headers().data());
+    iov[0].iov_len = prebuilt.headers().size();
+    iov[1].iov_base = dynamicHeaders;
+    iov[1].iov_len = static_cast<size_t>(out - dynamicHeaders);
+    iov[2].iov_base = const_cast<char*>(prebuilt.body().data());
+    iov[2].iov_len = prebuilt.body().size();
+
+    struct msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 3;
+    (void)::sendmsg(socket.get(), &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
 /**
  * @brief Waits for incoming data on the client socket.
  * @return `true` if data is available, `false` if a timeout occurred.
@@ -101,8 +173,9 @@ bool ConnectionHandler::waitForData() {
 
         // Check for proactive closure (no data received within timeout)
         if(totalElapsedMs >= proactiveTimeoutMs) {
-            Logger::getInstance().log("Proactive closure: no data within " +
-                std::to_string(proactiveTimeoutMs) + "ms.", Logger::LogLevel::INFO);
+            Logger::getInstance().log<Logger::LogLevel::INFO>([&] {
+                return "Proactive closure: no data within " + std::to_string(proactiveTimeoutMs) + "ms.";
+            });
             return false;
         }
     }
@@ -113,6 +186,26 @@ bool ConnectionHandler::waitForData() {
     return false;
 }
 
+/**
+ * @brief Checks whether the connection starts with the HTTP/2 connection preface.
+ * @details Peeks at the first bytes without consuming them. "PRI" is not a method this server
+ * accepts, so three matching bytes are enough to tell the preface from an HTTP/1.1 request.
+ * @return `true` if the client speaks HTTP/2 with prior knowledge.
+ */
+bool ConnectionHandler::isHttp2Preface() {
+    const size_t prefixLength = 3;
+    char buffer[Http2Session::PREFACE.size()];
+    for(int attempt = 0; attempt < 10; ++attempt) {
+        ssize_t bytesRead = client_socket->recv(buffer, sizeof(buffer), MSG_PEEK);
+        if(bytesRead <= 0) return false; // Closed or nothing yet, let the HTTP/1.1 path report it
+        std::string_view received(buffer, static_cast<size_t>(bytesRead));
+        if(!Http2Session::isPrefacePrefix(received)) return false;
+        if(received.size() >= prefixLength) return true;
+        waitForSocketEvent(client_socket->get(), POLLIN, 10); // Only "P" or "PR" so far
+    }
+    return false;
+}
+
 /**
  * @brief Waits for a socket event to occur.
  * @param fd The file descriptor to wait on.
@@ -140,53 +233,130 @@ bool ConnectionHandler::waitForSocketEvent(int fd, short event_mask, int timeout
 
 /**
  * @brief Handles an incoming request from the client.
+ * @param isReused `true` if an earlier request was already served on this connection.
  * @return `true` if the connection should be kept alive, `false` otherwise.
  */
-bool ConnectionHandler::handleRequest() {
+bool ConnectionHandler::handleRequest(bool isReused) {
+    RequestTimer::Scope timerScope(timer);
     try {
-        // Parse the incoming request
-        HttpRequest request = parseRequest();
-        if(Logger::getInstance().getLogLevel() == Logger::LogLevel::DEBUG) request.display();
+        // Parse the head first, proxied bodies are streamed instead of read here
+        std::pmr::string requestData(&arena);
+        size_t bodyStart = 0;
+        HttpRequest request = parseHead(requestData, bodyStart);
+        auto start = std::chrono::steady_clock::now();
+
+        // Keep bytes past this request for the next one, pipelined requests arrive in the same reads
+        size_t requestEnd = bodyStart + request.getContentLength().value_or(0);
+        if(requestData.size() > requestEnd && !request.getHeader("Transfer-Encoding")) {
+            pipelined.assign(requestData, requestEnd);
+            requestData.resize(requestEnd);
+        }
+        if(isReused) Metrics::getInstance().increment(Metrics::Counter::KEEP_ALIVE_REUSED);
+        if(Logger::getInstance().isEnabled(Logger::LogLevel::DEBUG)) request.display();
 
-        // Build the response
-        ResponseResult responseResult; // Helper class to wrap std::variant<HttpResponse, http::status::Code>
-        http::method::Method method = http::method::fromString(request.getMethod());
-        auto builder = factory->createBuilder(method);
-        if(builder) {
-            responseResult = builder->buildResponse(request);
+        // Determine if connection should be kept alive
+        bool keepAlive = true; // Default
+        if(auto connectionHeader = request.getHeader("Connection"); connectionHeader) {
+            keepAlive = (*connectionHeader == "keep-alive");
         }
-        else {
-            // If the builder is null, the method is not supported
-            responseResult = ResponseResult{http::status::Code::NOT_IMPLEMENTED};
+
+        // Refuse clients over their request rate before reading the body or doing any work
+        if(rateLimiter->limitsRequests()) {
+            if(clientKey == 0) clientKey = RateLimiter::clientKey(client_socket->get());
+            if(!rateLimiter->allowRequest(clientKey)) {
+                http::method::Method method = http::method::fromString(request.getMethod());
+                bool hasBody = request.getContentLength().value_or(0) > 0 || request.getHeader("Transfer-Encoding");
+                keepAlive = keepAlive && !hasBody; // An unread body would be taken for the next request
+                Metrics::getInstance().increment(Metrics::Counter::RATE_LIMITED_REQUESTS);
+                sendErrorResponse(http::status::Code::TOO_MANY_REQUESTS, keepAlive, method == http::method::Method::HEAD);
+                Metrics::getInstance().recordRequest(method, http::status::Code::TOO_MANY_REQUESTS);
+                return keepAlive;
+            }
         }
 
-        // Compose the response
-        HttpResponse response;
-        if(responseResult.isSuccess()) {
-            response = responseResult.getResponse();
+        // Match dynamic routes on the path, without the query string
+        std::string_view path = request.getURI().substr(0, request.getURI().find('?'));
+        Router::Match route;
+        factory->matchRoute(request, route);
+
+        // Forward proxied routes before their body is read, the WebSocket and event stream paths stay local
+        bool isLocalStream = (WebSocketConnection::isUpgradeRequest(request) && path == Config::getInstance().getWebSocketPath())
+                          || (request.getMethod() == "GET" && path == Config::getInstance().getEventsPath());
+        if(auto proxy = dynamic_cast<const ReverseProxy*>(route.builder); proxy && !isLocalStream) {
+            return forwardRequest(*proxy, request, std::string_view(requestData).substr(bodyStart), keepAlive, start);
         }
-        else {
-            composer->composeErrorMessage(response, responseResult.getError());
+        readBody(request, requestData, bodyStart);
+
+        // Switch to HTTP/2 when asked to, stream 1 answers this request
+        if(Http2Session::isUpgradeRequest(request)) {
+            client_socket->send(H2C_SWITCHING_PROTOCOLS.data(), H2C_SWITCHING_PROTOCOLS.size(), MSG_NOSIGNAL);
+            Http2Session session(*client_socket, factory, composer);
+            session.runUpgraded(request);
+            return false;
         }
 
-        // Determine if connection should be kept alive
-        bool keepAlive = true;
-        if(auto connectionHeader = request.getHeader("Connection"); connectionHeader) {
-            if(*connectionHeader == "keep-alive") {
-                response.setHeader("Connection", "keep-alive");
+        // Hand WebSocket connections to the event loop so they do not hold this worker
+        if(WebSocketConnection::isUpgradeRequest(request) && path == Config::getInstance().getWebSocketPath()) {
+            std::optional<std::string> handshake = WebSocketConnection::acceptHandshake(request);
+            if(!handshake) {
+                sendErrorResponse(http::status::Code::BAD_REQUEST, false);
+                Metrics::getInstance().recordRequest(http::method::fromString(request.getMethod()), http::status::Code::BAD_REQUEST);
+                return false;
             }
-            else {
-                response.setHeader("Connection", "close");
-                keepAlive = false;
+            client_socket->send(handshake->data(), handshake->size(), MSG_NOSIGNAL);
+            Metrics::getInstance().recordRequest(http::method::Method::GET, http::status::Code::SWITCHING_PROTOCOLS);
+            eventLoop->adopt(std::make_unique<WebSocketConnection>(std::move(client_socket)));
+            return false;
+        }
+
+        // Event streams never end, so they are parked in the event loop as well
+        if(request.getMethod() == "GET" && path == Config::getInstance().getEventsPath()) {
+            Metrics::getInstance().recordRequest(http::method::Method::GET, http::status::Code::OK);
+            broadcaster->subscribe(std::move(client_socket));
+            return false;
+        }
+
+        http::method::Method method = http::method::fromString(request.getMethod());
+        bool isHead = (method == http::method::Method::HEAD);
+
+        // Serve small files straight from the response cache, HEAD shares the GET entry's headers
+        if((method == http::method::Method::GET || isHead) && !route.pathMatched && responseCache->isEnabled()) {
+            std::pmr::string requestPath(request.getResource());
+            ResponseCache::appendRequestPath(request.getURI(), requestPath);
+            if(auto entry = responseCache->lookup(requestPath)) {
+                timer.mark(RequestTimer::Phase::RESOLVED);
+                timer.mark(RequestTimer::Phase::RESPONSE_BUILT);
+                sendPrebuilt(entry->headers(), isHead ? std::string_view() : entry->body(), keepAlive);
+                Metrics::getInstance().recordRequest(method, http::status::Code::OK);
+                Metrics::getInstance().observe(Metrics::Histogram::REQUEST_DURATION, std::chrono::steady_clock::now() - start);
+                logIfSlow(request);
+                return keepAlive;
             }
-        } 
-        else {
-            response.setHeader("Connection", "keep-alive"); // Default
         }
 
+        // Build the response
+        ResponseResult responseResult = factory->buildResponse(request, route); // Wraps std::variant<HttpResponse, http::status::Code>
+
         // Send the response
-        sendResponse(response);
-        if(Logger::getInstance().getLogLevel() == Logger::LogLevel::DEBUG) response.display();
+        http::status::Code status;
+        if(responseResult.isSuccess()) {
+            HttpResponse response = responseResult.takeResponse();
+            timer.mark(RequestTimer::Phase::RESPONSE_BUILT);
+            response.setHeader("Connection", keepAlive ? "keep-alive" : "close");
+            response.setHeader("Date", Clock::getInstance().getHttpDate());
+            sendResponse(response);
+            status = response.getStatus();
+            if(Logger::getInstance().isEnabled(Logger::LogLevel::DEBUG)) response.display();
+        }
+        else {
+            status = responseResult.getError();
+            timer.mark(RequestTimer::Phase::RESPONSE_BUILT);
+            sendErrorResponse(status, keepAlive, isHead);
+        }
+
+        Metrics::getInstance().recordRequest(method, status);
+        Metrics::getInstance().observe(Metrics::Histogram::REQUEST_DURATION, std::chrono::steady_clock::now() - start);
+        logIfSlow(request);
         return keepAlive;
     }
     catch(const std::system_error& e) {
@@ -197,32 +367,68 @@ bool ConnectionHandler::handleRequest() {
         else {
             Logger::getInstance().log(std::string(e.what()), Logger::LogLevel::ERROR);
         }
-        HttpResponse response;
-        sendErrorResponse(response, http::status::Code::BAD_REQUEST);
+        sendErrorResponse(http::status::Code::BAD_REQUEST, false);
+        return false;
+    }
+    catch(const std::length_error& e) {
+        Logger::getInstance().log(std::string(e.what()), Logger::LogLevel::WARN);
+        sendErrorResponse(http::status::Code::PAYLOAD_TOO_LARGE, false);
+        return false;
+    }
+    catch(const std::invalid_argument& e) {
+        Logger::getInstance().log(std::string(e.what()), Logger::LogLevel::WARN);
+        sendErrorResponse(http::status::Code::BAD_REQUEST, false);
         return false;
     }
     catch(const std::exception& e) {
-        HttpResponse response;
-        sendErrorResponse(response, http::status::Code::INTERNAL_SERVER_ERROR);
+        sendErrorResponse(http::status::Code::INTERNAL_SERVER_ERROR, false);
         return false;
     }
 }
 
 /**
- * @brief Parses the incoming HTTP request.
- * @return The parsed HttpRequest object.
+ * @brief Logs the phase breakdown of the current request if it exceeded the slow threshold.
+ * @param request The request that was just served.
  */
-HttpRequest ConnectionHandler::parseRequest() {
-    char buffer[BUFFER_SIZE] = {0};
-    std::string requestData;
+void ConnectionHandler::logIfSlow(const HttpRequest& request) const {
+    int thresholdMs = Config::getInstance().getSlowRequestMs();
+    if(thresholdMs <= 0) return;
+    if(timer.elapsed() < std::chrono::milliseconds(thresholdMs)) return;
+
+    Logger::getInstance().log<Logger::LogLevel::WARN>([&] {
+        return "Slow request: " + request.getStatusLine() + " " + timer.describe();
+    });
+}
 
-    while(true) {
+/**
+ * @brief Parses the head of the incoming HTTP request.
+ * @details Starts from the bytes left over by a pipelined request and reads until the headers
+ * are complete; body bytes that arrived with them stay in `requestData` after `bodyStart`.
+ * @param requestData The buffer that receives the raw request.
+ * @param bodyStart Receives the offset of the body in `requestData`.
+ * @return The HttpRequest object, without its body.
+ */
+HttpRequest ConnectionHandler::parseHead(std::pmr::string& requestData, size_t& bodyStart) {
+    char buffer[BUFFER_SIZE];
+
+    if(!pipelined.empty()) {
+        timer.mark(RequestTimer::Phase::FIRST_BYTE);
+        requestData.assign(pipelined);
+        pipelined.clear();
+    }
+
+    while(requestData.find("\r\n\r\n") == std::string::npos) {
         ssize_t bytesRead = client_socket->recv(buffer, BUFFER_SIZE, 0);
       
         if(bytesRead < 0) {
             if(errno == EAGAIN || errno == EWOULDBLOCK) {
                 Logger::getInstance().log("No more data available to read.", Logger::LogLevel::DEBUG);
-                break; // No more data available
+                if(requestData.empty()) break; // No more data available
+                // Part of the head is here (e.g. the tail of a pipelined batch), wait for the rest
+                if(!waitForSocketEvent(client_socket->get(), POLLIN, BODY_READ_TIMEOUT)) {
+                    throw std::runtime_error("Timed out waiting for the request head.");
+                }
+                continue;
             }
             throw std::runtime_error("Failed to read request: " + std::string(std::strerror(errno)));
         }
@@ -231,105 +437,255 @@ HttpRequest ConnectionHandler::parseRequest() {
             throw std::runtime_error("Client closed connection before sending complete request.");
         }
       
+        if(requestData.empty()) timer.mark(RequestTimer::Phase::FIRST_BYTE);
         requestData.append(buffer, bytesRead);
-        Logger::getInstance().log("Bytes read: " + std::to_string(bytesRead), Logger::LogLevel::DEBUG);
-
-        // Check if headers are complete (look for the empty line)
-        if(requestData.find("\r\n\r\n") != std::string::npos) {
-            Logger::getInstance().log("Complete header received.", Logger::LogLevel::DEBUG);
-            break; // Can start parsing the request
-        }
+        Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] { return "Bytes read: " + std::to_string(bytesRead); });
     }
 
-    // Parse the request
-    HttpRequest request;
-    if(!request.parse(requestData)) {
+    // Parse the start line and headers
+    HttpRequest request(&arena);
+    if(!request.parseHead(requestData, bodyStart)) {
         throw std::runtime_error("Invalid HTTP request.");
     }
+    timer.mark(RequestTimer::Phase::HEADERS_PARSED);
     return request;
 }
 
+/**
+ * @brief Reads the body of a request whose head was parsed.
+ * @details Keeps reading until the whole body announced by Content-Length has arrived, however
+ * many reads that takes. A multipart body is parsed as it arrives instead, see `readMultipartBody`.
+ * @param request The request; its body is a view into `requestData`.
+ * @param requestData The buffer holding the raw request.
+ * @param bodyStart The offset of the body in `requestData`.
+ * @throws std::length_error if the announced body is larger than `MAX_BODY_SIZE`.
+ */
+void ConnectionHandler::readBody(HttpRequest& request, std::pmr::string& requestData, size_t bodyStart) {
+    char buffer[BUFFER_SIZE];
+
+    // Multipart bodies are parsed as they arrive instead of being buffered
+    if(auto boundary = MultipartParser::boundaryFromContentType(request.getHeader("Content-Type").value_or(""))) {
+        readMultipartBody(request, std::string_view(requestData).substr(bodyStart), *boundary, buffer);
+        return;
+    }
+
+    // Read the rest of the body, it may arrive over several reads
+    size_t contentLength = request.getContentLength().value_or(0);
+    if(contentLength > MAX_BODY_SIZE) {
+        throw std::length_error("Request body of " + std::to_string(contentLength) + " bytes is too large.");
+    }
+    requestData.reserve(bodyStart + contentLength);
+    while(requestData.size() < bodyStart + contentLength) {
+        size_t wanted = std::min<size_t>(BUFFER_SIZE, bodyStart + contentLength - requestData.size());
+        requestData.append(buffer, receiveBodyChunk(buffer, wanted));
+    }
+
+    if(!request.parseBody(requestData, bodyStart)) {
+        throw std::runtime_error("Invalid HTTP request.");
+    }
+}
+
+/**
+ * @brief Forwards a request to the upstreams of a proxy route and records the outcome.
+ * @param proxy The proxy that owns the route.
+ * @param request The request, whose body has not been read.
+ * @param received The body bytes that arrived with the head.
+ * @param keepAlive `true` if the client asked to keep the connection.
+ * @param start When the request was parsed.
+ * @return `true` if the connection should be kept alive.
+ */
+bool ConnectionHandler::forwardRequest(const ReverseProxy& proxy, const HttpRequest& request, std::string_view received,
+                                       bool keepAlive, std::chrono::steady_clock::time_point start) {
+    http::method::Method method = http::method::fromString(request.getMethod());
+    ReverseProxy::Result result = proxy.forward(request, received, *client_socket, keepAlive);
+    timer.mark(RequestTimer::Phase::RESPONSE_BUILT);
+    if(!result.responded) sendErrorResponse(result.status, keepAlive, method == http::method::Method::HEAD);
+
+    Metrics::getInstance().recordRequest(method, result.status);
+    Metrics::getInstance().observe(Metrics::Histogram::REQUEST_DURATION, std::chrono::steady_clock::now() - start);
+    logIfSlow(request);
+    return keepAlive;
+}
+
+/**
+ * @brief Streams a `multipart/form-data` body through a MultipartParser and attaches the parts.
+ * @param request The request whose head was parsed.
+ * @param received The body bytes that arrived together with the headers.
+ * @param boundary The boundary from the Content-Type header.
+ * @param buffer A receive buffer of `BUFFER_SIZE` bytes.
+ * @throws std::length_error if the body is larger than `MAX_UPLOAD_SIZE`.
+ * @throws std::invalid_argument if the body is malformed.
+ */
+void ConnectionHandler::readMultipartBody(HttpRequest& request, std::string_view received, std::string_view boundary, char* buffer) {
+    size_t contentLength = request.getContentLength().value_or(0);
+    if(contentLength > MAX_UPLOAD_SIZE) {
+        throw std::length_error("Upload of " + std::to_string(contentLength) + " bytes is too large.");
+    }
+
+    MultipartParser parser(boundary);
+    received = received.substr(0, contentLength);
+    bool ok = parser.feed(received);
+    for(size_t remaining = contentLength - received.size(); ok && remaining > 0;) {
+        size_t bytesRead = receiveBodyChunk(buffer, std::min<size_t>(BUFFER_SIZE, remaining));
+        ok = parser.feed(std::string_view(buffer, bytesRead));
+        remaining -= bytesRead;
+    }
+    if(!ok || !parser.finish()) {
+        throw std::invalid_argument("Malformed multipart body.");
+    }
+    request.setParts(std::make_shared<const MultipartParser::Parts>(parser.takeParts()));
+}
+
+/**
+ * @brief Receives the next part of a request body, waiting up to `BODY_READ_TIMEOUT` for it.
+ * @param buffer The buffer to receive into.
+ * @param size The maximum number of bytes to receive.
+ * @return The number of bytes received, always at least one.
+ */
+size_t ConnectionHandler::receiveBodyChunk(char* buffer, size_t size) {
+    while(true) {
+        ssize_t bytesRead = client_socket->recv(buffer, size, 0);
+        if(bytesRead > 0) {
+            return static_cast<size_t>(bytesRead);
+        }
+        if(bytesRead == 0) {
+            throw std::runtime_error("Client closed connection before sending complete body.");
+        }
+        if(errno != EAGAIN && errno != EWOULDBLOCK) {
+            throw std::runtime_error("Failed to read request body: " + std::string(std::strerror(errno)));
+        }
+        if(!waitForSocketEvent(client_socket->get(), POLLIN, BODY_READ_TIMEOUT)) {
+            throw std::runtime_error("Timed out waiting for the request body.");
+        }
+    }
+}
+
 /**
  * @brief Sends a static or dynamic HTTP response to the client.
  * @param response The HttpResponse object to send.
  */
 void ConnectionHandler::sendResponse(HttpResponse& response) {
-    // Compose the response headers
-    const std::string responseHeadersStr = composer->composeResponseString(response);
+    // Dynamic responses always advertise their body length
+    if(!response.getIsStatic() && !response.getContentLength()) {
+        response.setContentLength(response.getBody().length());
+    }
 
-    // Send HTTP headers, MSG_NOSIGNAL to prevent SIGPIPE (broken pipe)
-    if(client_socket->send(responseHeadersStr.c_str(), responseHeadersStr.size(), MSG_NOSIGNAL) < 0) {
-        return;
+    // Serialize the headers on the stack, falling back to the heap for oversized headers
+    char headerBuffer[HEADER_BUFFER_SIZE];
+    std::string oversizedHeaders;
+    const char* headers = headerBuffer;
+    size_t headersLength = composer->serializeHeaders(response, headerBuffer, sizeof(headerBuffer));
+    if(headersLength == 0) {
+        oversizedHeaders = composer->composeResponseString(response);
+        headers = oversizedHeaders.data();
+        headersLength = oversizedHeaders.size();
     }
 
     // Check if the response body is a file path (static content)
     if(response.getIsStatic()) {
-        // Get the file path from response body or header
-        const auto file = response.getHeader("File-Path").value_or("");
-
         // Open the file in read-only mode
+        const std::pmr::string& file = response.getFilePath();
         int file_fd = open(file.c_str(), O_RDONLY);
         if(file_fd < 0) {
-            std::cerr << "open() failed: " << std::strerror(errno) << std::endl;
-            Logger::getInstance().log("Failed to open static file: " + file, Logger::LogLevel::ERROR);
+            Logger::getInstance().log("Failed to open static file: " + std::string(file) + ", error: " + std::strerror(errno), Logger::LogLevel::ERROR);
+            sendErrorResponse(http::status::Code::INTERNAL_SERVER_ERROR, false);
             return;
         }
 
-        // Send the file content using sendfile()
-        off_t offset = 0;
+        // Determine how many bytes to send
         size_t totalBytesToSend;
-        std::optional<std::string> contentLength = response.getHeader("Content-Length");
-        
-        if(contentLength.has_value()) {
-            totalBytesToSend = std::stoul(contentLength.value());
+        if(auto contentLength = response.getContentLength()) {
+            totalBytesToSend = *contentLength;
         }
         else {
             struct stat fileStat;
             if(fstat(file_fd, &fileStat) < 0) {
                 Logger::getInstance().log("Failed to get file stats.", Logger::LogLevel::ERROR);
                 close(file_fd);
-                sendErrorResponse(response, http::status::Code::INTERNAL_SERVER_ERROR);
+                sendErrorResponse(http::status::Code::INTERNAL_SERVER_ERROR, false);
                 return;
             }
             totalBytesToSend = fileStat.st_size;
         }
 
+        // Send HTTP headers, MSG_MORE lets the kernel merge them with the first sendfile() segment
+        client_socket->send(headers, headersLength, MSG_NOSIGNAL | MSG_MORE);
+        timer.mark(RequestTimer::Phase::HEADERS_SENT);
+
+        // Send the file content using sendfile()
+        off_t offset = 0;
         ssize_t bytesSent = client_socket->sendfile(file_fd, &offset, totalBytesToSend);
         if(bytesSent < 0) {
             Logger::getInstance().log("Failed to send static file content.", Logger::LogLevel::ERROR);
-            close(file_fd);
-            sendErrorResponse(response, http::status::Code::INTERNAL_SERVER_ERROR);
-            return;
         }
         
         // Close the file descriptor
         close(file_fd);
     }
     else {
-        // Send dynamic content
-        const std::string body = response.getBody();
-        if(!body.empty()) {
-            if(!response.getHeader("Content-Length").has_value()) {
-                response.setHeader("Content-Length", std::to_string(body.length()));
-            }
-        }
-        else {
-            response.setHeader("Content-Length", "0");
-        }
-
-        ssize_t bytesSent = client_socket->send(body.c_str(), body.length(), MSG_NOSIGNAL);
-        if(bytesSent < 0) {
-            sendErrorResponse(response, http::status::Code::INTERNAL_SERVER_ERROR);
-            return;
-        }
+        // Send headers and dynamic content together, MSG_NOSIGNAL to prevent SIGPIPE (broken pipe)
+        std::string_view body = response.getBody();
+        struct iovec iov[2];
+        iov[0].iov_base = const_cast<char*>(headers);
+        iov[0].iov_len = headersLength;
+        iov[1].iov_base = const_cast<char*>(body.data());
+        iov[1].iov_len = body.length();
+
+        client_socket->sendv(iov, body.empty() ? 1 : 2, MSG_NOSIGNAL);
+        timer.mark(RequestTimer::Phase::HEADERS_SENT);
     }
+    timer.mark(RequestTimer::Phase::BODY_SENT);
 }
 
 /**
- * @brief Composes an error response and sends it to the client.
+ * @brief Sends a pre-serialized response to the client.
+ * @details Only the `date` and `connection` headers are written per request, they go between the
+ * fixed headers and the body, and everything goes out in one `sendmsg()`.
+ * @param headers The status line and fixed headers, without the terminating blank line.
+ * @param body The response body.
+ * @param keepAlive `true` if the connection stays open after the response.
+ */
+void ConnectionHandler::sendPrebuilt(std::string_view headers, std::string_view body, bool keepAlive) {
+    // Per-request headers
+    char dynamicHeaders[128];
+    char* out = dynamicHeaders;
+    auto append = [&](std::string_view str) {
+        std::memcpy(out, str.data(), str.size());
+        out += str.size();
+    };
+    append("date: ");
+    append(Clock::getInstance().getHttpDate());
+    append(keepAlive ? "\r\nconnection: keep-alive\r\n\r\n" : "\r\nconnection: close\r\n\r\n");
+
+    struct iovec iov[3];
+    iov[0].iov_base = const_cast<char*>(headers.data());
+    iov[0].iov_len = headers.size();
+    iov[1].iov_base = dynamicHeaders;
+    iov[1].iov_len = static_cast<size_t>(out - dynamicHeaders);
+    iov[2].iov_base = const_cast<char*>(body.data());
+    iov[2].iov_len = body.size();
+
+    client_socket->sendv(iov, body.empty() ? 2 : 3, MSG_NOSIGNAL);
+    timer.mark(RequestTimer::Phase::HEADERS_SENT);
+    timer.mark(RequestTimer::Phase::BODY_SENT);
+}
+
+/**
+ * @brief Sends a prebuilt error response to the client.
+ * @details The immutable status line, headers and body come from the composer.
  * @param code The HTTP status code to send.
+ * @param keepAlive `true` if the connection stays open after the response.
+ * @param omitBody `true` to send only the headers, as a reply to HEAD.
  */
-void ConnectionHandler::sendErrorResponse(HttpResponse& response, const http::status::Code& code) {
-    composer->composeErrorMessage(response, code);
-    client_socket->send(response.getBody().c_str(), response.getBody().length(), MSG_NOSIGNAL);
-}
\ No newline at end of file
+void ConnectionHandler::sendErrorResponse(http::status::Code code, bool keepAlive, bool omitBody) noexcept {
+    const ResponseComposer::PrebuiltResponse& prebuilt = composer->getErrorResponse(code);
+    try {
+        sendPrebuilt(prebuilt.headers(), omitBody ? std::string_view() : prebuilt.body(), keepAlive);
+    }
+    catch(const std::exception& e) {
+        // The client is most likely gone; this is called from error paths so it must not throw
+        Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] {
+            return "Failed to send error response: " + std::string(e.what());
+        });
+    }
+}
@@ -74,6 +74,23 @@ void EpollManager::addSocket(const Socket& socket, uint32_t events) {
     }
 }
 
+/**
+ * @brief Change the events a socket is watched for.
+ * @param fd The file descriptor of a socket already added.
+ * @param events The events to listen for.
+ * @throws std::runtime_error If the socket could not be modified.
+ */
+void EpollManager::modifySocket(int fd, uint32_t events) {
+    struct epoll_event event;
+    event.data.fd = fd;
+    event.events = events;
+
+    // EPOLL_CTL_MOD = Change the settings associated with fd in the interest list
+    if(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) < 0) {
+        throw std::runtime_error("Failed to modify socket in epoll: " + std::string(std::strerror(errno)));
+    }
+}
+
 /**
  * @brief Remove a socket from the epoll instance.
  * @param fd The file descriptor of the socket to remove.
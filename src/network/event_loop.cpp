@@ -0,0 +1,253 @@
+/**
+ * @file event_loop.cpp
+ * @brief This file contains the definition of the EventLoop class.
+ * @details The event loop owns long-lived, mostly idle connections (such as WebSockets) after
+ * their handshake, so they wait in epoll instead of pinning a `ThreadPool` worker each.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "event_loop.hpp"
+#include "logger.hpp"
+
+#include <sys/epoll.h>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// Constructors //
+
+/**
+ * @brief Constructs a new EventLoop object and starts its thread.
+ * @throws std::runtime_error if the epoll instance could not be created.
+ */
+EventLoop::EventLoop()
+    : epollManager(std::make_unique<EpollManager>(MAX_EVENTS)),
+      readBuffer(std::make_unique<char[]>(READ_BUFFER_SIZE)),
+      running(true) {
+    thread = std::thread([this] { run(); });
+}
+
+/**
+ * @brief Destroys the EventLoop object, closing every parked connection.
+ */
+EventLoop::~EventLoop() {
+    shutdown();
+}
+
+// Lifecycle //
+
+/**
+ * @brief Stops the loop thread and closes every parked connection.
+ */
+void EventLoop::shutdown() {
+    if(!running.exchange(false)) return; // Prevent double shutdown
+    epollManager->wakeup();
+    if(thread.joinable()) thread.join();
+    Logger::getInstance().log("EventLoop destroyed.", Logger::LogLevel::DEBUG);
+}
+
+/**
+ * @brief Hands a connection to the loop. Safe to call from any thread.
+ * @param connection The connection, whose handshake is complete.
+ */
+void EventLoop::adopt(std::unique_ptr<Connection> connection) {
+    if(!connection) return;
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        if(!running) return; // Shutting down, the connection closes here
+        adopted.push_back(std::move(connection));
+    }
+    epollManager->wakeup();
+}
+
+/**
+ * @brief Runs a task on the loop thread, where it may touch parked connections. Safe to call from any thread.
+ * @details Tasks are dropped once the loop is shutting down.
+ * @param task The task; it must not block.
+ */
+void EventLoop::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        if(!running) return;
+        posted.push_back(std::move(task));
+    }
+    epollManager->wakeup();
+}
+
+// Functions //
+
+/**
+ * @brief Waits for socket events and dispatches them until shutdown.
+ */
+void EventLoop::run() {
+    auto lastTick = std::chrono::steady_clock::now();
+    while(running) {
+        std::vector<epoll_event> events;
+        try {
+            events = epollManager->waitForEvents(TICK_MS);
+        }
+        catch(const std::exception& e) {
+            Logger::getInstance().log(std::string(e.what()), Logger::LogLevel::ERROR);
+            continue;
+        }
+
+        registerAdopted();
+        if(runPosted()) {
+            // Tasks may have queued output on any connection
+            for(auto it = connections.begin(); it != connections.end();) {
+                if(refresh(it->first, it->second)) {
+                    ++it;
+                    continue;
+                }
+                epollManager->removeSocket(it->first);
+                it = connections.erase(it);
+            }
+        }
+        for(const epoll_event& event : events) {
+            if(event.data.fd == epollManager->getWakeupFd()) continue;
+            dispatch(event);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if(now - lastTick >= std::chrono::milliseconds(TICK_MS)) {
+            tick(now);
+            lastTick = now;
+        }
+    }
+
+    // Let every connection say goodbye before its socket closes
+    registerAdopted();
+    for(auto& [fd, entry] : connections) {
+        entry.connection->onShutdown();
+        epollManager->removeSocket(fd);
+    }
+    connections.clear();
+}
+
+/**
+ * @brief Adds the connections handed over since the last wakeup to epoll.
+ */
+void EventLoop::registerAdopted() {
+    std::vector<std::unique_ptr<Connection>> batch;
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        batch.swap(adopted);
+    }
+
+    for(auto& connection : batch) {
+        int fd = connection->getSocket().get();
+        try {
+            epollManager->addSocket(connection->getSocket(), EPOLLIN | EPOLLRDHUP);
+        }
+        catch(const std::exception& e) {
+            Logger::getInstance().log(std::string(e.what()), Logger::LogLevel::ERROR);
+            continue;
+        }
+        Entry& entry = connections[fd];
+        entry.connection = std::move(connection);
+        entry.connection->onAdopted();
+        if(!refresh(fd, entry)) { // Output queued during the handshake
+            epollManager->removeSocket(fd);
+            connections.erase(fd);
+        }
+    }
+}
+
+/**
+ * @brief Runs the tasks posted since the last wakeup.
+ * @return `true` if any task ran.
+ */
+bool EventLoop::runPosted() {
+    std::vector<std::function<void()>> batch;
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        batch.swap(posted);
+    }
+
+    for(auto& task : batch) {
+        try {
+            task();
+        }
+        catch(const std::exception& e) {
+            Logger::getInstance().log(std::string(e.what()), Logger::LogLevel::ERROR);
+        }
+    }
+    return !batch.empty();
+}
+
+/**
+ * @brief Runs the callbacks for one socket event.
+ * @param event The event reported by epoll.
+ */
+void EventLoop::dispatch(const epoll_event& event) {
+    int fd = event.data.fd;
+    auto it = connections.find(fd);
+    if(it == connections.end()) return;
+    Entry& entry = it->second;
+
+    bool keep = true;
+    try {
+        // Read before acting on a hang-up, the peer's last frames may still be queued
+        if(event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) keep = entry.connection->onReadable(readBuffer.get(), READ_BUFFER_SIZE);
+        if(keep && (event.events & EPOLLOUT)) keep = entry.connection->onWritable();
+        if(keep && (event.events & EPOLLERR)) keep = false;
+    }
+    catch(const std::exception& e) {
+        Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] { return "Parked connection failed: " + std::string(e.what()); });
+        keep = false;
+    }
+
+    if(!keep || !refresh(fd, entry)) {
+        epollManager->removeSocket(fd);
+        connections.erase(it);
+    }
+}
+
+/**
+ * @brief Gives every connection a chance to send keep-alives or time out.
+ * @param now The current time.
+ */
+void EventLoop::tick(std::chrono::steady_clock::time_point now) {
+    for(auto it = connections.begin(); it != connections.end();) {
+        bool keep;
+        try {
+            keep = it->second.connection->onTick(now) && refresh(it->first, it->second);
+        }
+        catch(const std::exception& e) {
+            keep = false;
+        }
+        if(keep) {
+            ++it;
+            continue;
+        }
+        epollManager->removeSocket(it->first);
+        it = connections.erase(it);
+    }
+}
+
+/**
+ * @brief Watches for writability only while a connection has output queued.
+ * @param fd The connection's socket.
+ * @param entry The connection.
+ * @return `false` if epoll rejected the change.
+ */
+bool EventLoop::refresh(int fd, Entry& entry) {
+    bool wantsWrite = entry.connection->wantsWrite();
+    if(wantsWrite == entry.writing) return true;
+
+    try {
+        uint32_t events = EPOLLIN | EPOLLRDHUP;
+        if(wantsWrite) events |= EPOLLOUT;
+        epollManager->modifySocket(fd, events);
+    }
+    catch(const std::exception& e) {
+        Logger::getInstance().log(std::string(e.what()), Logger::LogLevel::ERROR);
+        return false;
+    }
+    entry.writing = wantsWrite;
+    return true;
+}
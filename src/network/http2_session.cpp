@@ -0,0 +1,1112 @@
+/**
+ * @file http2_session.cpp
+ * @brief This file contains the definition of the Http2Session class.
+ * @details This class serves one cleartext HTTP/2 (h2c) connection, started either with the
+ * connection preface (prior knowledge) or by upgrading an HTTP/1.1 request. Requests on every
+ * stream are answered by the same response builders as HTTP/1.1.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "clock.hpp"
+#include "http2_session.hpp"
+#include "http_method.hpp"
+#include "http_mime.hpp"
+#include "http_server.hpp"
+#include "http_status.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "n_utils.hpp"
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace {
+    uint16_t readUint16(std::string_view data, size_t pos) noexcept {
+        return static_cast<uint16_t>((static_cast<uint8_t>(data[pos]) << 8) | static_cast<uint8_t>(data[pos + 1]));
+    }
+
+    uint32_t readUint32(std::string_view data, size_t pos) noexcept {
+        return (static_cast<uint32_t>(static_cast<uint8_t>(data[pos])) << 24) |
+               (static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 1])) << 16) |
+               (static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 2])) << 8) |
+               static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 3]));
+    }
+
+    void appendUint32(std::string& out, uint32_t value) {
+        out.push_back(static_cast<char>(value >> 24));
+        out.push_back(static_cast<char>(value >> 16));
+        out.push_back(static_cast<char>(value >> 8));
+        out.push_back(static_cast<char>(value));
+    }
+
+    void appendSetting(std::string& out, uint16_t id, uint32_t value) {
+        out.push_back(static_cast<char>(id >> 8));
+        out.push_back(static_cast<char>(id));
+        appendUint32(out, value);
+    }
+
+    /**
+     * @brief Decodes the base64url value of an HTTP2-Settings header, with or without padding.
+     * @return `false` if the value is not valid base64url.
+     */
+    bool decodeBase64Url(std::string_view str, std::string& out) {
+        while(!str.empty() && str.back() == '=') str.remove_suffix(1);
+        if(str.size() % 4 == 1) return false;
+
+        uint32_t bits = 0;
+        int count = 0;
+        for(char c : str) {
+            uint32_t value;
+            if(c >= 'A' && c <= 'Z') value = static_cast<uint32_t>(c - 'A');
+            else if(c >= 'a' && c <= 'z') value = static_cast<uint32_t>(c - 'a' + 26);
+            else if(c >= '0' && c <= '9') value = static_cast<uint32_t>(c - '0' + 52);
+            else if(c == '-' || c == '+') value = 62;
+            else if(c == '_' || c == '/') value = 63;
+            else return false;
+
+            bits = (bits << 6) | value;
+            count += 6;
+            if(count >= 8) {
+                count -= 8;
+                out.push_back(static_cast<char>(bits >> count));
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Checks for headers that only describe an HTTP/1.1 connection.
+     */
+    bool isConnectionHeader(std::string_view name) noexcept {
+        return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+               name == "transfer-encoding" || name == "upgrade";
+    }
+
+    /**
+     * @brief Waits until a socket is readable.
+     * @return `true` if data (or a hang-up) is pending.
+     */
+    bool waitReadable(int fd, int timeoutMs) {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ret = ::poll(&pfd, 1, timeoutMs);
+        if(ret < 0 && errno != EINTR) {
+            throw std::runtime_error("poll failed: " + std::string(std::strerror(errno)));
+        }
+        return ret > 0;
+    }
+}
+
+// Stream //
+
+Http2Session::Stream::~Stream() {
+    if(fileFd >= 0) ::close(fileFd);
+}
+
+// Constructors //
+
+/**
+ * @brief Constructs a new Http2Session object.
+ * @param socket The client socket, which must outlive the session.
+ * @param factory The response builder factory.
+ * @param composer The response composer, for the prebuilt error bodies.
+ */
+Http2Session::Http2Session(Socket& socket, std::shared_ptr<ResponseBuilderFactory> factory, std::shared_ptr<ResponseComposer> composer)
+    : socket(socket), factory(std::move(factory)), composer(std::move(composer)) {
+    // Frames are batched by hand; Nagle would hold back the last small frame of a window
+    int enable = 1;
+    ::setsockopt(socket.get(), IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+}
+
+Http2Session::~Http2Session() = default;
+
+// Functions //
+
+/**
+ * @brief Checks whether received bytes could be the start of the connection preface.
+ * @param data The first bytes of the connection.
+ * @return `true` if `data` and the preface agree on their common length.
+ */
+bool Http2Session::isPrefacePrefix(std::string_view data) noexcept {
+    size_t length = std::min(data.size(), PREFACE.size());
+    return length > 0 && data.substr(0, length) == PREFACE.substr(0, length);
+}
+
+/**
+ * @brief Checks whether an HTTP/1.1 request asks to upgrade to h2c.
+ * @details The upgrade is only taken for requests without a body, so the whole request is
+ * already known when stream 1 is opened.
+ * @param request The parsed HTTP/1.1 request.
+ * @return `true` if the request carries `Upgrade: h2c` and a valid HTTP2-Settings header.
+ */
+bool Http2Session::isUpgradeRequest(const HttpRequest& request) {
+    using n_utils::str_manip::hasToken;
+    auto upgrade = request.getHeader("Upgrade");
+    auto connection = request.getHeader("Connection");
+    auto settings = request.getHeader("HTTP2-Settings");
+    if(!upgrade || !connection || !settings) return false;
+    if(!hasToken(*upgrade, "h2c") || !hasToken(*connection, "upgrade") || !hasToken(*connection, "http2-settings")) return false;
+    if(!request.getBody().empty() || request.getParts() != nullptr) return false;
+
+    std::string payload;
+    return decodeBase64Url(*settings, payload) && payload.size() % 6 == 0;
+}
+
+/**
+ * @brief Serves a connection that started with the HTTP/2 connection preface.
+ */
+void Http2Session::run() {
+    Logger::getInstance().log("HTTP/2 connection with prior knowledge.", Logger::LogLevel::DEBUG);
+    try {
+        queuePreface();
+        serve();
+    }
+    catch(const ConnectionError& e) {
+        Logger::getInstance().log("HTTP/2 connection error: " + std::string(e.what()), Logger::LogLevel::WARN);
+        goAway(e.code);
+    }
+    catch(const std::exception& e) {
+        Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] { return "HTTP/2 connection closed: " + std::string(e.what()); });
+    }
+}
+
+/**
+ * @brief Serves a connection upgraded from HTTP/1.1, after the 101 response was sent.
+ * @details The upgrade request becomes stream 1, half-closed by the client, and its
+ * HTTP2-Settings header holds the client's initial settings.
+ * @param request The HTTP/1.1 request that asked for the upgrade.
+ */
+void Http2Session::runUpgraded(HttpRequest& request) {
+    Logger::getInstance().log("HTTP/1.1 connection upgraded to h2c.", Logger::LogLevel::DEBUG);
+    try {
+        std::string settings;
+        decodeBase64Url(request.getHeader("HTTP2-Settings").value_or(""), settings);
+        applySettings(settings);
+        queuePreface();
+
+        auto stream = std::make_unique<Stream>();
+        stream->id = 1;
+        stream->remoteClosed = true;
+        stream->sendWindow = peerInitialWindow;
+        Stream& upgraded = *streams.emplace(1, std::move(stream)).first->second;
+        lastStreamId = 1;
+        streamCount = 1;
+        respond(upgraded, request);
+        serve();
+    }
+    catch(const ConnectionError& e) {
+        Logger::getInstance().log("HTTP/2 connection error: " + std::string(e.what()), Logger::LogLevel::WARN);
+        goAway(e.code);
+    }
+    catch(const std::exception& e) {
+        Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] { return "HTTP/2 connection closed: " + std::string(e.what()); });
+    }
+}
+
+// Connection //
+
+/**
+ * @brief Reads frames and writes responses until the connection is done.
+ * @details Each pass parses every complete frame, then writes at most `WRITE_QUANTUM` bytes
+ * of DATA so control frames (PING, WINDOW_UPDATE, RST_STREAM) are never starved by a large
+ * response.
+ */
+void Http2Session::serve() {
+    while(true) {
+        processFrames();
+        bool moreToWrite = writeData();
+        flush();
+
+        if((goawaySent || peerGoaway) && streams.empty()) return;
+        if(!HttpServer::isRunning()) {
+            goAway(ErrorCode::NO_ERROR);
+            return;
+        }
+
+        if(moreToWrite) {
+            receive(0);
+            continue;
+        }
+        if(!receive(streams.empty() ? IDLE_TIMEOUT : STALL_TIMEOUT)) {
+            Logger::getInstance().log<Logger::LogLevel::INFO>([&] {
+                return "Proactive closure: no HTTP/2 frames within " +
+                       std::to_string(streams.empty() ? IDLE_TIMEOUT : STALL_TIMEOUT) + "ms.";
+            });
+            goAway(ErrorCode::NO_ERROR);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Receives the next bytes of the connection.
+ * @param timeoutMs How long to wait for data, 0 to only take what is already there.
+ * @return `true` if data was received, `false` on timeout or server shutdown.
+ * @throws std::runtime_error if the client closed the connection.
+ */
+bool Http2Session::receive(int timeoutMs) {
+    char buffer[RECEIVE_BUFFER_SIZE];
+    for(int waited = 0;; waited += POLL_INTERVAL) {
+        ssize_t bytesRead = socket.recv(buffer, sizeof(buffer), 0);
+        if(bytesRead > 0) {
+            input.append(buffer, static_cast<size_t>(bytesRead));
+            return true;
+        }
+        if(bytesRead == 0) {
+            throw std::runtime_error("Client closed the connection.");
+        }
+        if(waited >= timeoutMs || !HttpServer::isRunning()) return false;
+        waitReadable(socket.get(), std::min(POLL_INTERVAL, timeoutMs - waited));
+    }
+}
+
+/**
+ * @brief Parses the preface and every complete frame in the input buffer.
+ * @throws ConnectionError if the peer violated the protocol.
+ */
+void Http2Session::processFrames() {
+    size_t offset = 0;
+    if(!prefaceReceived) {
+        size_t length = std::min(input.size(), PREFACE.size());
+        if(std::string_view(input).substr(0, length) != PREFACE.substr(0, length)) {
+            throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "Invalid connection preface.");
+        }
+        if(length < PREFACE.size()) return;
+        offset = PREFACE.size();
+        prefaceReceived = true;
+    }
+
+    std::string_view data = input;
+    while(data.size() - offset >= FRAME_HEADER_SIZE) {
+        FrameHeader header;
+        header.length = readUint32(data, offset) >> 8;
+        header.type = static_cast<FrameType>(data[offset + 3]);
+        header.flags = static_cast<uint8_t>(data[offset + 4]);
+        header.streamId = readUint32(data, offset + 5) & MAX_WINDOW_SIZE; // Drop the reserved bit
+
+        if(header.length > LOCAL_MAX_FRAME_SIZE) {
+            throw ConnectionError(ErrorCode::FRAME_SIZE_ERROR, "Frame of " + std::to_string(header.length) + " bytes is too large.");
+        }
+        if(data.size() - offset - FRAME_HEADER_SIZE < header.length) break;
+
+        handleFrame(header, data.substr(offset + FRAME_HEADER_SIZE, header.length));
+        offset += FRAME_HEADER_SIZE + header.length;
+    }
+    input.erase(0, offset);
+}
+
+/**
+ * @brief Dispatches a frame by its type. Unknown types are ignored, as the protocol requires.
+ * @param header The frame header.
+ * @param payload The frame payload.
+ */
+void Http2Session::handleFrame(const FrameHeader& header, std::string_view payload) {
+    if(continuationStream != 0 && (header.type != FrameType::CONTINUATION || header.streamId != continuationStream)) {
+        throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "Header block interrupted by another frame.");
+    }
+
+    switch(header.type) {
+        case FrameType::DATA:          handleData(header, payload); break;
+        case FrameType::HEADERS:       handleHeaders(header, payload); break;
+        case FrameType::PRIORITY:      handlePriority(header, payload); break;
+        case FrameType::RST_STREAM:    handleRstStream(header, payload); break;
+        case FrameType::SETTINGS:      handleSettings(header, payload); break;
+        case FrameType::PING:          handlePing(header, payload); break;
+        case FrameType::WINDOW_UPDATE: handleWindowUpdate(header, payload); break;
+        case FrameType::PUSH_PROMISE:
+            throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "Clients cannot push streams.");
+        case FrameType::GOAWAY:
+            if(header.streamId != 0) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "GOAWAY on a stream.");
+            peerGoaway = true; // Finish the open streams, then close
+            break;
+        case FrameType::CONTINUATION: {
+            if(continuationStream == 0) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "Unexpected CONTINUATION.");
+            headerBlock.append(payload);
+            if(headerBlock.size() > MAX_HEADER_BLOCK_SIZE) {
+                throw ConnectionError(ErrorCode::ENHANCE_YOUR_CALM, "Header block is too large.");
+            }
+            if(header.flags & END_HEADERS) {
+                uint32_t streamId = std::exchange(continuationStream, 0);
+                handleHeaderBlock(streamId, continuationEndStream);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Frames //
+
+/**
+ * @brief Handles a DATA frame, which carries part of a request body.
+ */
+void Http2Session::handleData(const FrameHeader& header, std::string_view payload) {
+    if(header.streamId == 0) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "DATA on stream 0.");
+    std::string_view data = removePadding(header, payload);
+    bool endStream = (header.flags & END_STREAM) != 0;
+
+    auto it = streams.find(header.streamId);
+    Stream* stream = (it != streams.end()) ? it->second.get() : nullptr;
+    if(stream == nullptr && header.streamId > lastStreamId) {
+        throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "DATA on an idle stream.");
+    }
+
+    // Flow control counts the whole payload, padding included, even for streams we dropped
+    if(!consumeWindow((stream && !stream->remoteClosed) ? stream : nullptr, header.length, endStream)) return;
+    if(stream == nullptr) return; // Reset or finished earlier, the frame was already in flight
+    if(stream->remoteClosed) {
+        resetStream(header.streamId, ErrorCode::STREAM_CLOSED);
+        return;
+    }
+
+    appendBody(*stream, data);
+    if(endStream) stream->remoteClosed = true;
+    if(stream->tooLarge && !stream->responding) {
+        // Answer now rather than read the rest, the client is told to stop once the 413 is sent
+        respondWithError(*stream, http::status::Code::PAYLOAD_TOO_LARGE, false);
+        return;
+    }
+    if(endStream && !stream->responding) completeRequest(*stream);
+}
+
+/**
+ * @brief Handles a HEADERS frame, which opens a stream or carries trailers.
+ */
+void Http2Session::handleHeaders(const FrameHeader& header, std::string_view payload) {
+    if(header.streamId == 0) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "HEADERS on stream 0.");
+    std::string_view block = removePadding(header, payload);
+
+    headerPriority.reset();
+    if(header.flags & PRIORITY_FLAG) {
+        if(block.size() < 5) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "HEADERS priority is truncated.");
+        headerPriority = parsePriority(block);
+        block.remove_prefix(5);
+    }
+
+    headerBlock.assign(block);
+    if(header.flags & END_HEADERS) {
+        handleHeaderBlock(header.streamId, (header.flags & END_STREAM) != 0);
+    }
+    else {
+        continuationStream = header.streamId;
+        continuationEndStream = (header.flags & END_STREAM) != 0;
+    }
+}
+
+/**
+ * @brief Decodes a complete header block and opens (or finishes) its stream.
+ * @details The block is decoded even when the stream is refused, every block updates the
+ * connection's HPACK table.
+ * @param streamId The stream the block belongs to.
+ * @param endStream `true` if the HEADERS frame ended the stream.
+ */
+void Http2Session::handleHeaderBlock(uint32_t streamId, bool endStream) {
+    HpackDecoder::HeaderList fields;
+    if(!decoder.decode(headerBlock, fields, MAX_HEADER_LIST_SIZE)) {
+        throw ConnectionError(ErrorCode::COMPRESSION_ERROR, "Invalid header block.");
+    }
+    headerBlock.clear();
+    std::optional<Priority> priority = std::exchange(headerPriority, std::nullopt);
+
+    // Trailers of an open stream, accepted and ignored
+    if(auto it = streams.find(streamId); it != streams.end()) {
+        Stream& stream = *it->second;
+        if(stream.remoteClosed) {
+            resetStream(streamId, ErrorCode::STREAM_CLOSED);
+        }
+        else if(!endStream) {
+            resetStream(streamId, ErrorCode::PROTOCOL_ERROR);
+        }
+        else {
+            stream.remoteClosed = true;
+            completeRequest(stream);
+        }
+        return;
+    }
+
+    if((streamId & 1) == 0 || streamId <= lastStreamId) {
+        throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "Invalid stream id " + std::to_string(streamId) + ".");
+    }
+    lastStreamId = streamId;
+    if(goawaySent) return; // Not processed, the client may retry it on a new connection
+    if(streams.size() >= MAX_CONCURRENT_STREAMS) {
+        resetStream(streamId, ErrorCode::REFUSED_STREAM);
+        return;
+    }
+
+    auto created = std::make_unique<Stream>();
+    created->id = streamId;
+    created->fields = std::move(fields);
+    created->sendWindow = peerInitialWindow;
+    created->receiveWindow = LOCAL_STREAM_WINDOW;
+    Stream& stream = *streams.emplace(streamId, std::move(created)).first->second;
+
+    if(priority) {
+        if(priority->dependency == streamId) {
+            resetStream(streamId, ErrorCode::PROTOCOL_ERROR); // A stream cannot depend on itself
+            return;
+        }
+        setPriority(stream, *priority);
+    }
+
+    // Stop taking new streams once the connection served its share, like MAX_KEEP_ALIVE_REQUESTS
+    if(++streamCount >= MAX_STREAMS_PER_CONNECTION) goAway(ErrorCode::NO_ERROR);
+
+    // Multipart bodies are parsed as the DATA frames arrive
+    for(const auto& [name, value] : stream.fields) {
+        if(name != "content-type") continue;
+        if(auto boundary = MultipartParser::boundaryFromContentType(value)) {
+            stream.multipart = std::make_unique<MultipartParser>(*boundary);
+        }
+    }
+
+    if(endStream) {
+        stream.remoteClosed = true;
+        completeRequest(stream);
+    }
+}
+
+/**
+ * @brief Handles a PRIORITY frame. Priorities of streams we do not track are ignored.
+ */
+void Http2Session::handlePriority(const FrameHeader& header, std::string_view payload) {
+    if(header.streamId == 0) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "PRIORITY on stream 0.");
+    if(payload.size() != 5) {
+        resetStream(header.streamId, ErrorCode::FRAME_SIZE_ERROR);
+        return;
+    }
+
+    Priority priority = parsePriority(payload);
+    if(priority.dependency == header.streamId) {
+        resetStream(header.streamId, ErrorCode::PROTOCOL_ERROR);
+        return;
+    }
+    if(auto it = streams.find(header.streamId); it != streams.end()) {
+        setPriority(*it->second, priority);
+    }
+}
+
+/**
+ * @brief Handles a RST_STREAM frame, the client cancelled a stream.
+ */
+void Http2Session::handleRstStream(const FrameHeader& header, std::string_view payload) {
+    if(payload.size() != 4) throw ConnectionError(ErrorCode::FRAME_SIZE_ERROR, "RST_STREAM must be 4 bytes.");
+    if(header.streamId == 0 || header.streamId > lastStreamId) {
+        throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "RST_STREAM on an idle stream.");
+    }
+    Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] {
+        return "HTTP/2 stream " + std::to_string(header.streamId) + " reset by the client, error " +
+               std::to_string(readUint32(payload, 0)) + ".";
+    });
+    closeStream(header.streamId);
+}
+
+/**
+ * @brief Handles a SETTINGS frame and acknowledges it.
+ */
+void Http2Session::handleSettings(const FrameHeader& header, std::string_view payload) {
+    if(header.streamId != 0) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "SETTINGS on a stream.");
+    if(header.flags & ACK) {
+        if(!payload.empty()) throw ConnectionError(ErrorCode::FRAME_SIZE_ERROR, "SETTINGS ACK with a payload.");
+        return;
+    }
+    if(payload.size() % 6 != 0) throw ConnectionError(ErrorCode::FRAME_SIZE_ERROR, "SETTINGS length is not a multiple of 6.");
+
+    applySettings(payload);
+    queueFrame(FrameType::SETTINGS, ACK, 0, {});
+}
+
+/**
+ * @brief Handles a PING frame, answering it with the same payload.
+ */
+void Http2Session::handlePing(const FrameHeader& header, std::string_view payload) {
+    if(payload.size() != 8) throw ConnectionError(ErrorCode::FRAME_SIZE_ERROR, "PING must be 8 bytes.");
+    if(header.streamId != 0) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "PING on a stream.");
+    if(!(header.flags & ACK)) queueFrame(FrameType::PING, ACK, 0, payload);
+}
+
+/**
+ * @brief Handles a WINDOW_UPDATE frame, the client is ready for more DATA.
+ */
+void Http2Session::handleWindowUpdate(const FrameHeader& header, std::string_view payload) {
+    if(payload.size() != 4) throw ConnectionError(ErrorCode::FRAME_SIZE_ERROR, "WINDOW_UPDATE must be 4 bytes.");
+    uint32_t increment = readUint32(payload, 0) & MAX_WINDOW_SIZE;
+
+    if(header.streamId == 0) {
+        if(increment == 0) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "WINDOW_UPDATE of 0.");
+        connectionSendWindow += increment;
+        if(connectionSendWindow > MAX_WINDOW_SIZE) {
+            throw ConnectionError(ErrorCode::FLOW_CONTROL_ERROR, "Connection window overflow.");
+        }
+        return;
+    }
+
+    auto it = streams.find(header.streamId);
+    if(it == streams.end()) {
+        if(header.streamId > lastStreamId) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "WINDOW_UPDATE on an idle stream.");
+        return; // Closed streams may still receive updates
+    }
+    if(increment == 0) {
+        resetStream(header.streamId, ErrorCode::PROTOCOL_ERROR);
+        return;
+    }
+    it->second->sendWindow += increment;
+    if(it->second->sendWindow > MAX_WINDOW_SIZE) {
+        resetStream(header.streamId, ErrorCode::FLOW_CONTROL_ERROR);
+    }
+}
+
+// Helpers //
+
+/**
+ * @brief Strips the padding of a DATA or HEADERS frame.
+ * @return The payload without the pad length byte and the padding.
+ * @throws ConnectionError if the padding is longer than the payload.
+ */
+std::string_view Http2Session::removePadding(const FrameHeader& header, std::string_view payload) {
+    if(!(header.flags & PADDED)) return payload;
+    if(payload.empty()) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "Padded frame without a pad length.");
+
+    size_t padding = static_cast<uint8_t>(payload[0]);
+    if(padding >= payload.size()) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "Padding exceeds the frame.");
+    return payload.substr(1, payload.size() - 1 - padding);
+}
+
+/**
+ * @brief Parses the 5-byte priority fields of a HEADERS or PRIORITY frame.
+ */
+Http2Session::Priority Http2Session::parsePriority(std::string_view payload) noexcept {
+    uint32_t dependency = readUint32(payload, 0);
+    Priority priority;
+    priority.exclusive = (dependency >> 31) != 0;
+    priority.dependency = dependency & MAX_WINDOW_SIZE;
+    priority.weight = static_cast<uint16_t>(static_cast<uint8_t>(payload[4]) + 1);
+    return priority;
+}
+
+/**
+ * @brief Queues the server preface: our SETTINGS and the larger connection window.
+ */
+void Http2Session::queuePreface() {
+    std::string settings;
+    appendSetting(settings, static_cast<uint16_t>(Setting::MAX_CONCURRENT_STREAMS), MAX_CONCURRENT_STREAMS);
+    appendSetting(settings, static_cast<uint16_t>(Setting::INITIAL_WINDOW_SIZE), LOCAL_STREAM_WINDOW);
+    appendSetting(settings, static_cast<uint16_t>(Setting::MAX_HEADER_LIST_SIZE), MAX_HEADER_LIST_SIZE);
+    queueFrame(FrameType::SETTINGS, 0, 0, settings);
+
+    std::string increment;
+    appendUint32(increment, LOCAL_CONNECTION_WINDOW - DEFAULT_WINDOW_SIZE);
+    queueFrame(FrameType::WINDOW_UPDATE, 0, 0, increment);
+    connectionReceiveWindow = LOCAL_CONNECTION_WINDOW;
+}
+
+/**
+ * @brief Applies the peer's settings.
+ * @details The header table size is irrelevant, the encoder never uses the dynamic table.
+ * @param payload Settings as 6-byte identifier/value pairs.
+ * @throws ConnectionError if a value is out of range.
+ */
+void Http2Session::applySettings(std::string_view payload) {
+    for(size_t pos = 0; pos + 6 <= payload.size(); pos += 6) {
+        uint16_t id = readUint16(payload, pos);
+        uint32_t value = readUint32(payload, pos + 2);
+
+        switch(static_cast<Setting>(id)) {
+            case Setting::ENABLE_PUSH:
+                if(value > 1) throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "Invalid SETTINGS_ENABLE_PUSH.");
+                break;
+            case Setting::INITIAL_WINDOW_SIZE: {
+                if(value > MAX_WINDOW_SIZE) throw ConnectionError(ErrorCode::FLOW_CONTROL_ERROR, "Invalid SETTINGS_INITIAL_WINDOW_SIZE.");
+                // The change applies to every open stream, and may make windows negative
+                int64_t delta = static_cast<int64_t>(value) - peerInitialWindow;
+                for(auto& [streamId, stream] : streams) {
+                    stream->sendWindow += delta;
+                    if(stream->sendWindow > MAX_WINDOW_SIZE) {
+                        throw ConnectionError(ErrorCode::FLOW_CONTROL_ERROR, "Stream window overflow.");
+                    }
+                }
+                peerInitialWindow = value;
+                break;
+            }
+            case Setting::MAX_FRAME_SIZE:
+                if(value < LOCAL_MAX_FRAME_SIZE || value > 0xffffff) {
+                    throw ConnectionError(ErrorCode::PROTOCOL_ERROR, "Invalid SETTINGS_MAX_FRAME_SIZE.");
+                }
+                peerMaxFrameSize = value;
+                break;
+            default:
+                break; // Unknown settings are ignored
+        }
+    }
+}
+
+/**
+ * @brief Moves a stream in the dependency tree.
+ * @details Follows the reprioritization rules: a stream made dependent on one of its own
+ * descendants first swaps places with it, and an exclusive dependency adopts the new parent's
+ * other children. Dependencies on streams that are not open fall back to the root.
+ * @param stream The stream to move.
+ * @param priority The new dependency and weight.
+ */
+void Http2Session::setPriority(Stream& stream, const Priority& priority) {
+    uint32_t dependency = streams.count(priority.dependency) ? priority.dependency : 0;
+
+    if(dependency != 0) {
+        // Walk up from the new parent, bounded in case the tree was corrupted
+        uint32_t ancestor = dependency;
+        for(size_t steps = 0; ancestor != 0 && steps <= streams.size(); ++steps) {
+            if(ancestor == stream.id) {
+                streams[dependency]->parent = stream.parent;
+                break;
+            }
+            auto it = streams.find(ancestor);
+            ancestor = (it != streams.end()) ? it->second->parent : 0;
+        }
+    }
+
+    if(priority.exclusive) {
+        for(auto& [streamId, other] : streams) {
+            if(other->parent == dependency && streamId != stream.id) other->parent = stream.id;
+        }
+    }
+    stream.parent = dependency;
+    stream.weight = priority.weight;
+}
+
+/**
+ * @brief Collects request body bytes, streaming multipart bodies through their parser.
+ * @param stream The stream.
+ * @param data The DATA payload without padding.
+ */
+void Http2Session::appendBody(Stream& stream, std::string_view data) {
+    stream.received += data.size();
+    if(stream.malformed || stream.tooLarge) return;
+
+    if(stream.multipart) {
+        if(stream.received > MAX_UPLOAD_SIZE) stream.tooLarge = true;
+        else if(!stream.multipart->feed(data)) stream.malformed = true;
+        return;
+    }
+    if(stream.received > MAX_BODY_SIZE) {
+        stream.tooLarge = true;
+        std::string().swap(stream.body);
+        return;
+    }
+    stream.body.append(data);
+}
+
+/**
+ * @brief Charges received DATA against the receive windows and replenishes them.
+ * @details Windows are topped up with WINDOW_UPDATE once half of them is consumed, so a
+ * client uploading a body never stalls while the server keeps up.
+ * @param stream The stream the DATA belongs to, or `nullptr` if it is no longer read.
+ * @param length The frame payload length.
+ * @param endStream `true` if the frame ends the stream, whose window then no longer matters.
+ * @return `false` if the stream was reset for exceeding its window.
+ * @throws ConnectionError if the connection window was exceeded.
+ */
+bool Http2Session::consumeWindow(Stream* stream, size_t length, bool endStream) {
+    if(length == 0) return true;
+
+    connectionReceiveWindow -= static_cast<int64_t>(length);
+    if(connectionReceiveWindow < 0) throw ConnectionError(ErrorCode::FLOW_CONTROL_ERROR, "Connection window exceeded.");
+    connectionUnacknowledged += static_cast<uint32_t>(length);
+    if(connectionUnacknowledged >= LOCAL_CONNECTION_WINDOW / 2) {
+        std::string increment;
+        appendUint32(increment, connectionUnacknowledged);
+        queueFrame(FrameType::WINDOW_UPDATE, 0, 0, increment);
+        connectionReceiveWindow += connectionUnacknowledged;
+        connectionUnacknowledged = 0;
+    }
+
+    if(stream == nullptr) return true;
+    stream->receiveWindow -= static_cast<int64_t>(length);
+    if(stream->receiveWindow < 0) {
+        resetStream(stream->id, ErrorCode::FLOW_CONTROL_ERROR);
+        return false;
+    }
+    stream->unacknowledged += static_cast<uint32_t>(length);
+    if(!endStream && !stream->tooLarge && stream->unacknowledged >= LOCAL_STREAM_WINDOW / 2) { // A 413 upload gets no more window
+        std::string increment;
+        appendUint32(increment, stream->unacknowledged);
+        queueFrame(FrameType::WINDOW_UPDATE, 0, stream->id, increment);
+        stream->receiveWindow += stream->unacknowledged;
+        stream->unacknowledged = 0;
+    }
+    return true;
+}
+
+// Requests //
+
+/**
+ * @brief Turns a complete stream into an HttpRequest and answers it.
+ * @details Pseudo-headers become the start line; repeated fields are joined as HTTP/1.1
+ * would have sent them, cookies with "; ". Malformed requests are reset, as the protocol
+ * requires, rather than answered.
+ * @param stream The stream whose request is complete.
+ */
+void Http2Session::completeRequest(Stream& stream) {
+    if(stream.malformed) {
+        respondWithError(stream, http::status::Code::BAD_REQUEST, false);
+        return;
+    }
+
+    HttpRequest request;
+    request.setVersion("HTTP/2");
+    std::string_view method, path, scheme, authority;
+    bool valid = true;
+    bool regularSeen = false;
+
+    for(const auto& [name, value] : stream.fields) {
+        if(!name.empty() && name[0] == ':') {
+            if(regularSeen) valid = false; // Pseudo-headers come first
+            if(name == ":method") method = value;
+            else if(name == ":path") path = value;
+            else if(name == ":scheme") scheme = value;
+            else if(name == ":authority") authority = value;
+            else valid = false;
+            continue;
+        }
+        regularSeen = true;
+        if(isConnectionHeader(name) || std::any_of(name.begin(), name.end(), [](char c) { return c >= 'A' && c <= 'Z'; })) {
+            valid = false;
+            continue;
+        }
+
+        if(auto existing = request.getHeader(name)) {
+            std::string joined(*existing);
+            joined.append(name == "cookie" ? "; " : ", ").append(value);
+            request.setHeader(name, joined);
+        }
+        else {
+            request.setHeader(name, value);
+        }
+    }
+
+    if(!valid || method.empty() || path.empty() || scheme.empty()) {
+        Logger::getInstance().log<Logger::LogLevel::WARN>([&] {
+            return "Malformed HTTP/2 request on stream " + std::to_string(stream.id) + ".";
+        });
+        resetStream(stream.id, ErrorCode::PROTOCOL_ERROR);
+        return;
+    }
+
+    http::method::Method parsedMethod = http::method::fromString(method);
+    if(!http::method::isValid(parsedMethod)) {
+        respondWithError(stream, http::status::Code::NOT_IMPLEMENTED, false);
+        return;
+    }
+    request.setMethod(parsedMethod).setURI(path);
+    if(!authority.empty() && !request.getHeader("host")) request.setHeader("host", authority);
+
+    if(stream.multipart) {
+        if(!stream.multipart->finish()) {
+            respondWithError(stream, http::status::Code::BAD_REQUEST, false);
+            return;
+        }
+        request.setParts(std::make_shared<const MultipartParser::Parts>(stream.multipart->takeParts()));
+        stream.multipart.reset();
+    }
+    else if(!stream.body.empty()) {
+        if(!request.getHeader("content-length")) request.setHeader("content-length", std::to_string(stream.body.size()));
+        request.setBody(std::move(stream.body));
+    }
+
+    HpackDecoder::HeaderList().swap(stream.fields);
+    respond(stream, request);
+}
+
+/**
+ * @brief Builds the response with the registered builders and queues its HEADERS.
+ * @details The serialized fast path is skipped, its entries are HTTP/1.1 bytes, but the GET builder
+ * still shares the body of a cached file instead of reading it again.
+ * @param stream The stream to answer; it is closed here if the response has no body.
+ * @param request The request.
+ */
+void Http2Session::respond(Stream& stream, HttpRequest& request) {
+    auto start = std::chrono::steady_clock::now();
+    http::method::Method method = http::method::fromString(request.getMethod());
+    bool isHead = (method == http::method::Method::HEAD);
+
+    Router::Match route;
+    factory->matchRoute(request, route);
+    ResponseResult result = factory->buildResponse(request, route);
+
+    http::status::Code status;
+    if(!result.isSuccess()) {
+        status = result.getError();
+        respondWithError(stream, status, isHead);
+    }
+    else {
+        HttpResponse response = result.takeResponse();
+        status = response.getStatus();
+
+        std::string block;
+        http::hpack::encodeStatus(static_cast<int>(status), block);
+        for(const auto& [name, value] : response.getAllHeaders()) {
+            if(isConnectionHeader(name) || name == "content-length" || name == "date") continue;
+            http::hpack::encodeField(name, value, block);
+        }
+
+        size_t length;
+        if(response.getIsStatic()) {
+            const std::pmr::string& file = response.getFilePath();
+            int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat fileStat;
+            if(fd < 0 || (!response.getContentLength() && ::fstat(fd, &fileStat) < 0)) {
+                Logger::getInstance().log("Failed to open static file: " + std::string(file) + ", error: " + std::strerror(errno), Logger::LogLevel::ERROR);
+                if(fd >= 0) ::close(fd);
+                respondWithError(stream, http::status::Code::INTERNAL_SERVER_ERROR, isHead);
+                Metrics::getInstance().recordRequest(method, http::status::Code::INTERNAL_SERVER_ERROR);
+                return;
+            }
+            length = response.getContentLength().value_or(static_cast<size_t>(fileStat.st_size));
+            stream.fileFd = fd;
+            stream.fileRemaining = length;
+        }
+        else {
+            stream.responseBody = response.getBodyBuffer();
+            length = response.getContentLength().value_or(stream.responseBody.size());
+        }
+        http::hpack::encodeField("content-length", std::to_string(length), block);
+        http::hpack::encodeField("date", Clock::getInstance().getHttpDate(), block);
+
+        if(Logger::getInstance().isEnabled(Logger::LogLevel::DEBUG)) response.display();
+        sendHeaders(stream, block, stream.pending() == 0);
+    }
+
+    Metrics::getInstance().recordRequest(method, status);
+    Metrics::getInstance().observe(Metrics::Histogram::REQUEST_DURATION, std::chrono::steady_clock::now() - start);
+}
+
+/**
+ * @brief Answers a stream with the composer's prebuilt error body.
+ * @param stream The stream to answer.
+ * @param code The HTTP status code.
+ * @param omitBody `true` to send only the headers, as a reply to HEAD.
+ */
+void Http2Session::respondWithError(Stream& stream, http::status::Code code, bool omitBody) {
+    const ResponseComposer::PrebuiltResponse& prebuilt = composer->getErrorResponse(code);
+
+    std::string block;
+    http::hpack::encodeStatus(static_cast<int>(code), block);
+    http::hpack::encodeField("content-type", http::mime::toString(http::mime::Media::TEXT_HTML), block);
+    http::hpack::encodeField("content-length", std::to_string(prebuilt.body().size()), block);
+    http::hpack::encodeField("date", Clock::getInstance().getHttpDate(), block);
+
+    // The composer outlives the session, so the body can be sent in place
+    if(!omitBody) stream.responseBody = MessageBody(nullptr, prebuilt.body());
+    sendHeaders(stream, block, stream.pending() == 0);
+}
+
+/**
+ * @brief Queues a header block as HEADERS and CONTINUATION frames.
+ * @param stream The stream; it is closed if `endStream` is set.
+ * @param block The encoded header block.
+ * @param endStream `true` if the response has no body.
+ */
+void Http2Session::sendHeaders(Stream& stream, std::string_view block, bool endStream) {
+    uint32_t streamId = stream.id;
+    std::string_view fragment = block.substr(0, peerMaxFrameSize);
+    block.remove_prefix(fragment.size());
+    queueFrame(FrameType::HEADERS, (endStream ? END_STREAM : 0) | (block.empty() ? END_HEADERS : 0), streamId, fragment);
+
+    while(!block.empty()) {
+        fragment = block.substr(0, peerMaxFrameSize);
+        block.remove_prefix(fragment.size());
+        queueFrame(FrameType::CONTINUATION, block.empty() ? END_HEADERS : 0, streamId, fragment);
+    }
+
+    if(endStream) {
+        finishStream(stream);
+        return;
+    }
+    stream.responding = true;
+    stream.pass = virtualTime; // Start level with the streams already sending
+}
+
+// Scheduling //
+
+/**
+ * @brief Writes DATA frames for the queued responses.
+ * @details Streams are served in stride order: each frame advances the stream's pass by its
+ * length divided by the stream's weight, and the stream with the lowest pass goes next, so
+ * siblings share the connection in proportion to their weights.
+ * @return `true` if more DATA could be sent right away.
+ */
+bool Http2Session::writeData() {
+    size_t budget = WRITE_QUANTUM;
+    while(budget > 0 && connectionSendWindow > 0) {
+        Stream* stream = nextStream();
+        if(stream == nullptr) return false;
+
+        size_t length = std::min({stream->pending(), static_cast<size_t>(connectionSendWindow),
+                                  static_cast<size_t>(stream->sendWindow), static_cast<size_t>(peerMaxFrameSize)});
+        bool last = (length == stream->pending());
+        uint8_t flags = last ? END_STREAM : 0;
+
+        if(stream->fileFd >= 0) {
+            // The frame header leaves with MSG_MORE so the kernel merges it with the file data
+            queueFrameHeader(FrameType::DATA, flags, stream->id, length);
+            flush(MSG_NOSIGNAL | MSG_MORE);
+            socket.sendfile(stream->fileFd, &stream->fileOffset, length);
+            stream->fileRemaining -= length;
+        }
+        else {
+            queueFrame(FrameType::DATA, flags, stream->id, stream->responseBody.view().substr(stream->sent, length));
+            stream->sent += length;
+            if(output.size() >= FLUSH_THRESHOLD) flush();
+        }
+
+        connectionSendWindow -= static_cast<int64_t>(length);
+        stream->sendWindow -= static_cast<int64_t>(length);
+        budget -= std::min(budget, length);
+        virtualTime = stream->pass;
+        stream->pass += STRIDE * std::max<size_t>(length, 1) / stream->weight;
+        if(last) finishStream(*stream);
+    }
+    return budget == 0 && connectionSendWindow > 0 && nextStream() != nullptr;
+}
+
+/**
+ * @brief Picks the stream that sends the next DATA frame.
+ * @details A stream is eligible when it has data and window, and no ancestor in the
+ * dependency tree is able to send itself.
+ * @return The stream with the lowest pass, or `nullptr` if nothing can be sent.
+ */
+Http2Session::Stream* Http2Session::nextStream() noexcept {
+    auto canSend = [](const Stream& stream) {
+        return stream.responding && stream.sendWindow > 0 && stream.pending() > 0;
+    };
+
+    Stream* best = nullptr;
+    for(auto& [streamId, candidate] : streams) {
+        if(!canSend(*candidate)) continue;
+        if(best != nullptr && candidate->pass >= best->pass) continue;
+
+        bool blocked = false;
+        uint32_t ancestor = candidate->parent;
+        for(size_t steps = 0; ancestor != 0 && steps < streams.size(); ++steps) {
+            auto it = streams.find(ancestor);
+            if(it == streams.end()) break;
+            if(canSend(*it->second)) {
+                blocked = true;
+                break;
+            }
+            ancestor = it->second->parent;
+        }
+        if(!blocked) best = candidate.get();
+    }
+    return best;
+}
+
+/**
+ * @brief Forgets a stream whose response was sent completely.
+ * @details If the request is still being uploaded (a 413 answered early), the client is asked
+ * to stop sending it with RST_STREAM `NO_ERROR`.
+ * @param stream The stream, gone when this returns.
+ */
+void Http2Session::finishStream(Stream& stream) {
+    if(stream.remoteClosed) closeStream(stream.id);
+    else resetStream(stream.id, ErrorCode::NO_ERROR);
+}
+
+/**
+ * @brief Forgets a stream, handing its children to its parent.
+ * @param streamId The stream to close.
+ */
+void Http2Session::closeStream(uint32_t streamId) noexcept {
+    auto it = streams.find(streamId);
+    if(it == streams.end()) return;
+
+    uint32_t parent = it->second->parent;
+    for(auto& [id, stream] : streams) {
+        if(stream->parent == streamId) stream->parent = parent;
+    }
+    streams.erase(it);
+}
+
+/**
+ * @brief Resets a stream with RST_STREAM and forgets it.
+ * @param streamId The stream to reset.
+ * @param code The reason.
+ */
+void Http2Session::resetStream(uint32_t streamId, ErrorCode code) {
+    std::string payload;
+    appendUint32(payload, static_cast<uint32_t>(code));
+    queueFrame(FrameType::RST_STREAM, 0, streamId, payload);
+    closeStream(streamId);
+}
+
+/**
+ * @brief Sends GOAWAY once, naming the last stream that will be processed.
+ * @param code The reason, `NO_ERROR` for a graceful shutdown.
+ */
+void Http2Session::goAway(ErrorCode code) noexcept {
+    if(goawaySent) return;
+    goawaySent = true;
+    try {
+        std::string payload;
+        appendUint32(payload, lastStreamId);
+        appendUint32(payload, static_cast<uint32_t>(code));
+        queueFrame(FrameType::GOAWAY, 0, 0, payload);
+        flush();
+    }
+    catch(const std::exception& e) {
+        // The client is most likely gone; this is called from error paths so it must not throw
+        Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] {
+            return "Failed to send GOAWAY: " + std::string(e.what());
+        });
+    }
+}
+
+// Output //
+
+/**
+ * @brief Queues a frame for the next write.
+ */
+void Http2Session::queueFrame(FrameType type, uint8_t flags, uint32_t streamId, std::string_view payload) {
+    queueFrameHeader(type, flags, streamId, payload.size());
+    output.append(payload);
+}
+
+/**
+ * @brief Queues a frame header, the payload follows separately.
+ */
+void Http2Session::queueFrameHeader(FrameType type, uint8_t flags, uint32_t streamId, size_t length) {
+    char header[FRAME_HEADER_SIZE] = {
+        static_cast<char>(length >> 16), static_cast<char>(length >> 8), static_cast<char>(length),
+        static_cast<char>(type), static_cast<char>(flags),
+        static_cast<char>(streamId >> 24), static_cast<char>(streamId >> 16),
+        static_cast<char>(streamId >> 8), static_cast<char>(streamId)
+    };
+    output.append(header, sizeof(header));
+}
+
+/**
+ * @brief Writes every queued frame.
+ * @param flags The send flags, `MSG_MORE` when file data follows.
+ */
+void Http2Session::flush(int flags) {
+    if(output.empty()) return;
+    socket.send(output.data(), output.size(), flags);
+    output.clear();
+}
@@ -10,17 +10,38 @@
  * COP4635 Sys & Net II - Project 1
  */
 
+#include "clock.hpp"
 #include "config.hpp"
+#include "connection_handler.hpp"
 #include "http_server.hpp"
 #include "epoll_manager.hpp"
 #include "socket.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
+#include "micro_cache.hpp"
+#include "reverse_proxy.hpp"
+#include "request_timer.hpp"
 
 #include <arpa/inet.h>
 
 #include <csignal>
 #include <cstring>
 #include <stdexcept>
+#include <string>
+
+namespace {
+    /**
+     * @brief Formats a client address, IPv4 or IPv6, for the log.
+     */
+    std::string formatAddress(const sockaddr_storage& addr) {
+        char address[INET6_ADDRSTRLEN];
+        const void* raw = (addr.ss_family == AF_INET6)
+            ? static_cast<const void*>(&reinterpret_cast<const sockaddr_in6*>(&addr)->sin6_addr)
+            : static_cast<const void*>(&reinterpret_cast<const sockaddr_in*>(&addr)->sin_addr);
+        if(!inet_ntop(addr.ss_family, raw, address, sizeof(address))) return "unknown";
+        return address;
+    }
+}
 
 // Static instance for signal handling.
 HttpServer* HttpServer::instance = nullptr;
@@ -50,7 +71,9 @@ HttpServer::~HttpServer() noexcept {
  * socket, it accepts the connection and delegates the handling to the thread pool.
  */
 void HttpServer::start() {
-    Logger::getInstance().log("Starting server on port: " + std::to_string(Config::getInstance().getPort()), Logger::LogLevel::INFO);
+    Logger::getInstance().log<Logger::LogLevel::INFO>([] {
+        return "Starting server on port: " + std::to_string(Config::getInstance().getPort());
+    });
 
     // Register signal handlers
     registerSignals();
@@ -63,6 +86,9 @@ void HttpServer::start() {
         // Wait for incoming events on the monitored file descriptors
         auto events = epollManager->waitForEvents(500);
 
+        // Refresh the cached log/Date timestamps once per tick
+        Clock::getInstance().update();
+
         if(!running) break; // Server is shutting down
 
         // if(signal_received > 0) break; // Signal received, stop the server
@@ -85,6 +111,9 @@ void HttpServer::start() {
     resolver.reset();
     epollManager.reset();
     threadPool.reset();
+    eventLoop.reset();
+    broadcaster.reset(); // After the loop, its subscribers point at the broadcaster
+    rateLimiter.reset();
     instance = nullptr;
 }
 
@@ -103,6 +132,9 @@ void HttpServer::stop() {
 
         // Shutdown the thread pool
         if(threadPool) threadPool->shutdown();
+
+        // Close the parked connections
+        if(eventLoop) eventLoop->shutdown();
     });
 }
 
@@ -116,6 +148,13 @@ void HttpServer::registerSignals() {
     sa.sa_flags = 0; // Disable SA_RESTART to prevent interrupted system calls
     sigaction(SIGINT, &sa, nullptr);
     sigaction(SIGTERM, &sa, nullptr);
+
+    // sendfile() has no MSG_NOSIGNAL, so a client closing mid-transfer would kill the process
+    struct sigaction ignore;
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&ignore.sa_mask);
+    ignore.sa_flags = 0;
+    sigaction(SIGPIPE, &ignore, nullptr);
 }
 
 /**
@@ -138,21 +177,59 @@ void HttpServer::setupDependencies() {
     factory = std::make_shared<ResponseBuilderFactory>();
     composer = std::make_shared<ResponseComposer>();
     resolver = std::make_shared<FileResolver>();
+    responseCache = std::make_shared<ResponseCache>(Config::getInstance().getResponseCacheBytes());
+    const Config& config = Config::getInstance();
+    rateLimiter = std::make_shared<RateLimiter>(RateLimiter::Limit{ config.getConnectionRate(), config.getConnectionBurst() },
+                                                RateLimiter::Limit{ config.getRequestRate(), config.getRequestBurst() });
+
+    // Create the event loop for upgraded connections and event streams
+    eventLoop = std::make_shared<EventLoop>();
+    broadcaster = std::make_shared<SseBroadcaster>(eventLoop);
 
     // Register response builders
-    factory->registerBuilder(http::method::Method::GET, [this]() {
-        return std::make_unique<GetResponseBuilder>(resolver, composer);
-    });
-    factory->registerBuilder(http::method::Method::POST, [this]() {
-        return std::make_unique<PostResponseBuilder>(composer);
-    });
+    factory->registerBuilder(http::method::Method::GET, std::make_unique<GetResponseBuilder>(resolver, composer, responseCache));
+    factory->registerBuilder(http::method::Method::HEAD, std::make_unique<HeadResponseBuilder>(resolver, composer, responseCache));
+
+    // Dynamic builders opt into the micro-cache, when it is enabled
+    auto microCached = [](std::shared_ptr<const ResponseBuilder> builder) -> std::shared_ptr<const ResponseBuilder> {
+        const Config& config = Config::getInstance();
+        if(config.getMicroCacheTtlMs() <= 0) return builder;
+        MicroCache::Options options;
+        options.ttl = std::chrono::milliseconds(config.getMicroCacheTtlMs());
+        options.staleWhileRevalidate = std::chrono::milliseconds(config.getMicroCacheStaleMs());
+        options.varyHeaders = config.getMicroCacheVary();
+        return std::make_shared<const MicroCache>(std::move(builder), std::move(options));
+    };
+
+    // Register dynamic routes, these are matched before the method builders
+    factory->registerRoute(http::method::Method::POST, "/submit", microCached(std::make_shared<PostResponseBuilder>(composer)));
+    factory->registerRoute(http::method::Method::GET, Config::getInstance().getMetricsPath(), std::make_unique<MetricsResponseBuilder>());
+    factory->registerRoute(http::method::Method::POST, Config::getInstance().getEventsPath(), std::make_unique<SsePublishResponseBuilder>(broadcaster));
+
+    // Register reverse proxy routes, one proxy serves the prefix and everything below it
+    auto balance = ReverseProxy::balanceFromString(Config::getInstance().getProxyBalance());
+    for(const ProxyRoute& proxyRoute : Config::getInstance().getProxyRoutes()) {
+        auto proxy = std::make_shared<const ReverseProxy>(proxyRoute.upstreams, balance);
+        std::vector<std::string> patterns;
+        if(proxyRoute.prefix != "/") patterns.push_back(proxyRoute.prefix);
+        patterns.push_back(((proxyRoute.prefix == "/") ? "" : proxyRoute.prefix) + "/*path");
+
+        for(const std::string& pattern : patterns) {
+            for(auto method : {http::method::Method::GET, http::method::Method::HEAD, http::method::Method::POST,
+                               http::method::Method::PUT, http::method::Method::DELETE, http::method::Method::OPTIONS}) {
+                factory->registerRoute(method, pattern, proxy);
+            }
+        }
+        Logger::getInstance().log("Proxying " + proxyRoute.prefix + " to " + std::to_string(proxyRoute.upstreams.size()) + " upstream(s).", Logger::LogLevel::INFO);
+    }
 
     // Create the Epoll manager
     epollManager = std::make_unique<EpollManager>();
     
     // Create the thread pool
     size_t threadCount = Config::getInstance().getThreadCount(); 
-    threadPool = std::make_unique<ThreadPool>(threadCount, factory, composer);
+    threadPool = std::make_unique<ThreadPool>(threadCount, factory, composer, responseCache, eventLoop, broadcaster, rateLimiter,
+                                              std::chrono::milliseconds(Config::getInstance().getQueueTargetMs()));
 
     Logger::getInstance().log("Server dependencies initialized.", Logger::LogLevel::INFO);
 }
@@ -196,9 +273,11 @@ void HttpServer::setupServerSocket() {
 void HttpServer::acceptConnections() {
     while(running) {
         // Set up client address struct and accept the connection
-        struct sockaddr_in client_addr;
+        struct sockaddr_storage client_addr;
         socklen_t client_addrlen = sizeof(client_addr);
         int client_fd = accept(socket->get(), (struct sockaddr*)&client_addr, &client_addrlen);
+        RequestTimer timer;
+        timer.mark(RequestTimer::Phase::ACCEPTED);
         
         if(!running) break; // Server is shutting down
         
@@ -213,11 +292,25 @@ void HttpServer::acceptConnections() {
         }
         
         // Create a new client socket and set it to non-blocking mode
-        Logger::getInstance().log("Accepted connection from: " + std::string(inet_ntoa(client_addr.sin_addr)), Logger::LogLevel::DEBUG);
+        Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] {
+            return "Accepted connection from: " + formatAddress(client_addr);
+        });
+        Metrics::getInstance().increment(Metrics::Counter::CONNECTIONS_ACCEPTED);
+
+        // Turn away clients that open connections faster than allowed, before they take a worker
+        if(!rateLimiter->allowConnection(RateLimiter::clientKey(client_addr, client_addrlen))) {
+            Logger::getInstance().log<Logger::LogLevel::DEBUG>([&] {
+                return "Rate limited connection from: " + formatAddress(client_addr);
+            });
+            Metrics::getInstance().increment(Metrics::Counter::RATE_LIMITED_CONNECTIONS);
+            Socket rejected(client_fd);
+            ConnectionHandler::reject(rejected, *composer, http::status::Code::TOO_MANY_REQUESTS);
+            continue;
+        }
         auto client_socket = std::make_unique<Socket>(client_fd);
         client_socket->setNonBlocking(true);
 
         // Delegate the connection to the thread pool
-        threadPool->enqueue(std::move(client_socket));
+        threadPool->enqueue(std::move(client_socket), timer);
     }
 }
\ No newline at end of file
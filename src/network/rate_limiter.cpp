@@ -0,0 +1,215 @@
+/**
+ * @file rate_limiter.cpp
+ * @brief This file contains the definition of the RateLimiter class.
+ * @details The rate limiter keeps one connection and one request token bucket per client
+ * address. Buckets live in a fixed, sharded open-addressing table whose slots are updated with
+ * compare-and-swap, so neither the accept loop nor the workers ever take a lock to check them.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "rate_limiter.hpp"
+
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    constexpr size_t PROBE_LIMIT = 8; // Slots looked at per lookup, four cache lines
+
+    /**
+     * @brief Spreads a client key over the table (the splitmix64 finalizer).
+     */
+    uint64_t mix(uint64_t value) noexcept {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    /**
+     * @brief Checks a limit from the command line.
+     * @throws std::invalid_argument if an enabled limit has a burst outside [1, MAX_BURST].
+     */
+    RateLimiter::Limit validate(RateLimiter::Limit limit) {
+        if(limit.perSecond < 0) throw std::invalid_argument("Rate limits must be 0 or greater.");
+        if(limit.perSecond > 0 && (limit.burst < 1 || limit.burst > RateLimiter::MAX_BURST)) {
+            throw std::invalid_argument("Rate limit bursts must be between 1 and " + std::to_string(RateLimiter::MAX_BURST) + ".");
+        }
+        return limit;
+    }
+}
+
+// Constructors //
+
+/**
+ * @brief Constructs a new RateLimiter object.
+ * @param connections New connections allowed per client.
+ * @param requests Requests allowed per client.
+ * @throws std::invalid_argument if a limit is out of range.
+ */
+RateLimiter::RateLimiter(Limit connections, Limit requests)
+    : connections(validate(connections)), requests(validate(requests)),
+      epoch(std::chrono::steady_clock::now()), shards(std::make_unique<Shard[]>(SHARD_COUNT)) {}
+
+// Functions //
+
+/**
+ * @brief Takes a connection token for a client.
+ * @param client The client key, see `clientKey`.
+ * @return `false` if the client opens connections faster than allowed.
+ */
+bool RateLimiter::allowConnection(uint64_t client) noexcept {
+    if(!limitsConnections()) return true;
+    uint64_t now = nowMs();
+    Slot* slot = findSlot(client, now);
+    return !slot || take(slot->connectionBucket, connections, now);
+}
+
+/**
+ * @brief Takes a request token for a client.
+ * @param client The client key, see `clientKey`.
+ * @return `false` if the client sends requests faster than allowed.
+ */
+bool RateLimiter::allowRequest(uint64_t client) noexcept {
+    if(!limitsRequests()) return true;
+    uint64_t now = nowMs();
+    Slot* slot = findSlot(client, now);
+    return !slot || take(slot->requestBucket, requests, now);
+}
+
+/**
+ * @brief Derives the key a client is limited by from its address.
+ * @details IPv4 clients are keyed by address. IPv6 clients are keyed by their /64 prefix, since
+ * a single host usually holds the whole prefix; IPv4-mapped addresses count as IPv4.
+ * @param address The client address.
+ * @param length The length of `address`.
+ * @return The key, never 0.
+ */
+uint64_t RateLimiter::clientKey(const sockaddr_storage& address, socklen_t length) noexcept {
+    if(address.ss_family == AF_INET && length >= sizeof(sockaddr_in)) {
+        const auto& ipv4 = reinterpret_cast<const sockaddr_in&>(address);
+        return (uint64_t{1} << 32) | ntohl(ipv4.sin_addr.s_addr);
+    }
+    if(address.ss_family == AF_INET6 && length >= sizeof(sockaddr_in6)) {
+        const auto& ipv6 = reinterpret_cast<const sockaddr_in6&>(address);
+        if(IN6_IS_ADDR_V4MAPPED(&ipv6.sin6_addr)) {
+            uint32_t ipv4;
+            std::memcpy(&ipv4, ipv6.sin6_addr.s6_addr + 12, sizeof(ipv4));
+            return (uint64_t{1} << 32) | ntohl(ipv4);
+        }
+        uint64_t prefix;
+        std::memcpy(&prefix, ipv6.sin6_addr.s6_addr, sizeof(prefix));
+        return mix(prefix) | (uint64_t{1} << 63); // Kept apart from IPv4 keys
+    }
+    return 1; // Other families share one bucket
+}
+
+/**
+ * @brief Derives the key a connected client is limited by.
+ * @param fd The client socket.
+ * @return The key, never 0.
+ */
+uint64_t RateLimiter::clientKey(int fd) noexcept {
+    sockaddr_storage address{};
+    socklen_t length = sizeof(address);
+    if(getpeername(fd, reinterpret_cast<sockaddr*>(&address), &length) < 0) return 1;
+    return clientKey(address, length);
+}
+
+// Helpers //
+
+/**
+ * @brief Gets the time buckets are stamped with.
+ * @return Milliseconds since the limiter was created, plus one so a stamp is never 0.
+ */
+uint64_t RateLimiter::nowMs() const noexcept {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch);
+    return static_cast<uint64_t>(elapsed.count()) + 1;
+}
+
+/**
+ * @brief Finds a client's slot, claiming an empty or idle one for a new client.
+ * @details Lookups only read; claiming a slot is a single compare-and-swap on its key. Two
+ * threads adding the same client at once may briefly give it two slots, which only makes the
+ * limit slightly looser.
+ * @param client The client key.
+ * @param now The current time stamp.
+ * @return The slot, or nothing if the shard has no room.
+ */
+RateLimiter::Slot* RateLimiter::findSlot(uint64_t client, uint64_t now) noexcept {
+    uint64_t hash = mix(client);
+    Shard& shard = shards[hash % SHARD_COUNT];
+    size_t start = static_cast<size_t>(hash >> 32) % SLOTS_PER_SHARD;
+
+    Slot* idle = nullptr;
+    for(size_t i = 0; i < PROBE_LIMIT; ++i) {
+        Slot& slot = shard.slots[(start + i) % SLOTS_PER_SHARD];
+        uint64_t key = slot.key.load(std::memory_order_acquire);
+        if(key == client) return &slot;
+        if(key == EMPTY) {
+            if(slot.key.compare_exchange_strong(key, client, std::memory_order_acq_rel) || key == client) return &slot;
+            continue; // Another client took it
+        }
+        if(!idle && isIdle(slot, now)) idle = &slot;
+    }
+
+    // Reuse the slot of a client that has been quiet long enough for its buckets to refill
+    if(idle) {
+        uint64_t key = idle->key.load(std::memory_order_acquire);
+        if(isIdle(*idle, now) && idle->key.compare_exchange_strong(key, client, std::memory_order_acq_rel)) {
+            idle->connectionBucket.store(0, std::memory_order_relaxed);
+            idle->requestBucket.store(0, std::memory_order_relaxed);
+            return idle;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Checks whether a slot's buckets are full, so its client can be forgotten.
+ */
+bool RateLimiter::isIdle(const Slot& slot, uint64_t now) const noexcept {
+    return isFull(slot.connectionBucket.load(std::memory_order_relaxed), connections, now)
+        && isFull(slot.requestBucket.load(std::memory_order_relaxed), requests, now);
+}
+
+/**
+ * @brief Takes one token from a bucket, refilling it for the time since it was last touched.
+ * @param bucket The packed bucket: refill time in the high bits, thousandths of a token in the low bits.
+ * @param limit The rate and burst of the bucket.
+ * @param now The current time stamp.
+ * @return `false` if the bucket holds less than one token.
+ */
+bool RateLimiter::take(std::atomic<uint64_t>& bucket, const Limit& limit, uint64_t now) noexcept {
+    const uint64_t capacity = static_cast<uint64_t>(limit.burst) * 1000;
+    uint64_t state = bucket.load(std::memory_order_relaxed);
+    while(true) {
+        uint64_t tokens = capacity; // A zero bucket has never been used
+        if(state != 0) {
+            uint64_t stamp = state >> TOKEN_BITS;
+            uint64_t elapsed = std::min<uint64_t>((now > stamp) ? now - stamp : 0, capacity); // Tokens per ms is perSecond / 1000
+            tokens = std::min(capacity, (state & TOKEN_MASK) + elapsed * static_cast<uint64_t>(limit.perSecond));
+        }
+        if(tokens < 1000) return false;
+
+        uint64_t desired = (now << TOKEN_BITS) | (tokens - 1000);
+        if(bucket.compare_exchange_weak(state, desired, std::memory_order_relaxed)) return true;
+    }
+}
+
+/**
+ * @brief Checks whether a bucket has refilled completely.
+ */
+bool RateLimiter::isFull(uint64_t state, const Limit& limit, uint64_t now) noexcept {
+    if(state == 0 || limit.perSecond <= 0) return true;
+    const uint64_t capacity = static_cast<uint64_t>(limit.burst) * 1000;
+    uint64_t stamp = state >> TOKEN_BITS;
+    uint64_t elapsed = std::min<uint64_t>((now > stamp) ? now - stamp : 0, capacity);
+    return (state & TOKEN_MASK) + elapsed * static_cast<uint64_t>(limit.perSecond) >= capacity;
+}
@@ -0,0 +1,800 @@
+/**
+ * @file reverse_proxy.cpp
+ * @brief This file contains the definition of the ReverseProxy class.
+ * @details The reverse proxy forwards requests on its routes to a group of upstream HTTP/1.1
+ * servers. Upstream connections are kept alive in per-upstream pools, and bodies are moved
+ * between the sockets with `splice()` so they never pass through user space whole.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "n_utils.hpp"
+#include "reverse_proxy.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    constexpr size_t PIPE_CHUNK = 64 * 1024;  // Bytes moved into the pipe per splice()
+    constexpr int PIPE_SIZE = 256 * 1024;     // Room for PIPE_CHUNK even when it arrives in small segments
+    constexpr size_t MAX_CHUNK_LINE = 4096;   // Longest chunk-size or trailer line accepted
+
+    using n_utils::str_manip::hasToken;
+
+    /**
+     * @brief Compares two header names without regard to case.
+     */
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) noexcept {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
+    }
+
+    /**
+     * @brief Strips leading and trailing spaces and tabs from a header value.
+     */
+    std::string_view trimView(std::string_view value) noexcept {
+        size_t start = value.find_first_not_of(" \t");
+        if(start == std::string_view::npos) return {};
+        return value.substr(start, value.find_last_not_of(" \t") - start + 1);
+    }
+
+    /**
+     * @brief Checks for headers that only apply to one connection and are never forwarded.
+     * @note `Transfer-Encoding` is not listed, chunked responses are relayed as they are.
+     */
+    bool isHopByHop(std::string_view name) noexcept {
+        for(std::string_view hop : {"connection", "keep-alive", "proxy-connection", "te", "trailer", "upgrade"}) {
+            if(equalsIgnoreCase(name, hop)) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Waits until a socket is ready.
+     * @return `false` on timeout.
+     */
+    bool waitFor(int fd, short events, int timeout_ms) {
+        struct pollfd pfd = {fd, events, 0};
+        while(true) {
+            int ret = poll(&pfd, 1, timeout_ms);
+            if(ret < 0 && errno == EINTR) continue;
+            return ret > 0; // Errors and hang-ups count as ready, the next call reports them
+        }
+    }
+
+    /**
+     * @brief Sends every byte of the buffers, waiting whenever the socket is full.
+     * @return `false` if the peer failed or stopped taking bytes for `timeout_ms`.
+     */
+    bool sendAll(int fd, struct iovec* iov, int count, int timeout_ms) {
+        while(count > 0 && iov->iov_len == 0) { ++iov; --count; }
+        while(count > 0) {
+            struct msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = static_cast<size_t>(count);
+            ssize_t bytesSent = ::sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if(bytesSent < 0) {
+                if(errno == EINTR) continue;
+                if(errno != EAGAIN && errno != EWOULDBLOCK) return false;
+                if(!waitFor(fd, POLLOUT, timeout_ms)) return false;
+                continue;
+            }
+
+            size_t left = static_cast<size_t>(bytesSent);
+            while(count > 0 && left >= iov->iov_len) {
+                left -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if(count > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+                iov->iov_len -= left;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief A non-blocking pipe that `splice()` moves bytes through, one per worker thread.
+     */
+    class Pipe {
+    public:
+        Pipe() { open(); }
+        ~Pipe() { close(); }
+        Pipe(const Pipe&) = delete;
+        Pipe& operator=(const Pipe&) = delete;
+
+        bool valid() const noexcept { return fds[0] >= 0; }
+        int readEnd() const noexcept { return fds[0]; }
+        int writeEnd() const noexcept { return fds[1]; }
+
+        /**
+         * @brief Replaces the pipe, dropping bytes a failed transfer left behind.
+         */
+        void reset() {
+            close();
+            open();
+        }
+
+    private:
+        int fds[2] = {-1, -1};
+
+        void open() {
+            if(pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+                fds[0] = fds[1] = -1;
+                return;
+            }
+            fcntl(fds[1], F_SETPIPE_SZ, PIPE_SIZE); // Best effort, the default size still works
+        }
+
+        void close() {
+            for(int& fd : fds) {
+                if(fd >= 0) ::close(fd);
+                fd = -1;
+            }
+        }
+    };
+
+    Pipe& threadPipe() {
+        thread_local Pipe pipe;
+        if(!pipe.valid()) pipe.reset();
+        if(!pipe.valid()) throw std::runtime_error("Failed to create a pipe for splice(): " + std::string(std::strerror(errno)));
+        return pipe;
+    }
+
+    enum class Relay {
+        COMPLETE,       // Every requested byte was moved
+        END_OF_STREAM,  // The source closed first
+        SOURCE_FAILED,  // Reading failed or timed out
+        SINK_FAILED     // Writing failed or timed out
+    };
+
+    /**
+     * @brief Moves bytes between two sockets through the thread's pipe, without copying them to user space.
+     * @param from The socket to read from.
+     * @param to The socket to write to.
+     * @param count The number of bytes to move, or the maximum to move everything until end of stream.
+     * @param fromTimeout How long the source may stay silent, in milliseconds.
+     * @param toTimeout How long the sink may stay full, in milliseconds.
+     */
+    Relay relay(int from, int to, size_t count, int fromTimeout, int toTimeout) {
+        Pipe& pipe = threadPipe();
+        size_t buffered = 0;       // Bytes sitting in the pipe
+        bool eof = false;
+        bool pipeFull = false;     // The last splice into the pipe found no room
+
+        while(buffered > 0 || (count > 0 && !eof)) {
+            bool progressed = false;
+            pipeFull = false;
+            if(count > 0 && !eof && buffered < PIPE_CHUNK) {
+                ssize_t moved = splice(from, nullptr, pipe.writeEnd(), nullptr, std::min(count, PIPE_CHUNK - buffered),
+                                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if(moved > 0) {
+                    count -= static_cast<size_t>(moved);
+                    buffered += static_cast<size_t>(moved);
+                    progressed = true;
+                }
+                else if(moved == 0) {
+                    eof = true;
+                }
+                else if(errno == EAGAIN && buffered > 0) {
+                    pipeFull = true; // Or the socket is dry, either way the pipe has to drain first
+                }
+                else if(errno != EAGAIN && errno != EINTR) {
+                    pipe.reset();
+                    return Relay::SOURCE_FAILED;
+                }
+            }
+            if(buffered > 0) {
+                ssize_t moved = splice(pipe.readEnd(), nullptr, to, nullptr, buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if(moved > 0) {
+                    buffered -= static_cast<size_t>(moved);
+                    progressed = true;
+                }
+                else if(moved < 0 && errno != EAGAIN && errno != EINTR) {
+                    pipe.reset();
+                    return Relay::SINK_FAILED;
+                }
+            }
+            if(progressed) continue;
+
+            // Nothing moved, wait for whichever side is holding things up
+            struct pollfd pfds[2];
+            nfds_t watched = 0;
+            bool waitingOnSink = buffered > 0;
+            if(waitingOnSink) pfds[watched++] = {to, POLLOUT, 0};
+            if(count > 0 && !eof && !pipeFull && buffered < PIPE_CHUNK) pfds[watched++] = {from, POLLIN, 0};
+            if(watched == 0) break;
+
+            int ret = poll(pfds, watched, waitingOnSink ? toTimeout : fromTimeout);
+            if(ret < 0 && errno == EINTR) continue;
+            if(ret <= 0) {
+                pipe.reset();
+                return waitingOnSink ? Relay::SINK_FAILED : Relay::SOURCE_FAILED;
+            }
+        }
+        return (count > 0) ? Relay::END_OF_STREAM : Relay::COMPLETE;
+    }
+
+    /**
+     * @brief Finds the end of a chunked body without decoding it, so it can be relayed as it is.
+     */
+    class ChunkedScanner {
+    public:
+        bool done() const noexcept { return state == State::DONE; }
+        bool failed() const noexcept { return state == State::FAILED; }
+        uint64_t dataRemaining() const noexcept { return (state == State::DATA) ? remaining : 0; }
+
+        /**
+         * @brief Marks chunk data (and its trailing CRLF) as relayed.
+         */
+        void skipData(uint64_t length) noexcept {
+            remaining -= length;
+            if(remaining == 0) state = State::SIZE;
+        }
+
+        /**
+         * @brief Scans received body bytes.
+         * @return The number of bytes that belong to the body; fewer than `size` once it has ended.
+         */
+        size_t scan(const char* data, size_t size) noexcept {
+            size_t i = 0;
+            while(i < size && state != State::DONE && state != State::FAILED) {
+                if(state == State::DATA) {
+                    uint64_t length = std::min<uint64_t>(remaining, size - i);
+                    i += static_cast<size_t>(length);
+                    skipData(length);
+                    continue;
+                }
+
+                char c = data[i++];
+                if(c != '\n') {
+                    if(++lineLength > MAX_CHUNK_LINE) state = State::FAILED;
+                    else if(state == State::SIZE && inSize) addSizeDigit(c);
+                    else if(state == State::TRAILER && c != '\r') lineEmpty = false;
+                    continue;
+                }
+
+                // End of a line
+                if(state == State::SIZE) {
+                    if(digits == 0) state = State::FAILED;
+                    else if(chunkSize == 0) state = State::TRAILER;
+                    else {
+                        remaining = chunkSize + 2; // The data is followed by CRLF
+                        state = State::DATA;
+                    }
+                    chunkSize = 0;
+                    digits = 0;
+                    inSize = true;
+                }
+                else if(lineEmpty) {
+                    state = State::DONE;
+                }
+                lineLength = 0;
+                lineEmpty = true;
+            }
+            return i;
+        }
+
+    private:
+        enum class State { SIZE, DATA, TRAILER, DONE, FAILED };
+
+        State state = State::SIZE;
+        uint64_t remaining = 0;
+        uint64_t chunkSize = 0;
+        size_t digits = 0;
+        size_t lineLength = 0;
+        bool inSize = true;     // Still reading hex digits, extensions follow
+        bool lineEmpty = true;  // The trailer line so far is empty
+
+        void addSizeDigit(char c) noexcept {
+            int value = (c >= '0' && c <= '9') ? c - '0'
+                      : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                      : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+            if(value < 0) {
+                inSize = false; // ';', whitespace or CR ends the size
+                return;
+            }
+            if(++digits > 15) {
+                state = State::FAILED;
+                return;
+            }
+            chunkSize = (chunkSize << 4) | static_cast<uint64_t>(value);
+        }
+    };
+
+    /**
+     * @brief The parts of an upstream response head that decide how its body is framed.
+     */
+    struct ResponseHead {
+        int status = 0;
+        bool http11 = false;
+        bool chunked = false;
+        bool close = false;     // `Connection: close`
+        bool keepAlive = false; // `Connection: keep-alive`, needed to reuse an HTTP/1.0 upstream
+        std::optional<uint64_t> contentLength;
+        std::string_view connection;
+    };
+
+    /**
+     * @brief Parses the status line and framing headers of a response head.
+     * @param head The head, including the blank line that ends it.
+     * @return `false` if it is malformed.
+     */
+    bool parseResponseHead(std::string_view head, ResponseHead& out) {
+        if(head.size() < 12 || head.substr(0, 7) != "HTTP/1." || head[8] != ' ') return false;
+        out.http11 = (head[7] == '1');
+        out.status = 0;
+        for(size_t i = 9; i < 12; ++i) {
+            if(head[i] < '0' || head[i] > '9') return false;
+            out.status = out.status * 10 + (head[i] - '0');
+        }
+
+        size_t pos = head.find("\r\n") + 2;
+        while(pos < head.size()) {
+            size_t end = head.find("\r\n", pos);
+            if(end == pos) break; // Blank line
+            std::string_view line = head.substr(pos, end - pos);
+            pos = end + 2;
+
+            size_t colon = line.find(':');
+            if(colon == std::string_view::npos) return false;
+            std::string_view name = line.substr(0, colon);
+            std::string_view value = trimView(line.substr(colon + 1));
+            if(equalsIgnoreCase(name, "content-length")) {
+                uint64_t length = 0;
+                if(value.empty() || value.size() > 18) return false;
+                for(char c : value) {
+                    if(c < '0' || c > '9') return false;
+                    length = length * 10 + static_cast<uint64_t>(c - '0');
+                }
+                if(out.contentLength && *out.contentLength != length) return false; // Conflicting lengths
+                out.contentLength = length;
+            }
+            else if(equalsIgnoreCase(name, "transfer-encoding")) {
+                out.chunked = hasToken(value, "chunked");
+            }
+            else if(equalsIgnoreCase(name, "connection")) {
+                out.connection = value;
+                out.close = hasToken(value, "close");
+                out.keepAlive = hasToken(value, "keep-alive");
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Copies a response head for the client without its hop-by-hop headers.
+     */
+    std::string rewriteResponseHead(std::string_view head, const ResponseHead& parsed, bool keepAlive) {
+        std::string out;
+        out.reserve(head.size() + 32);
+        size_t lineEnd = head.find("\r\n");
+        out.append("HTTP/1.1").append(head.substr(8, lineEnd - 8)).append("\r\n");
+
+        size_t pos = lineEnd + 2;
+        while(pos < head.size()) {
+            size_t end = head.find("\r\n", pos);
+            if(end == pos) break;
+            std::string_view line = head.substr(pos, end - pos + 2);
+            pos = end + 2;
+
+            std::string_view name = line.substr(0, line.find(':'));
+            if(isHopByHop(name) || (!parsed.connection.empty() && hasToken(parsed.connection, name))) continue;
+            out.append(line);
+        }
+        out.append(keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
+        return out;
+    }
+}
+
+// Constructors //
+
+/**
+ * @brief Constructs a new ReverseProxy object.
+ * @param upstreams The upstream servers as `host:port`, resolved once here.
+ * @param balance How requests are spread over the upstreams.
+ * @throws std::invalid_argument if an upstream is malformed or cannot be resolved.
+ */
+ReverseProxy::ReverseProxy(const std::vector<std::string>& upstreams, Balance balance) : balance(balance) {
+    if(upstreams.empty()) throw std::invalid_argument("A proxy route needs at least one upstream.");
+
+    for(const std::string& name : upstreams) {
+        size_t colon = name.rfind(':');
+        if(colon == std::string::npos || colon == 0 || colon + 1 == name.size()) {
+            throw std::invalid_argument("Upstream must be host:port: " + name);
+        }
+        std::string host = name.substr(0, colon);
+        std::string port = name.substr(colon + 1);
+
+        struct addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo* result = nullptr;
+        if(int error = getaddrinfo(host.c_str(), port.c_str(), &hints, &result); error != 0) {
+            throw std::invalid_argument("Failed to resolve upstream " + name + ": " + gai_strerror(error));
+        }
+
+        auto upstream = std::make_unique<Upstream>();
+        upstream->name = name;
+        std::memcpy(&upstream->address, result->ai_addr, result->ai_addrlen);
+        upstream->addressLength = result->ai_addrlen;
+        freeaddrinfo(result);
+        this->upstreams.push_back(std::move(upstream));
+    }
+}
+
+// Functions //
+
+/**
+ * @brief Forwards a request and relays the upstream's response to the client.
+ * @details The head goes out with the body bytes that arrived alongside it; the rest of the body
+ * is spliced from the client as it arrives. A pooled connection that turns out to be closed is
+ * replaced as long as nothing but the head and buffered body was sent on it (and, if it closed
+ * after taking the request, only for idempotent methods; a POST gets `502`), and an upstream that
+ * cannot be reached is skipped for the next one.
+ * @param request The request, whose body has not been read.
+ * @param received The body bytes already received with the head.
+ * @param client The client socket.
+ * @param keepAlive In: the client asked to keep the connection. Out: whether it can be.
+ * @return The status sent, or the error the caller should send.
+ */
+ReverseProxy::Result ReverseProxy::forward(const HttpRequest& request, std::string_view received, const Socket& client, bool& keepAlive) const {
+    // Only bodies with a known length are streamed, chunked uploads are refused
+    if(request.getHeader("Transfer-Encoding")) {
+        keepAlive = false;
+        return Result{ http::status::Code::LENGTH_REQUIRED, false };
+    }
+    size_t contentLength = request.getContentLength().value_or(0);
+    received = received.substr(0, contentLength);
+    size_t unread = contentLength - received.size();
+
+    size_t first = pick();
+    for(size_t attempt = 0; attempt < upstreams.size();) {
+        Upstream& upstream = *upstreams[(first + attempt) % upstreams.size()];
+        Lease lease;
+        if(!acquire(upstream, lease)) {
+            Metrics::getInstance().increment(Metrics::Counter::PROXY_UPSTREAM_FAILURES);
+            Logger::getInstance().log("Failed to connect to upstream " + upstream.name + ".", Logger::LogLevel::WARN);
+            ++attempt;
+            continue;
+        }
+
+        std::string head = buildRequestHead(request, client, upstream);
+        struct iovec iov[2];
+        iov[0].iov_base = head.data();
+        iov[0].iov_len = head.size();
+        iov[1].iov_base = const_cast<char*>(received.data());
+        iov[1].iov_len = received.size();
+        if(!sendAll(lease.socket->get(), iov, 2, UPSTREAM_TIMEOUT)) {
+            Metrics::getInstance().increment(Metrics::Counter::PROXY_UPSTREAM_FAILURES);
+            if(!lease.reused) ++attempt; // A stale pooled connection does not count as an attempt
+            continue;
+        }
+
+        // Stream the rest of the body, from here on the request cannot be replayed
+        if(unread > 0) {
+            if(received.empty() && hasToken(request.getHeader("Expect").value_or(""), "100-continue")) {
+                static constexpr std::string_view CONTINUE = "HTTP/1.1 100 Continue\r\n\r\n";
+                struct iovec interim[1] = {{ const_cast<char*>(CONTINUE.data()), CONTINUE.size() }};
+                if(!sendAll(client.get(), interim, 1, CLIENT_TIMEOUT)) {
+                    keepAlive = false;
+                    return Result{ http::status::Code::BAD_REQUEST, false };
+                }
+            }
+            Relay result = relay(client.get(), lease.socket->get(), unread, CLIENT_TIMEOUT, UPSTREAM_TIMEOUT);
+            if(result != Relay::COMPLETE) {
+                keepAlive = false;
+                if(result != Relay::SINK_FAILED) return Result{ http::status::Code::BAD_REQUEST, false };
+                Metrics::getInstance().increment(Metrics::Counter::PROXY_UPSTREAM_FAILURES);
+                return Result{ http::status::Code::BAD_GATEWAY, false };
+            }
+        }
+
+        bool reusable = false;
+        bool retry = false;
+        Result result = relayResponse(request, lease, client, keepAlive, reusable, retry);
+        // The pooled connection was closed before it answered; the upstream may still have acted
+        // on the request, so only idempotent ones are sent again
+        if(retry && unread == 0 && http::method::isIdempotent(http::method::fromString(request.getMethod()))) continue;
+        if(!result.responded) Metrics::getInstance().increment(Metrics::Counter::PROXY_UPSTREAM_FAILURES);
+        release(lease, reusable);
+        return result;
+    }
+    return Result{ http::status::Code::BAD_GATEWAY, false };
+}
+
+/**
+ * @brief Parses a balancing policy name.
+ * @param name `round-robin` (or `rr`), or `least-conn` (or `lc`).
+ * @return The policy.
+ * @throws std::invalid_argument if the name is unknown.
+ */
+ReverseProxy::Balance ReverseProxy::balanceFromString(std::string_view name) {
+    if(name == "round-robin" || name == "rr") return Balance::ROUND_ROBIN;
+    if(name == "least-conn" || name == "lc") return Balance::LEAST_CONNECTIONS;
+    throw std::invalid_argument("Unknown balancing policy: " + std::string(name));
+}
+
+// Overrides //
+
+/**
+ * @brief Refuses requests that do not come through `forward`.
+ * @details Proxying streams over the client connection, which HTTP/2 streams do not own.
+ * @param request The request.
+ * @return `505 HTTP Version Not Supported`.
+ */
+ResponseResult ReverseProxy::buildResponse(const HttpRequest& request) const {
+    (void)request;
+    return ResponseResult{ http::status::Code::HTTP_VERSION_NOT_SUPPORTED };
+}
+
+// Helpers //
+
+/**
+ * @brief Chooses the upstream to try first.
+ * @return An index into `upstreams`; later attempts take the following ones in turn.
+ */
+size_t ReverseProxy::pick() const {
+    size_t count = upstreams.size();
+    size_t start = next.fetch_add(1, std::memory_order_relaxed) % count;
+    if(balance == Balance::ROUND_ROBIN) return start;
+
+    // Least connections, ties go round-robin so idle upstreams share the load
+    size_t best = start;
+    for(size_t i = 1; i < count; ++i) {
+        size_t index = (start + i) % count;
+        if(upstreams[index]->active.load(std::memory_order_relaxed) < upstreams[best]->active.load(std::memory_order_relaxed)) {
+            best = index;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Checks out a pooled connection to an upstream, or opens a new one.
+ * @param upstream The upstream.
+ * @param lease Receives the connection.
+ * @return `false` if no connection could be made.
+ */
+bool ReverseProxy::acquire(Upstream& upstream, Lease& lease) const {
+    auto now = std::chrono::steady_clock::now();
+    while(true) {
+        IdleConnection idle;
+        {
+            std::lock_guard<std::mutex> lock(upstream.mutex);
+            if(upstream.idle.empty()) break;
+            idle = std::move(upstream.idle.back());
+            upstream.idle.pop_back();
+        }
+        if(now - idle.since > IDLE_TIMEOUT) continue;
+
+        // An idle connection that is readable was closed by the upstream (or sent something unasked)
+        char probe;
+        ssize_t peeked = ::recv(idle.socket->get(), &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+        if(!(peeked < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) continue;
+
+        lease.socket = std::move(idle.socket);
+        lease.reused = true;
+        break;
+    }
+
+    if(lease.socket) {
+        Metrics::getInstance().increment(Metrics::Counter::PROXY_UPSTREAM_REUSED);
+    }
+    else {
+        int fd = ::socket(upstream.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(fd < 0) return false;
+        auto socket = std::make_unique<Socket>(fd);
+
+        if(::connect(fd, reinterpret_cast<const sockaddr*>(&upstream.address), upstream.addressLength) < 0) {
+            if(errno != EINPROGRESS || !waitFor(fd, POLLOUT, CONNECT_TIMEOUT)) return false;
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if(getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) return false;
+        }
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay)); // Heads are small writes
+        Metrics::getInstance().increment(Metrics::Counter::PROXY_UPSTREAM_CONNECTS);
+
+        lease.socket = std::move(socket);
+        lease.reused = false;
+    }
+
+    lease.upstream = &upstream;
+    upstream.active.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Returns a connection to its upstream's pool, or closes it.
+ * @param lease The connection.
+ * @param reusable `true` if the exchange ended cleanly and the upstream keeps the connection open.
+ */
+void ReverseProxy::release(Lease& lease, bool reusable) const {
+    if(!reusable || !lease.socket) return; // Closed with the lease
+    std::lock_guard<std::mutex> lock(lease.upstream->mutex);
+    if(lease.upstream->idle.size() >= MAX_IDLE_CONNECTIONS) return;
+    lease.upstream->idle.push_back(IdleConnection{ std::move(lease.socket), std::chrono::steady_clock::now() });
+}
+
+/**
+ * @brief Builds the head of the upstream request.
+ * @details Hop-by-hop headers and `Expect` are dropped, the client address is appended to
+ * `X-Forwarded-For`, and the upstream connection is always kept alive.
+ * @param request The client's request.
+ * @param client The client socket, for its address.
+ * @param upstream The upstream, whose name is the Host when the client sent none.
+ * @return The serialized head.
+ */
+std::string ReverseProxy::buildRequestHead(const HttpRequest& request, const Socket& client, const Upstream& upstream) const {
+    std::string head;
+    head.reserve(512);
+    head.append(request.getMethod()).append(" ").append(request.getURI()).append(" HTTP/1.1\r\n");
+
+    std::string_view connection = request.getHeader("Connection").value_or("");
+    std::string forwardedFor;
+    bool hasHost = false;
+    for(const auto& [name, value] : request.getAllHeaders()) {
+        if(isHopByHop(name) || name == "expect" || name == "transfer-encoding" || hasToken(connection, name)) continue;
+        if(name == "x-forwarded-for") {
+            forwardedFor = value;
+            continue;
+        }
+        if(name == "host") hasHost = true;
+        head.append(name).append(": ").append(value).append("\r\n");
+    }
+    if(!hasHost) head.append("host: ").append(upstream.name).append("\r\n");
+
+    sockaddr_storage peer{};
+    socklen_t peerLength = sizeof(peer);
+    char address[INET6_ADDRSTRLEN] = "";
+    if(getpeername(client.get(), reinterpret_cast<sockaddr*>(&peer), &peerLength) == 0) {
+        const void* raw = (peer.ss_family == AF_INET6)
+            ? static_cast<const void*>(&reinterpret_cast<const sockaddr_in6*>(&peer)->sin6_addr)
+            : static_cast<const void*>(&reinterpret_cast<const sockaddr_in*>(&peer)->sin_addr);
+        if(!inet_ntop(peer.ss_family, raw, address, sizeof(address))) address[0] = '\0';
+    }
+    if(address[0] != '\0') {
+        if(!forwardedFor.empty()) forwardedFor.append(", ");
+        forwardedFor.append(address);
+    }
+    if(!forwardedFor.empty()) head.append("x-forwarded-for: ").append(forwardedFor).append("\r\n");
+    head.append("x-forwarded-proto: http\r\nconnection: keep-alive\r\n\r\n");
+    return head;
+}
+
+/**
+ * @brief Reads the upstream's response head and relays the response to the client.
+ * @details The head is read into a small buffer and rewritten; the body follows its framing:
+ * a Content-Length body is spliced straight through, a chunked body is spliced chunk by chunk
+ * with only the size lines passing through the buffer, and a body that ends when the upstream
+ * closes is spliced until then (the client connection closes after it).
+ * @param request The client's request.
+ * @param lease The upstream connection the request was sent on.
+ * @param client The client socket.
+ * @param keepAlive In/out: whether the client connection stays open.
+ * @param reusable Set if the upstream connection can go back to the pool.
+ * @param retry Set if a pooled connection closed before sending anything.
+ * @return The status relayed, or the error the caller should send.
+ */
+ReverseProxy::Result ReverseProxy::relayResponse(const HttpRequest& request, Lease& lease, const Socket& client, bool& keepAlive,
+                                                 bool& reusable, bool& retry) const {
+    int upstreamFd = lease.socket->get();
+    char buffer[MAX_HEAD_SIZE];
+    size_t received = 0;
+    size_t headLength = 0;
+    ResponseHead parsed;
+
+    // Read the head, skipping interim 1xx responses
+    while(true) {
+        size_t end;
+        while((end = std::string_view(buffer, received).find("\r\n\r\n")) == std::string_view::npos) {
+            if(received == sizeof(buffer)) return Result{ http::status::Code::BAD_GATEWAY, false };
+            ssize_t bytesRead = ::recv(upstreamFd, buffer + received, sizeof(buffer) - received, MSG_DONTWAIT);
+            if(bytesRead > 0) {
+                received += static_cast<size_t>(bytesRead);
+                continue;
+            }
+            if(bytesRead < 0 && errno == EINTR) continue;
+            if(bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if(!waitFor(upstreamFd, POLLIN, UPSTREAM_TIMEOUT)) return Result{ http::status::Code::GATEWAY_TIMEOUT, false };
+                continue;
+            }
+            retry = lease.reused && received == 0;
+            return Result{ http::status::Code::BAD_GATEWAY, false };
+        }
+
+        headLength = end + 4;
+        parsed = ResponseHead{};
+        if(!parseResponseHead(std::string_view(buffer, headLength), parsed)) return Result{ http::status::Code::BAD_GATEWAY, false };
+        if(parsed.status >= 200) break;
+        if(parsed.status == 101) return Result{ http::status::Code::BAD_GATEWAY, false }; // Upgrade was never forwarded
+
+        std::memmove(buffer, buffer + headLength, received - headLength);
+        received -= headLength;
+    }
+
+    auto status = static_cast<http::status::Code>(parsed.status);
+    bool bodyless = request.getMethod() == "HEAD" || parsed.status == 204 || parsed.status == 304;
+    bool delimited = bodyless || parsed.chunked || parsed.contentLength.has_value();
+    bool upstreamKeepsOpen = !parsed.close && (parsed.http11 || parsed.keepAlive);
+    if(!delimited) keepAlive = false; // The body ends when the connection does
+
+    std::string head = rewriteResponseHead(std::string_view(buffer, headLength), parsed, keepAlive);
+    std::string_view extra(buffer + headLength, received - headLength);
+    int clientFd = client.get();
+    bool complete = false;
+
+    if(bodyless) {
+        complete = extra.empty();
+        struct iovec iov[1] = {{ head.data(), head.size() }};
+        if(!sendAll(clientFd, iov, 1, CLIENT_TIMEOUT)) complete = false;
+    }
+    else if(parsed.chunked) {
+        ChunkedScanner scanner;
+        size_t used = scanner.scan(extra.data(), extra.size());
+        bool clean = (used == extra.size());
+        struct iovec iov[2] = {{ head.data(), head.size() }, { const_cast<char*>(extra.data()), used }};
+        bool ok = sendAll(clientFd, iov, 2, CLIENT_TIMEOUT);
+
+        while(ok && !scanner.done() && !scanner.failed()) {
+            if(uint64_t data = scanner.dataRemaining()) {
+                ok = relay(upstreamFd, clientFd, static_cast<size_t>(data), UPSTREAM_TIMEOUT, CLIENT_TIMEOUT) == Relay::COMPLETE;
+                scanner.skipData(data);
+                continue;
+            }
+
+            // Chunk-size lines and trailers pass through the buffer
+            ssize_t bytesRead = ::recv(upstreamFd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if(bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                ok = waitFor(upstreamFd, POLLIN, UPSTREAM_TIMEOUT);
+                continue;
+            }
+            if(bytesRead <= 0) {
+                ok = false;
+                break;
+            }
+            used = scanner.scan(buffer, static_cast<size_t>(bytesRead));
+            clean = clean && (used == static_cast<size_t>(bytesRead));
+            struct iovec chunk[1] = {{ buffer, used }};
+            ok = sendAll(clientFd, chunk, 1, CLIENT_TIMEOUT);
+        }
+        complete = ok && scanner.done() && clean;
+    }
+    else if(parsed.contentLength) {
+        uint64_t length = *parsed.contentLength;
+        size_t inline_ = static_cast<size_t>(std::min<uint64_t>(extra.size(), length));
+        struct iovec iov[2] = {{ head.data(), head.size() }, { const_cast<char*>(extra.data()), inline_ }};
+        complete = sendAll(clientFd, iov, 2, CLIENT_TIMEOUT) && extra.size() <= length;
+        if(complete && length > inline_) {
+            complete = relay(upstreamFd, clientFd, static_cast<size_t>(length - inline_), UPSTREAM_TIMEOUT, CLIENT_TIMEOUT) == Relay::COMPLETE;
+        }
+    }
+    else {
+        struct iovec iov[2] = {{ head.data(), head.size() }, { const_cast<char*>(extra.data()), extra.size() }};
+        if(sendAll(clientFd, iov, 2, CLIENT_TIMEOUT)) {
+            relay(upstreamFd, clientFd, std::numeric_limits<size_t>::max(), UPSTREAM_TIMEOUT, CLIENT_TIMEOUT);
+        }
+    }
+
+    if(!complete) keepAlive = false; // The client cannot tell where a cut-off response ends
+    reusable = complete && upstreamKeepsOpen;
+    return Result{ status, true };
+}
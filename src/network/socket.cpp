@@ -10,6 +10,7 @@
  */
 
 #include "logger.hpp"
+#include "metrics.hpp"
 #include "socket.hpp"
 
 #include <fcntl.h>
@@ -218,6 +219,56 @@ ssize_t Socket::send(const void* buf, size_t len, int flags) const {
         }
         totalSent += bytesSent;
     }
+    Metrics::getInstance().increment(Metrics::Counter::BYTES_SENT, totalSent);
+    return totalSent;
+}
+
+/**
+ * @brief Sends several buffers through the socket with a single `sendmsg()` call.
+ * @details Lets the headers and body of a response leave in one segment instead of
+ * two small writes (which interact badly with Nagle's algorithm and delayed ACKs).
+ * @param iov The buffers to send. Entries are advanced in place on partial writes.
+ * @param iovcnt The number of buffers.
+ * @param flags The flags to use for the send operation.
+ * @return The number of bytes sent.
+ * @throws std::runtime_error if the data cannot be sent or timeout occurs.
+ */
+ssize_t Socket::sendv(struct iovec* iov, int iovcnt, int flags) const {
+    size_t totalSent = 0;
+    const int timeout_ms = 100; // polling interval
+
+    struct msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+
+    while(msg.msg_iovlen > 0) {
+        ssize_t bytesSent = ::sendmsg(socket_fd, &msg, flags);
+        if(bytesSent < 0) {
+            if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                if(!waitForEvent(POLLOUT, timeout_ms)) {
+                    throw std::runtime_error("Socket not writable within timeout.");
+                }
+                continue;
+            }
+            else {
+                throw std::runtime_error("sendmsg() error: " + std::string(std::strerror(errno)));
+            }
+        }
+        totalSent += bytesSent;
+
+        // Skip the buffers that were fully written and trim the partially written one
+        size_t remaining = static_cast<size_t>(bytesSent);
+        while(msg.msg_iovlen > 0 && remaining >= msg.msg_iov->iov_len) {
+            remaining -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if(msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = static_cast<char*>(msg.msg_iov->iov_base) + remaining;
+            msg.msg_iov->iov_len -= remaining;
+        }
+    }
+    Metrics::getInstance().increment(Metrics::Counter::BYTES_SENT, totalSent);
     return totalSent;
 }
 
@@ -248,5 +299,6 @@ ssize_t Socket::sendfile(int file_fd, off_t* offset, size_t count) const {
         }
         totalSent += bytesSent;
     }
+    Metrics::getInstance().increment(Metrics::Counter::BYTES_SENDFILE, totalSent);
     return totalSent;
 }
\ No newline at end of file
@@ -0,0 +1,257 @@
+/**
+ * @file sse_broadcaster.cpp
+ * @brief This file contains the definition of the SseBroadcaster class.
+ * @details The broadcaster keeps Server-Sent Events subscribers parked in the EventLoop and
+ * fans every published event out to them. An event is serialized once into a shared buffer
+ * that all subscriber queues point at.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "form_parser.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "sse_broadcaster.hpp"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cerrno>
+#include <utility>
+
+// Constructors //
+
+/**
+ * @brief Constructs a new SseBroadcaster object.
+ * @param eventLoop The event loop that subscribers are parked in.
+ */
+SseBroadcaster::SseBroadcaster(std::shared_ptr<EventLoop> eventLoop) : eventLoop(std::move(eventLoop)) {}
+
+// Functions //
+
+/**
+ * @brief Answers a subscription request and parks the connection in the event loop.
+ * @param socket The client socket, after its GET request was read.
+ * @throws std::system_error if the response head could not be sent.
+ */
+void SseBroadcaster::subscribe(std::unique_ptr<Socket> socket) {
+    socket->send(STREAM_HEADERS.data(), STREAM_HEADERS.size(), MSG_NOSIGNAL);
+    eventLoop->adopt(std::make_unique<Subscriber>(std::move(socket), *this));
+}
+
+/**
+ * @brief Publishes an event to every current subscriber.
+ * @details The event is serialized here, on the caller's thread, and only a reference to it is
+ * handed to the loop thread.
+ * @param event The event type, or empty for the default `message` type.
+ * @param data The event data; each line becomes a `data:` field.
+ * @return The id assigned to the event.
+ */
+uint64_t SseBroadcaster::publish(std::string_view event, std::string_view data) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    uint64_t id = ++nextId;
+    auto payload = std::make_shared<const std::string>(serialize(id, event, data));
+    Metrics::getInstance().increment(Metrics::Counter::SSE_EVENTS_PUBLISHED);
+
+    eventLoop->post([this, payload] {
+        for(Subscriber* subscriber : subscribers) subscriber->enqueue(payload);
+    });
+    return id;
+}
+
+/**
+ * @brief Serializes an event in the `text/event-stream` format.
+ * @param id The event id.
+ * @param event The event type, which must not contain line breaks.
+ * @param data The event data; CR, LF and CRLF all end a line.
+ * @return The serialized event, ending with the blank line that dispatches it.
+ */
+std::string SseBroadcaster::serialize(uint64_t id, std::string_view event, std::string_view data) {
+    std::string out;
+    out.reserve(data.size() + event.size() + 32);
+    out.append("id: ").append(std::to_string(id)).push_back('\n');
+    if(!event.empty()) out.append("event: ").append(event).push_back('\n');
+
+    size_t start = 0;
+    while(true) {
+        size_t end = data.find_first_of("\r\n", start);
+        out.append("data: ").append(data.substr(start, end - start)).push_back('\n');
+        if(end == std::string_view::npos) break;
+        start = end + ((data[end] == '\r' && end + 1 < data.size() && data[end + 1] == '\n') ? 2 : 1);
+    }
+    out.push_back('\n');
+    return out;
+}
+
+// Subscriber //
+
+/**
+ * @brief Constructs a new Subscriber object.
+ * @param socket The client socket, after the stream headers were sent.
+ * @param broadcaster The broadcaster that lists this subscriber once it is adopted.
+ */
+SseBroadcaster::Subscriber::Subscriber(std::unique_ptr<Socket> socket, SseBroadcaster& broadcaster)
+    : socket(std::move(socket)), broadcaster(broadcaster), lastProgress(std::chrono::steady_clock::now()) {
+    Metrics::getInstance().adjust(Metrics::Gauge::SSE_SUBSCRIBERS, 1);
+}
+
+/**
+ * @brief Destroys the Subscriber object, closing its socket.
+ */
+SseBroadcaster::Subscriber::~Subscriber() {
+    if(registered) broadcaster.subscribers.erase(this);
+    Metrics::getInstance().adjust(Metrics::Gauge::SSE_SUBSCRIBERS, -1);
+}
+
+/**
+ * @brief Lists the subscriber for broadcasts, on the loop thread.
+ */
+void SseBroadcaster::Subscriber::onAdopted() {
+    broadcaster.subscribers.insert(this);
+    registered = true;
+}
+
+/**
+ * @brief Queues a shared payload and writes what the socket takes.
+ * @details When the queue is full the oldest events that have not started sending are dropped;
+ * clients see the gap in the event ids.
+ * @param payload The serialized event.
+ */
+void SseBroadcaster::Subscriber::enqueue(const std::shared_ptr<const std::string>& payload) {
+    if(failed) return;
+
+    size_t keep = (headOffset > 0) ? 1 : 0; // A partly sent event must finish or the stream is corrupt
+    while(queue.size() > keep && queuedBytes + payload->size() > MAX_QUEUED_BYTES) {
+        queuedBytes -= queue[keep]->size();
+        queue.erase(queue.begin() + keep);
+        Metrics::getInstance().increment(Metrics::Counter::SSE_EVENTS_DROPPED);
+    }
+
+    if(queue.empty()) lastProgress = std::chrono::steady_clock::now(); // Stall time counts from the first unsent byte
+    queue.push_back(payload);
+    queuedBytes += payload->size();
+    if(!flush()) failed = true;
+}
+
+/**
+ * @brief Discards anything the client sends; a closed socket ends the subscription.
+ * @param buffer The loop's scratch buffer.
+ * @param size The size of `buffer`.
+ * @return `false` once the client has gone.
+ */
+bool SseBroadcaster::Subscriber::onReadable(char* buffer, size_t size) {
+    ssize_t bytesRead = socket->recv(buffer, size, 0);
+    return bytesRead != 0;
+}
+
+/**
+ * @brief Sends queued events once the socket is writable again.
+ * @return `false` if the connection failed.
+ */
+bool SseBroadcaster::Subscriber::onWritable() {
+    return !failed && flush();
+}
+
+/**
+ * @brief Sends a heartbeat comment on an idle stream and drops a stream that stopped draining.
+ * @param now The current time.
+ * @return `false` to close the connection.
+ */
+bool SseBroadcaster::Subscriber::onTick(std::chrono::steady_clock::time_point now) {
+    static const auto HEARTBEAT = std::make_shared<const std::string>(":\n\n");
+
+    if(failed) return false;
+    if(!queue.empty()) {
+        if(now - lastProgress < STALL_TIMEOUT) return true;
+        Logger::getInstance().log("Dropping SSE subscriber that stopped reading.", Logger::LogLevel::WARN);
+        return false;
+    }
+    if(now - lastProgress >= HEARTBEAT_INTERVAL) enqueue(HEARTBEAT);
+    return !failed;
+}
+
+/**
+ * @brief Writes as many queued events as the socket takes without blocking.
+ * @return `false` if the connection failed.
+ */
+bool SseBroadcaster::Subscriber::flush() {
+    while(!queue.empty()) {
+        struct iovec iov[MAX_IOVECS];
+        int count = 0;
+        for(size_t i = 0; i < queue.size() && count < static_cast<int>(MAX_IOVECS); ++i, ++count) {
+            size_t offset = (i == 0) ? headOffset : 0;
+            iov[count].iov_base = const_cast<char*>(queue[i]->data() + offset);
+            iov[count].iov_len = queue[i]->size() - offset;
+        }
+
+        struct msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<size_t>(count);
+        ssize_t bytesSent = ::sendmsg(socket->get(), &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if(bytesSent < 0) {
+            if(errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK; // Otherwise the client has gone
+        }
+
+        Metrics::getInstance().increment(Metrics::Counter::BYTES_SENT, static_cast<uint64_t>(bytesSent));
+        lastProgress = std::chrono::steady_clock::now();
+        size_t remaining = static_cast<size_t>(bytesSent);
+        queuedBytes -= remaining;
+        while(remaining > 0) {
+            size_t left = queue.front()->size() - headOffset;
+            if(remaining < left) {
+                headOffset += remaining;
+                break;
+            }
+            remaining -= left;
+            headOffset = 0;
+            queue.pop_front();
+        }
+    }
+    return true;
+}
+
+// SsePublishResponseBuilder //
+
+/**
+ * @brief Constructs a new SsePublishResponseBuilder object.
+ * @param broadcaster The broadcaster to publish to.
+ */
+SsePublishResponseBuilder::SsePublishResponseBuilder(std::shared_ptr<SseBroadcaster> broadcaster)
+    : broadcaster(std::move(broadcaster)) {}
+
+/**
+ * @brief Publishes the request body as an event.
+ * @param request The POST request; its body is the event data.
+ * @return `202 Accepted` with the event id, or an error status.
+ */
+ResponseResult SsePublishResponseBuilder::buildResponse(const HttpRequest& request) const {
+    if(request.getParts() != nullptr) return ResponseResult{ http::status::Code::UNSUPPORTED_MEDIA_TYPE };
+    if(request.getBody().size() > SseBroadcaster::MAX_EVENT_SIZE) return ResponseResult{ http::status::Code::PAYLOAD_TOO_LARGE };
+
+    // The event type comes from the query string, it must stay on one line
+    std::string event;
+    std::string_view uri = request.getURI();
+    if(size_t question = uri.find('?'); question != std::string_view::npos) {
+        FormParser query(request.getResource());
+        auto onField = [&](std::string_view key, std::string_view value) {
+            if(key == "event") event.assign(value);
+        };
+        query.feed(uri.substr(question + 1), onField);
+        query.finish(onField);
+    }
+    if(event.find_first_of("\r\n") != std::string::npos) return ResponseResult{ http::status::Code::BAD_REQUEST };
+
+    uint64_t id = broadcaster->publish(event, request.getBody());
+
+    std::string body = "Published event " + std::to_string(id) + ".\r\n";
+    HttpResponse response(request.getResource());
+    response.setStatus(http::status::Code::ACCEPTED)
+            .setContentLength(body.length())
+            .setHeader("Content-Type", "text/plain")
+            .setBody(std::move(body));
+
+    return ResponseResult{ std::move(response) };
+}
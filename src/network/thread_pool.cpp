@@ -11,6 +11,7 @@
 #include "connection_handler.hpp"
 #include "http_server.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
 #include "thread_pool.hpp"
 
 #include <cassert>
@@ -25,14 +26,29 @@
  * @param numThreads The number of worker threads to create.
  * @param factory The response builder factory.
  * @param composer The response composer.
+ * @param responseCache The serialized response cache.
+ * @param eventLoop The event loop that upgraded connections are handed to.
+ * @param broadcaster The Server-Sent Events broadcaster that subscriptions are handed to.
+ * @param rateLimiter The per-client request rate limiter.
+ * @param queueTarget The queue delay CoDel admission control aims for, or 0 to never shed.
  */
 ThreadPool::ThreadPool(
     size_t numThreads, 
     std::shared_ptr<ResponseBuilderFactory> factory, 
-    std::shared_ptr<ResponseComposer> composer
-) : factory(factory), composer(composer), stop(false) {
+    std::shared_ptr<ResponseComposer> composer,
+    std::shared_ptr<ResponseCache> responseCache,
+    std::shared_ptr<EventLoop> eventLoop,
+    std::shared_ptr<SseBroadcaster> broadcaster,
+    std::shared_ptr<RateLimiter> rateLimiter,
+    std::chrono::milliseconds queueTarget
+) : factory(factory), composer(composer), responseCache(responseCache), eventLoop(eventLoop), broadcaster(broadcaster),
+    rateLimiter(rateLimiter), stop(false), queueTarget(queueTarget) {
     assert(this->factory != nullptr);
     assert(this->composer != nullptr);
+    assert(this->responseCache != nullptr);
+    assert(this->eventLoop != nullptr);
+    assert(this->broadcaster != nullptr);
+    assert(this->rateLimiter != nullptr);
 
     if(numThreads == 0) {
         Logger::getInstance().log("Thread pool inactive; running single-threaded.", Logger::LogLevel::WARN);
@@ -79,16 +95,20 @@ void ThreadPool::shutdown() {
 /**
  * @brief Enqueues a task to be processed by the thread pool.
  * @param client_socket The client socket to process.
+ * @param timer The connection's phase timer (with the accept time already marked).
  */
-void ThreadPool::enqueue(std::unique_ptr<Socket> client_socket) {
+void ThreadPool::enqueue(std::unique_ptr<Socket> client_socket, RequestTimer timer) {
     if(!client_socket) {
         Logger::getInstance().log("Failed to queue task: Client socket is null.", Logger::LogLevel::ERROR);
         return;
     }
 
+    timer.mark(RequestTimer::Phase::ENQUEUED);
+
     // If the thread pool is inactive, process the request immediately
     if(!isActive()) {
-        ConnectionHandler handler(std::move(client_socket), factory, composer);
+        timer.mark(RequestTimer::Phase::DEQUEUED);
+        ConnectionHandler handler(std::move(client_socket), factory, composer, responseCache, eventLoop, broadcaster, rateLimiter, timer);
         handler.processRequests();
         return;
     }
@@ -100,10 +120,20 @@ void ThreadPool::enqueue(std::unique_ptr<Socket> client_socket) {
             Logger::getInstance().log("Stopping queues for new tasks.", Logger::LogLevel::DEBUG);
             return; // Prevent new tasks from being enqueued if shutting down
         }
-        task_queue.push(std::move(client_socket));
 
-        Logger::getInstance().log("Task enqueued.", Logger::LogLevel::DEBUG);
+        // Refuse new work while overloaded and the queue already holds connections waiting past the target
+        bool refuse = queueTarget.count() > 0 && isOverloaded() && !task_queue.empty()
+                   && timer.get(RequestTimer::Phase::ENQUEUED) - task_queue.front().timer.get(RequestTimer::Phase::ENQUEUED) > queueTarget;
+        if(!refuse) {
+            task_queue.push(Task{std::move(client_socket), timer});
+            Logger::getInstance().log("Task enqueued.", Logger::LogLevel::DEBUG);
+        }
     }
+    if(client_socket) {
+        shed(std::move(client_socket));
+        return;
+    }
+    Metrics::getInstance().adjust(Metrics::Gauge::QUEUE_DEPTH, 1);
     cv.notify_one();
 }
 
@@ -113,7 +143,7 @@ void ThreadPool::enqueue(std::unique_ptr<Socket> client_socket) {
  */
 void ThreadPool::workerThread() {
     while(true) {
-        std::unique_ptr<Socket> client_socket;
+        Task task;
         {
             // Wait for a task to be enqueued
             std::unique_lock<std::mutex> lock(queue_mtx);
@@ -123,18 +153,72 @@ void ThreadPool::workerThread() {
             if(stop && task_queue.empty()) return;
 
             // Get the next task
-            client_socket = std::move(task_queue.front());
+            task = std::move(task_queue.front());
             task_queue.pop();
+            task.timer.mark(RequestTimer::Phase::DEQUEUED);
+            auto sojourn = task.timer.get(RequestTimer::Phase::DEQUEUED) - task.timer.get(RequestTimer::Phase::ENQUEUED);
+            if(shouldShed(task.timer.get(RequestTimer::Phase::DEQUEUED), sojourn)) {
+                lock.unlock();
+                Metrics::getInstance().adjust(Metrics::Gauge::QUEUE_DEPTH, -1);
+                shed(std::move(task.client_socket));
+                continue;
+            }
         }
+        Metrics::getInstance().adjust(Metrics::Gauge::QUEUE_DEPTH, -1);
+        Metrics::getInstance().observe(Metrics::Histogram::QUEUE_WAIT,
+            task.timer.get(RequestTimer::Phase::DEQUEUED) - task.timer.get(RequestTimer::Phase::ENQUEUED));
+        std::unique_ptr<Socket> client_socket = std::move(task.client_socket);
 
         // Process the task
         if(client_socket) {
             Logger::getInstance().log("Processing task...", Logger::LogLevel::DEBUG);
-            ConnectionHandler handler(std::move(client_socket), factory, composer);
+            ConnectionHandler handler(std::move(client_socket), factory, composer, responseCache, eventLoop, broadcaster, rateLimiter, task.timer);
             handler.processRequests();
         } 
         else {
             Logger::getInstance().log("Worker thread received null socket.", Logger::LogLevel::ERROR);
         }
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Updates the CoDel state with a dequeued connection's wait, called with the queue lock held.
+ * @details A wait above the target starts the clock; only if every wait stays above it for a
+ * whole interval, without the queue draining, does the pool become overloaded. A wait within
+ * the target or an empty queue resets the clock and ends the overload, so bursts that drain
+ * and single slow dequeues after an idle period never shed.
+ * @param now The time the connection was dequeued.
+ * @param sojourn How long it waited in the queue.
+ * @return `true` if the connection should be shed instead of served.
+ */
+bool ThreadPool::shouldShed(RequestTimer::Clock::time_point now, RequestTimer::Clock::duration sojourn) {
+    if(queueTarget.count() <= 0) return false;
+
+    bool nowOverloaded = isOverloaded();
+    if(sojourn <= queueTarget || task_queue.empty()) {
+        firstAboveTime = RequestTimer::Clock::time_point{};
+        nowOverloaded = false;
+    }
+    else if(firstAboveTime == RequestTimer::Clock::time_point{}) {
+        firstAboveTime = now + CODEL_INTERVAL;
+    }
+    else if(now >= firstAboveTime) {
+        nowOverloaded = true;
+    }
+
+    if(nowOverloaded != isOverloaded()) {
+        overloaded.store(nowOverloaded, std::memory_order_relaxed);
+        Logger::getInstance().log(nowOverloaded ? "Queue delay above target, shedding load." : "Queue delay back under target.",
+                                  Logger::LogLevel::WARN);
+    }
+    return nowOverloaded && sojourn > 2 * queueTarget;
+}
+
+/**
+ * @brief Turns a connection away with a prebuilt `503 Service Unavailable` and closes it.
+ * @param client_socket The connection, closed when this returns.
+ */
+void ThreadPool::shed(std::unique_ptr<Socket> client_socket) {
+    Metrics::getInstance().increment(Metrics::Counter::CONNECTIONS_SHED);
+    ConnectionHandler::reject(*client_socket, *composer, http::status::Code::SERVICE_UNAVAILABLE);
+}
@@ -0,0 +1,552 @@
+/**
+ * @file websocket.cpp
+ * @brief This file contains the definition of the WebSocketConnection class.
+ * @details This class validates the WebSocket opening handshake and then serves the
+ * connection from the EventLoop: it decodes masked frames as they arrive, reassembles
+ * fragmented messages, answers pings and performs the closing handshake.
+ *
+ * @author Noah Nickles
+ * @date 1/30/2025
+ * COP4635 Sys & Net II - Project 1
+ */
+
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "n_utils.hpp"
+#include "websocket.hpp"
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr std::string_view WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+    uint32_t rotateLeft(uint32_t value, int bits) noexcept {
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    /**
+     * @brief Computes the SHA-1 digest the handshake needs. Not for anything security related.
+     */
+    std::array<uint8_t, 20> sha1(std::string_view data) {
+        uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+        std::string padded(data);
+        padded.push_back(static_cast<char>(0x80));
+        while(padded.size() % 64 != 56) padded.push_back('\0');
+        uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+        for(int shift = 56; shift >= 0; shift -= 8) padded.push_back(static_cast<char>(bits >> shift));
+
+        for(size_t chunk = 0; chunk < padded.size(); chunk += 64) {
+            uint32_t w[80];
+            for(int i = 0; i < 16; ++i) {
+                const unsigned char* p = reinterpret_cast<const unsigned char*>(padded.data() + chunk + i * 4);
+                w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+            }
+            for(int i = 16; i < 80; ++i) w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for(int i = 0; i < 80; ++i) {
+                uint32_t f, k;
+                if(i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+                else if(i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+                else if(i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+                else            { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+                uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = rotateLeft(b, 30);
+                b = a;
+                a = temp;
+            }
+            h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+        }
+
+        std::array<uint8_t, 20> digest;
+        for(int i = 0; i < 20; ++i) digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - (i % 4) * 8));
+        return digest;
+    }
+
+    std::string base64Encode(const uint8_t* data, size_t size) {
+        static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        out.reserve((size + 2) / 3 * 4);
+        for(size_t i = 0; i < size; i += 3) {
+            uint32_t group = uint32_t(data[i]) << 16;
+            if(i + 1 < size) group |= uint32_t(data[i + 1]) << 8;
+            if(i + 2 < size) group |= uint32_t(data[i + 2]);
+            out.push_back(ALPHABET[(group >> 18) & 0x3F]);
+            out.push_back(ALPHABET[(group >> 12) & 0x3F]);
+            out.push_back(i + 1 < size ? ALPHABET[(group >> 6) & 0x3F] : '=');
+            out.push_back(i + 2 < size ? ALPHABET[group & 0x3F] : '=');
+        }
+        return out;
+    }
+
+    bool isControl(WebSocketConnection::Opcode opcode) noexcept {
+        return (static_cast<uint8_t>(opcode) & 0x8) != 0;
+    }
+}
+
+// Constructors //
+
+/**
+ * @brief Constructs a new WebSocketConnection object.
+ * @param socket The client socket, after the 101 response was sent.
+ */
+WebSocketConnection::WebSocketConnection(std::unique_ptr<Socket> socket)
+    : socket(std::move(socket)), lastActivity(std::chrono::steady_clock::now()) {
+    Metrics::getInstance().adjust(Metrics::Gauge::WEBSOCKET_CONNECTIONS, 1);
+}
+
+/**
+ * @brief Destroys the WebSocketConnection object, closing its socket.
+ */
+WebSocketConnection::~WebSocketConnection() {
+    Metrics::getInstance().adjust(Metrics::Gauge::WEBSOCKET_CONNECTIONS, -1);
+}
+
+// Handshake //
+
+/**
+ * @brief Checks whether a request asks to upgrade to the WebSocket protocol.
+ * @param request The parsed HTTP/1.1 request.
+ * @return `true` if the Upgrade header names `websocket`.
+ */
+bool WebSocketConnection::isUpgradeRequest(const HttpRequest& request) {
+    auto upgrade = request.getHeader("Upgrade");
+    return upgrade && n_utils::str_manip::hasToken(*upgrade, "websocket");
+}
+
+/**
+ * @brief Validates an opening handshake and builds the server's response to it.
+ * @param request The upgrade request.
+ * @return The complete 101 response, or `std::nullopt` if the handshake is invalid.
+ */
+std::optional<std::string> WebSocketConnection::acceptHandshake(const HttpRequest& request) {
+    auto connection = request.getHeader("Connection");
+    auto version = request.getHeader("Sec-WebSocket-Version");
+    auto key = request.getHeader("Sec-WebSocket-Key");
+    if(request.getMethod() != "GET" || !connection || !n_utils::str_manip::hasToken(*connection, "upgrade")) return std::nullopt;
+    if(!version || *version != "13") return std::nullopt;
+    if(!key || key->size() != 24 || key->substr(22) != "==") return std::nullopt; // 16 random bytes in base64
+
+    std::string response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: ";
+    response.append(acceptKey(*key)).append("\r\n\r\n");
+    return response;
+}
+
+/**
+ * @brief Computes the Sec-WebSocket-Accept value for a client key.
+ * @param key The Sec-WebSocket-Key header value.
+ * @return base64(SHA-1(key + GUID)).
+ */
+std::string WebSocketConnection::acceptKey(std::string_view key) {
+    std::string input(key);
+    input.append(WEBSOCKET_GUID);
+    std::array<uint8_t, 20> digest = sha1(input);
+    return base64Encode(digest.data(), digest.size());
+}
+
+// Framing //
+
+/**
+ * @brief Unmasks payload bytes in place.
+ * @details XORs 16 bytes at a time with SSE2 when available, then 8 at a time. The key is
+ * rotated once up front so every wide step starts on a key boundary.
+ * @param data The masked bytes.
+ * @param length The number of bytes.
+ * @param mask The frame's masking key.
+ * @param offset The position of `data[0]` in the frame payload.
+ */
+void WebSocketConnection::unmask(char* data, size_t length, const std::array<uint8_t, 4>& mask, size_t offset) noexcept {
+    uint8_t rotated[4] = {mask[offset & 3], mask[(offset + 1) & 3], mask[(offset + 2) & 3], mask[(offset + 3) & 3]};
+    uint32_t word;
+    std::memcpy(&word, rotated, sizeof(word));
+
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i key = _mm_set1_epi32(static_cast<int>(word));
+    for(; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(chunk, key));
+    }
+#endif
+    const uint64_t wide = (static_cast<uint64_t>(word) << 32) | word;
+    for(; i + 8 <= length; i += 8) {
+        uint64_t chunk;
+        std::memcpy(&chunk, data + i, sizeof(chunk));
+        chunk ^= wide;
+        std::memcpy(data + i, &chunk, sizeof(chunk));
+    }
+    for(; i < length; ++i) data[i] = static_cast<char>(data[i] ^ rotated[i & 3]);
+}
+
+/**
+ * @brief Validates UTF-8, rejecting overlong forms, surrogates and code points past U+10FFFF.
+ * @details Skips 8 ASCII bytes at a time.
+ * @param str The bytes to check.
+ * @return `true` if `str` is valid UTF-8.
+ */
+bool WebSocketConnection::isValidUtf8(std::string_view str) noexcept {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(str.data());
+    size_t size = str.size();
+    size_t i = 0;
+
+    while(i < size) {
+        if(i + 8 <= size) {
+            uint64_t chunk;
+            std::memcpy(&chunk, s + i, sizeof(chunk));
+            if((chunk & 0x8080808080808080ULL) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+
+        unsigned char c = s[i];
+        if(c < 0x80) {
+            ++i;
+            continue;
+        }
+
+        size_t length;
+        uint32_t codePoint;
+        if((c & 0xE0) == 0xC0)      { length = 2; codePoint = c & 0x1F; }
+        else if((c & 0xF0) == 0xE0) { length = 3; codePoint = c & 0x0F; }
+        else if((c & 0xF8) == 0xF0) { length = 4; codePoint = c & 0x07; }
+        else return false;
+        if(i + length > size) return false;
+
+        for(size_t k = 1; k < length; ++k) {
+            if((s[i + k] & 0xC0) != 0x80) return false;
+            codePoint = (codePoint << 6) | (s[i + k] & 0x3F);
+        }
+        if((length == 2 && codePoint < 0x80) || (length == 3 && codePoint < 0x800) ||
+           (length == 4 && (codePoint < 0x10000 || codePoint > 0x10FFFF)) ||
+           (codePoint >= 0xD800 && codePoint <= 0xDFFF)) return false;
+        i += length;
+    }
+    return true;
+}
+
+// EventLoop::Connection //
+
+/**
+ * @brief Reads and processes what the client sent.
+ * @param buffer The loop's scratch buffer; frames are unmasked in place.
+ * @param size The size of `buffer`.
+ * @return `false` once the connection is finished.
+ */
+bool WebSocketConnection::onReadable(char* buffer, size_t size) {
+    ssize_t bytesRead = socket->recv(buffer, size, 0);
+    if(bytesRead == 0) return false; // Closed without a closing handshake
+    if(bytesRead < 0) return true;   // Spurious wakeup
+
+    lastActivity = std::chrono::steady_clock::now();
+    pingSent = false;
+
+    bool ok = consume(buffer, static_cast<size_t>(bytesRead));
+    if(output.size() > MAX_OUTPUT_SIZE) {
+        Logger::getInstance().log("Dropping WebSocket client that stopped reading.", Logger::LogLevel::WARN);
+        return false;
+    }
+    if(!flush()) return false;
+    if(!ok && !closeSent) return false;
+    return !(closeSent && output.empty()); // The server closes the TCP connection after its Close frame
+}
+
+/**
+ * @brief Sends output that did not fit into the socket earlier.
+ * @return `false` once the connection is finished.
+ */
+bool WebSocketConnection::onWritable() {
+    if(!flush()) return false;
+    return !(closeSent && output.empty());
+}
+
+/**
+ * @brief Pings a silent client and drops one that stays silent.
+ * @param now The current time.
+ * @return `false` if the client timed out.
+ */
+bool WebSocketConnection::onTick(std::chrono::steady_clock::time_point now) {
+    if(now - lastActivity >= IDLE_TIMEOUT) {
+        Logger::getInstance().log("WebSocket client timed out.", Logger::LogLevel::DEBUG);
+        return false;
+    }
+    if(!pingSent && now - lastActivity >= PING_INTERVAL) {
+        queueFrame(Opcode::PING, {});
+        pingSent = true;
+        if(!flush()) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Tells the client the server is going away.
+ */
+void WebSocketConnection::onShutdown() noexcept {
+    try {
+        queueClose(CloseCode::GOING_AWAY);
+        flush();
+    }
+    catch(const std::exception& e) {
+        // The connection closes either way
+    }
+}
+
+// Functions //
+
+/**
+ * @brief Parses frames out of newly received bytes.
+ * @details Payload bytes are unmasked where they lie in `data` and appended to the message
+ * (or control payload); a frame never has to be complete in one read.
+ * @param data The received bytes, modified in place.
+ * @param size The number of bytes.
+ * @return `false` if the connection is closing.
+ */
+bool WebSocketConnection::consume(char* data, size_t size) {
+    while(!closeSent) {
+        if(!inPayload) {
+            size_t taken = takeHeader(data, size);
+            data += taken;
+            size -= taken;
+            if(headerSize < 2 || headerSize != headerLength()) return true; // Wait for the rest of the header
+            if(!startFrame()) return false;
+        }
+
+        size_t length = static_cast<size_t>(std::min<uint64_t>(frame.remaining, size));
+        unmask(data, length, frame.mask, frame.processed);
+        (isControl(frame.opcode) ? control : message).append(data, length);
+        frame.remaining -= length;
+        frame.processed += length;
+        data += length;
+        size -= length;
+        if(frame.remaining > 0) return true;
+
+        inPayload = false;
+        headerSize = 0;
+        if(!finishFrame()) return false;
+        if(size == 0) return true;
+    }
+    return true;
+}
+
+/**
+ * @brief Computes the length of the frame header being received.
+ * @return The header length implied by its first two bytes; `headerSize` must be at least 2.
+ */
+size_t WebSocketConnection::headerLength() const noexcept {
+    uint8_t lengthCode = header[1] & 0x7F;
+    size_t extended = (lengthCode == 126) ? 2 : (lengthCode == 127) ? 8 : 0;
+    return 2 + extended + ((header[1] & 0x80) ? 4 : 0);
+}
+
+/**
+ * @brief Copies frame header bytes until the header is complete.
+ * @param data The received bytes.
+ * @param size The number of bytes.
+ * @return The number of bytes taken.
+ */
+size_t WebSocketConnection::takeHeader(const char* data, size_t size) {
+    size_t taken = 0;
+    while(taken < size && (headerSize < 2 || headerSize < headerLength())) {
+        header[headerSize++] = static_cast<uint8_t>(data[taken++]);
+    }
+    return taken;
+}
+
+/**
+ * @brief Validates a complete frame header and prepares for its payload.
+ * @return `false` if the frame breaks the protocol; a Close frame is queued.
+ */
+bool WebSocketConnection::startFrame() {
+    bool fin = (header[0] & 0x80) != 0;
+    bool reserved = (header[0] & 0x70) != 0; // No extensions were negotiated
+    Opcode opcode = static_cast<Opcode>(header[0] & 0x0F);
+    bool masked = (header[1] & 0x80) != 0;
+
+    uint64_t length = header[1] & 0x7F;
+    size_t pos = 2;
+    if(length == 126) {
+        length = (uint64_t(header[2]) << 8) | header[3];
+        pos = 4;
+    }
+    else if(length == 127) {
+        length = 0;
+        for(size_t i = 2; i < 10; ++i) length = (length << 8) | header[i];
+        pos = 10;
+    }
+
+    bool knownOpcode = opcode == Opcode::CONTINUATION || opcode == Opcode::TEXT || opcode == Opcode::BINARY ||
+                       opcode == Opcode::CLOSE || opcode == Opcode::PING || opcode == Opcode::PONG;
+    if(reserved || !masked || !knownOpcode) { // Clients must mask every frame
+        queueClose(CloseCode::PROTOCOL_ERROR);
+        return false;
+    }
+
+    if(isControl(opcode)) {
+        if(!fin || length > MAX_CONTROL_PAYLOAD) {
+            queueClose(CloseCode::PROTOCOL_ERROR);
+            return false;
+        }
+        control.clear();
+    }
+    else {
+        // A continuation needs a message to continue, a new message needs the last one finished
+        if((opcode == Opcode::CONTINUATION) != inMessage) {
+            queueClose(CloseCode::PROTOCOL_ERROR);
+            return false;
+        }
+        if(length > MAX_MESSAGE_SIZE - message.size()) {
+            queueClose(CloseCode::MESSAGE_TOO_BIG);
+            return false;
+        }
+        if(opcode != Opcode::CONTINUATION) {
+            messageOpcode = opcode;
+            inMessage = true;
+        }
+        message.reserve(message.size() + static_cast<size_t>(length));
+    }
+
+    frame.fin = fin;
+    frame.opcode = opcode;
+    std::copy(header.begin() + pos, header.begin() + pos + 4, frame.mask.begin());
+    frame.remaining = length;
+    frame.processed = 0;
+    inPayload = true;
+    return true;
+}
+
+/**
+ * @brief Acts on a frame whose payload is complete.
+ * @return `false` if the connection is closing.
+ */
+bool WebSocketConnection::finishFrame() {
+    switch(frame.opcode) {
+        case Opcode::PING:
+            queueFrame(Opcode::PONG, control);
+            return true;
+        case Opcode::PONG:
+            return true; // Receiving it already counted as activity
+        case Opcode::CLOSE: {
+            if(control.size() == 1) {
+                queueClose(CloseCode::PROTOCOL_ERROR);
+                return false;
+            }
+            if(control.empty()) {
+                queueFrame(Opcode::CLOSE, {});
+                closeSent = true;
+                return false;
+            }
+            uint16_t code = static_cast<uint16_t>((static_cast<uint8_t>(control[0]) << 8) | static_cast<uint8_t>(control[1]));
+            bool validCode = (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1011) || (code >= 3000 && code <= 4999);
+            if(!validCode) {
+                queueClose(CloseCode::PROTOCOL_ERROR);
+                return false;
+            }
+            if(!isValidUtf8(std::string_view(control).substr(2))) {
+                queueClose(CloseCode::INVALID_PAYLOAD);
+                return false;
+            }
+            queueFrame(Opcode::CLOSE, std::string_view(control).substr(0, 2)); // Echo the status code
+            closeSent = true;
+            return false;
+        }
+        default:
+            break;
+    }
+
+    if(!frame.fin) return true; // More fragments follow
+    inMessage = false;
+    if(messageOpcode == Opcode::TEXT && !isValidUtf8(message)) {
+        queueClose(CloseCode::INVALID_PAYLOAD);
+        return false;
+    }
+
+    onMessage(messageOpcode, message);
+    message.clear();
+    if(message.capacity() > RETAINED_CAPACITY) std::string().swap(message);
+    return true;
+}
+
+/**
+ * @brief Handles a complete message by echoing it back.
+ * @param opcode `TEXT` or `BINARY`.
+ * @param payload The reassembled message.
+ */
+void WebSocketConnection::onMessage(Opcode opcode, std::string_view payload) {
+    Metrics::getInstance().increment(Metrics::Counter::WEBSOCKET_MESSAGES);
+    queueFrame(opcode, payload);
+}
+
+// Output //
+
+/**
+ * @brief Queues an unmasked, unfragmented frame.
+ * @param opcode The frame type.
+ * @param payload The payload.
+ */
+void WebSocketConnection::queueFrame(Opcode opcode, std::string_view payload) {
+    char frameHeader[10];
+    size_t headerLength = 2;
+    frameHeader[0] = static_cast<char>(0x80 | static_cast<uint8_t>(opcode));
+    if(payload.size() < 126) {
+        frameHeader[1] = static_cast<char>(payload.size());
+    }
+    else if(payload.size() <= 0xFFFF) {
+        frameHeader[1] = 126;
+        frameHeader[2] = static_cast<char>(payload.size() >> 8);
+        frameHeader[3] = static_cast<char>(payload.size());
+        headerLength = 4;
+    }
+    else {
+        frameHeader[1] = 127;
+        for(int i = 0; i < 8; ++i) frameHeader[2 + i] = static_cast<char>(static_cast<uint64_t>(payload.size()) >> (56 - i * 8));
+        headerLength = 10;
+    }
+    output.append(frameHeader, headerLength);
+    output.append(payload);
+}
+
+/**
+ * @brief Queues a Close frame once; the connection ends when it has been sent.
+ * @param code The status code.
+ */
+void WebSocketConnection::queueClose(CloseCode code) {
+    if(closeSent) return;
+    uint16_t value = static_cast<uint16_t>(code);
+    char payload[2] = {static_cast<char>(value >> 8), static_cast<char>(value)};
+    queueFrame(Opcode::CLOSE, std::string_view(payload, sizeof(payload)));
+    closeSent = true;
+}
+
+/**
+ * @brief Writes as much queued output as the socket takes without blocking.
+ * @return `false` if the connection failed.
+ */
+bool WebSocketConnection::flush() {
+    size_t sent = 0;
+    while(sent < output.size()) {
+        ssize_t bytesSent = ::send(socket->get(), output.data() + sent, output.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if(bytesSent < 0) {
+            if(errno == EINTR) continue;
+            if(errno == EAGAIN || errno == EWOULDBLOCK) break; // The loop calls onWritable later
+            return false;
+        }
+        sent += static_cast<size_t>(bytesSent);
+    }
+    Metrics::getInstance().increment(Metrics::Counter::BYTES_SENT, sent);
+
+    output.erase(0, sent);
+    if(output.empty() && output.capacity() > RETAINED_CAPACITY) std::string().swap(output);
+    return true;
+}